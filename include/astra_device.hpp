@@ -4,10 +4,14 @@
 #pragma once
 
 #include <memory>
+#include <chrono>
 #include <cstdint>
 #include <functional>
+#include <type_traits>
+#include <vector>
 
 #include "flash_image.hpp"
+#include "astra_names.hpp"
 
 enum AstraDeviceStatus {
     ASTRA_DEVICE_STATUS_ADDED,
@@ -25,44 +29,192 @@ enum AstraDeviceStatus {
     ASTRA_DEVICE_STATUS_IMAGE_SEND_PROGRESS,
     ASTRA_DEVICE_STATUS_IMAGE_SEND_COMPLETE,
     ASTRA_DEVICE_STATUS_IMAGE_SEND_FAIL,
+    ASTRA_DEVICE_STATUS_VERIFY_START,
+    ASTRA_DEVICE_STATUS_VERIFY_COMPLETE,
+    ASTRA_DEVICE_STATUS_VERIFY_FAIL,
+};
+
+// Reason attached to a status event. Details such as the image or partition are
+// carried by the event's image id, and the full text goes to the session log.
+enum AstraDeviceMessage {
+    ASTRA_DEVICE_MESSAGE_NONE,
+    ASTRA_DEVICE_MESSAGE_SUCCESS,
+    ASTRA_DEVICE_MESSAGE_DEVICE_DISCONNECTED,
+    ASTRA_DEVICE_MESSAGE_BOOT_FAILED,
+    ASTRA_DEVICE_MESSAGE_REATTACH_OPEN_FAILED,
+    ASTRA_DEVICE_MESSAGE_REATTACH_WRONG_DEVICE,
+    ASTRA_DEVICE_MESSAGE_REATTACH_START_FAILED,
+    ASTRA_DEVICE_MESSAGE_REATTACH_TIMEOUT,
+    ASTRA_DEVICE_MESSAGE_BOOT_TIMEOUT,
+    ASTRA_DEVICE_MESSAGE_BOOT_REQUEST_TIMEOUT,
+    ASTRA_DEVICE_MESSAGE_UPDATE_TIMEOUT,
+    ASTRA_DEVICE_MESSAGE_TRANSFER_STALLED,
+    ASTRA_DEVICE_MESSAGE_FLASH_TARGET_FAILED,
+    ASTRA_DEVICE_MESSAGE_FLASH_COMMAND_TIMEOUT,
+    ASTRA_DEVICE_MESSAGE_IMAGE_NOT_FOUND,
+    ASTRA_DEVICE_MESSAGE_BUFFER_ALLOCATION_FAILED,
+    ASTRA_DEVICE_MESSAGE_IMAGE_TOO_LARGE,
+    ASTRA_DEVICE_MESSAGE_WRITE_FAILED,
+    ASTRA_DEVICE_MESSAGE_READ_IMAGE_FAILED,
+    ASTRA_DEVICE_MESSAGE_INCOMPLETE_TRANSFER,
+    ASTRA_DEVICE_MESSAGE_SEND_FAILED,
+    ASTRA_DEVICE_MESSAGE_CONSOLE_UPDATE_FAILED,
+    ASTRA_DEVICE_MESSAGE_VERIFY_READ_FAILED,
+    ASTRA_DEVICE_MESSAGE_CRC_MISMATCH,
+    ASTRA_DEVICE_MESSAGE_VERIFY_FAILED,
+    ASTRA_DEVICE_MESSAGE_FASTBOOT_TIMEOUT,
+    ASTRA_DEVICE_MESSAGE_FASTBOOT_OPEN_FAILED,
+    ASTRA_DEVICE_MESSAGE_SPARSE_IMAGE_FAILED,
+    ASTRA_DEVICE_MESSAGE_DOWNLOAD_FAILED,
+    ASTRA_DEVICE_MESSAGE_FLASH_FAILED,
+};
+
+struct AstraDeviceTransition {
+    AstraDeviceStatus m_from;
+    AstraDeviceStatus m_to;
+    std::chrono::steady_clock::time_point m_time;
+};
+
+// Point in time view of a session's transfer counters, polled by UIs
+struct AstraDeviceProgress {
+    AstraNameId m_deviceId;
+    AstraDeviceStatus m_status;
+    AstraNameId m_imageId;
+    double m_progress;
+    uint64_t m_imageBytesSent;
+    uint64_t m_imageSize;
+    uint64_t m_totalBytesSent;
+    uint32_t m_imagesSent;
+};
+
+// Compact record of a finished session, kept after the session is destroyed
+struct AstraSessionSummary {
+    AstraNameId m_deviceId;
+    // Final status, such as ASTRA_DEVICE_STATUS_UPDATE_COMPLETE or a failure
+    AstraDeviceStatus m_status;
+    uint64_t m_totalBytesSent;
+    uint32_t m_imagesSent;
+    uint32_t m_retries;
+    std::chrono::system_clock::time_point m_finishTime;
+    // From the session's first state transition to its last
+    std::chrono::steady_clock::duration m_duration;
+};
+
+// Allocation counters of the pool holding a session's image table
+struct AstraDeviceMemoryStats {
+    uint64_t m_allocations;
+    uint64_t m_deallocations;
+    uint64_t m_bytesInUse;
+    uint64_t m_peakBytesInUse;
+    uint64_t m_releases;
+};
+
+// Image block write retries of a session
+struct AstraDeviceRetryStats {
+    uint32_t m_retries;
+    uint32_t m_recoveredBlocks;
+    uint32_t m_failedBlocks;
+};
+
+// Watchdog timeouts of a session. A timeout of zero disables that watchdog.
+struct AstraDeviceTimeouts {
+    // Whole boot, from the first image request until the final boot image is sent
+    std::chrono::seconds m_boot{300};
+    // Whole update, from the end of the boot until the update completes
+    std::chrono::seconds m_update{3600};
+    // Between image requests during boot
+    std::chrono::seconds m_bootRequest{10};
+    // Without any data acknowledged while an image is being sent
+    std::chrono::seconds m_stall{30};
+    // For the device to reconnect after the miniloader
+    std::chrono::seconds m_reattach{10};
+    // From the end of the boot, includes the time for U-Boot to start and run the fastboot command
+    std::chrono::seconds m_fastbootAttach{120};
+    // From the end of the boot, includes the time for U-Boot to start when the flash command runs from uEnv.txt
+    std::chrono::seconds m_flashCommand{180};
 };
 
 class USBDevice;
+class AstraReactor;
+class USBTopology;
 class AstraBootImage;
 class AstraDeviceManagerResponse;
 
 class AstraDevice
 {
 public:
-    AstraDevice(std::unique_ptr<USBDevice> device, const std::string &tempDir, bool bootOnly, const std::string &bootCommand);
+    AstraDevice(std::unique_ptr<USBDevice> device, AstraReactor &reactor, USBTopology &topology, const std::string &tempDir,
+        bool bootOnly, const std::string &bootCommand);
     ~AstraDevice();
 
     void SetStatusCallback(std::function<void(AstraDeviceManagerResponse)> statusCallback);
+    // Called once from the reactor when the session has finished
+    void SetCompletionCallback(std::function<void(AstraDeviceStatus)> completionCallback);
+    // Must be called before Boot
+    void SetTimeouts(const AstraDeviceTimeouts &timeouts);
 
+    // Boot and Update start the session and return. The session then runs on the
+    // reactor, driven by USB events, console prompts and timers.
     int Boot(std::shared_ptr<AstraBootImage> bootImages);
     int Update(std::shared_ptr<FlashImage> flashImage);
+    // Flash the targets in order without leaving U-Boot. The flash command of each
+    // target is sent once the previous one has returned to the prompt, and only
+    // the last target resets the device. Requires a boot image with a USB console
+    // when there is more than one target.
+    int Update(std::vector<std::shared_ptr<FlashImage>> flashImages);
     int WaitForCompletion();
+    // Returns -1 if the session has not finished within timeout
+    int WaitForCompletion(std::chrono::milliseconds timeout);
+
+    // Take ownership of a fastboot device if this device is waiting for one on the same port
+    bool AttachFastbootDevice(std::unique_ptr<USBDevice> &device);
+    // Take ownership of a device which re-enumerated on the same port during boot and
+    // resume the boot sequence with it
+    bool AttachDevice(std::unique_ptr<USBDevice> &device);
+    // Tell the session a device was unplugged. Returns true if it was the session's
+    // device, in which case the session handles it as a disconnect right away
+    // rather than waiting for a transfer to fail or a watchdog to expire.
+    bool DeviceRemoved(const USBDevice &device);
 
     int SendToConsole(const std::string &data);
     int ReceiveFromConsole(std::string &data);
 
     std::string GetDeviceName();
+    AstraNameId GetDeviceId();
     AstraDeviceStatus GetDeviceStatus();
+    // Timestamped state transitions of this session, oldest first
+    std::vector<AstraDeviceTransition> GetStatusTrace();
+    AstraDeviceProgress GetProgress();
+    AstraDeviceMemoryStats GetMemoryStats();
+    AstraDeviceRetryStats GetRetryStats();
 
     void Close();
+    // Called after Close(). Calls retired from the reactor once no task, timer or
+    // job of the session can run any more, after which it may be destroyed.
+    // removeFiles deletes the session's directory in the temp directory.
+    void Retire(bool removeFiles, std::function<void()> retired);
 
     static const std::string AstraDeviceStatusToString(AstraDeviceStatus status);
+    static const std::string &AstraDeviceMessageToString(AstraDeviceMessage message);
 
 private:
     class AstraDeviceImpl;
     std::unique_ptr<AstraDeviceImpl> pImpl;
 };
 
+// Names are interned and messages are fixed ids, so responses can be copied and
+// queued without allocating
 struct DeviceResponse
 {
-    std::string m_deviceName;
+    AstraNameId m_deviceId;
     AstraDeviceStatus m_status;
     double m_progress;
-    std::string m_imageName;
-    std::string m_message;
+    AstraNameId m_imageId;
+    AstraDeviceMessage m_message;
+
+    const std::string &GetDeviceName() const { return AstraNames::Lookup(m_deviceId); }
+    const std::string &GetImageName() const { return AstraNames::Lookup(m_imageId); }
+    const std::string &GetMessage() const { return AstraDevice::AstraDeviceMessageToString(m_message); }
 };
+
+static_assert(std::is_trivially_copyable<DeviceResponse>::value, "DeviceResponse must stay a POD event");
@@ -3,10 +3,12 @@
 
 #pragma once
 
+#include <map>
 #include <string>
 #include <memory>
 #include <functional>
 #include <variant>
+#include <vector>
 
 #include "astra_device.hpp"
 #include "flash_image.hpp"
@@ -37,10 +39,38 @@ public:
     );
     ~AstraDeviceManager();
 
+    // Applied to sessions started after the call, so set them before Update or Boot
+    void SetDeviceTimeouts(const AstraDeviceTimeouts &timeouts);
+    // Limit the number of sessions booting or updating at once. Further devices stay
+    // attached and wait in arrival order for a session to finish. 0 removes the limit.
+    void SetMaxActiveSessions(size_t maxActiveSessions);
+    // Adjust the number of active sessions from the measured throughput, up to
+    // the maximum set with SetMaxActiveSessions. Must be called before Update or Boot.
+    void SetAdaptiveConcurrency(bool enable);
+    // Bulk bandwidth in bytes per second shared by the devices behind each external
+    // USB hub. Devices on different root ports are not limited. 0 disables the limit.
+    void SetHubBandwidth(uint64_t bytesPerSecond);
+    // Keep the summaries of the last capacity finished sessions. Older summaries are
+    // appended to spillPath, if it is not empty. Returns -1 if it can not be opened.
+    int SetSessionHistory(size_t capacity, const std::string &spillPath = "");
     void Update(std::shared_ptr<FlashImage> flashImage, std::string bootImagePath);
+    // Serve several chips from one manager. Each arriving device is booted and updated
+    // with the image whose boot image matches its VID:PID. Several images for the same
+    // VID:PID, for example SPI U-Boot and eMMC, are flashed in the order given in one
+    // U-Boot session and only the last one resets the device.
+    void Update(std::vector<std::shared_ptr<FlashImage>> flashImages, std::string bootImagePath);
+    // Flash the boards on a station with the jobs a station plan assigns to their USB
+    // port paths or serial numbers. config applies to every job, with the keys in a
+    // job's config taking precedence. Throws if the plan or one of its images is invalid.
+    void UpdateStation(std::string stationPlanPath, std::string bootImagePath,
+        std::map<std::string, std::string> config = {});
     void Boot(std::string bootImagesPath, std::string bootCommand = "");
     bool Shutdown();
     std::string GetLogFile() const;
+    // Transfer progress of every session. Cheap enough to poll from a UI refresh loop.
+    std::vector<AstraDeviceProgress> GetProgressSnapshot();
+    // Summaries of the most recent finished sessions, oldest first
+    std::vector<AstraSessionSummary> GetSessionHistory();
 
     static std::string GetVersion() {
         return ASTRA_DEVICE_MANAGER_VERSION;
@@ -53,7 +83,9 @@ private:
 
 struct ManagerResponse {
     AstraDeviceManagerStatus m_managerStatus;
-    std::string m_managerMessage;
+    AstraNameId m_managerMessageId;
+
+    const std::string &GetMessage() const { return AstraNames::Lookup(m_managerMessageId); }
 };
 
 class AstraDeviceManagerResponse {
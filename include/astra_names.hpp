@@ -0,0 +1,23 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Small integer handle for an interned device, image or manager message name
+using AstraNameId = uint32_t;
+
+constexpr AstraNameId ASTRA_NAME_NONE = 0;
+
+// Process wide table of interned names. Names are interned when a session or
+// image table is created, so status events only carry ids and the text is
+// looked up when it is displayed. Ids stay valid for the life of the process.
+class AstraNames
+{
+public:
+    static AstraNameId Intern(const std::string &name);
+    // Returns an empty string for ASTRA_NAME_NONE or an unknown id
+    static const std::string &Lookup(AstraNameId id);
+};
@@ -5,8 +5,10 @@
 
 #include <string>
 #include <memory>
+#include <functional>
 #include <vector>
 #include <map>
+#include <cstdint>
 
 #include "image.hpp"
 
@@ -17,6 +19,11 @@ enum FlashImageType {
     FLASH_IMAGE_TYPE_EMMC,
 };
 
+struct FlashPartitionImage {
+    std::string m_partitionName;
+    std::string m_imagePath;
+};
+
 class FlashImage
 {
 public:
@@ -30,16 +37,42 @@ public:
 
     virtual int Load() = 0;
 
+    // Images which need to inspect the flash before writing it run commands on the
+    // U-Boot console after the flash command has completed. runCommand returns the
+    // console output of the command.
+    virtual bool GetRequiresConsole() const { return m_verify; }
+    virtual int RunConsoleUpdate(std::function<int(const std::string &command, std::string &output)> /* runCommand */)
+    {
+        return 0;
+    }
+    // Compare the CRC32 of the flash contents with the image. The names of the
+    // regions which do not match are added to mismatches.
+    virtual int Verify(std::function<int(const std::string &command, std::string &output)> /* runCommand */,
+        std::vector<std::string> & /* mismatches */)
+    {
+        return 0;
+    }
+
     std::string GetBootImageId() const { return m_bootImageId; }
     std::string GetChipName() const { return m_chipName; }
     std::string GetBoardName() const { return m_boardName; }
-    std::string GetFlashCommand() const { return m_flashCommand; }
+    // Without reset the device stays at the U-Boot prompt so another flash
+    // target can follow in the same session
+    std::string GetFlashCommand(bool reset = true) const
+    {
+        return reset && m_resetInFlashCommand ? m_flashCommand + m_resetCommand : m_flashCommand;
+    }
     const std::string &GetFinalImage() const { return m_finalImage; }
     AstraSecureBootVersion GetSecureBootVersion() const { return m_secureBootVersion; }
     AstraMemoryLayout GetMemoryLayout() const { return m_memoryLayout; }
     const std::vector<Image>& GetImages() const { return m_images; }
     FlashImageType GetFlashImageType() const { return m_flashImageType; }
     bool GetResetWhenComplete() const { return m_resetWhenComplete; }
+    bool GetUseFastboot() const { return m_useFastboot; }
+    bool GetVerify() const { return m_verify; }
+    const std::vector<FlashPartitionImage>& GetPartitionImages() const { return m_partitionImages; }
+    uint16_t GetFastbootVendorId() const { return m_fastbootVendorId; }
+    uint16_t GetFastbootProductId() const { return m_fastbootProductId; }
 
     static std::shared_ptr<FlashImage> FlashImageFactory(std::string imagePath, std::map<std::string, std::string> &config, std::string manifest="");
 
@@ -56,7 +89,16 @@ protected:
     std::string m_finalImage;
     std::map<std::string, std::string> m_config;
     bool m_resetWhenComplete = false;
+    // Images are flashed by a fastboot client once U-Boot has switched to fastboot mode
+    bool m_useFastboot = false;
+    std::vector<FlashPartitionImage> m_partitionImages;
+    uint16_t m_fastbootVendorId = 0x18D1;
+    uint16_t m_fastbootProductId = 0x4EE0;
     const std::string m_resetCommand = "; sleep 1; reset"; // sleep before resetting to let console messages be sent to the host
+    // m_resetCommand is appended to m_flashCommand by GetFlashCommand()
+    bool m_resetInFlashCommand = false;
+    // When verifying, the host resets the device after checking the flash contents
+    bool m_verify = false;
 };
 
 static std::string AstraFlashImageTypeToString(FlashImageType type)
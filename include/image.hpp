@@ -5,6 +5,8 @@
 
 #include <fstream>
 #include <string>
+#include <memory>
+#include <cstdint>
 #include <filesystem>
 
 enum AstraSecureBootVersion {
@@ -35,8 +37,21 @@ public:
     {
         m_imageName = std::filesystem::path(m_imagePath).filename().string();
     }
+    // Window of an existing file served under its own name. Used to split
+    // images which are too large for the protocol without copying them.
+    Image(std::string imagePath, std::string imageName, AstraImageType imageType, uint64_t offset, uint64_t size)
+        : m_imagePath{imagePath}, m_imageName{imageName}, m_imageSize{0}, m_imageType{imageType}, m_fp{nullptr},
+        m_windowOffset{offset}, m_windowSize{size}, m_isWindow{true}
+    {}
+    // Image generated in memory, such as a rewritten image list.
+    Image(std::string imageName, std::shared_ptr<const std::string> data, AstraImageType imageType)
+        : m_imagePath{imageName}, m_imageName{imageName}, m_imageSize{0}, m_imageType{imageType}, m_fp{nullptr},
+        m_data{data}
+    {}
     Image(const Image &other) : m_imagePath{other.m_imagePath}, m_imageName{other.m_imageName},
-        m_imageSize{other.m_imageSize}, m_imageType{other.m_imageType}, m_fp{other.m_fp}
+        m_imageSize{other.m_imageSize}, m_imageType{other.m_imageType}, m_fp{other.m_fp},
+        m_windowOffset{other.m_windowOffset}, m_windowSize{other.m_windowSize}, m_isWindow{other.m_isWindow},
+        m_data{other.m_data}, m_position{other.m_position}
     {}
     ~Image();
 
@@ -47,6 +62,11 @@ public:
         m_imageSize = other.m_imageSize;
         m_imageType = other.m_imageType;
         m_fp = other.m_fp;
+        m_windowOffset = other.m_windowOffset;
+        m_windowSize = other.m_windowSize;
+        m_isWindow = other.m_isWindow;
+        m_data = other.m_data;
+        m_position = other.m_position;
         return *this;
     }
 
@@ -55,16 +75,22 @@ public:
     std::string GetName() const { return m_imageName; }
     std::string GetPath() const { return m_imagePath; }
     int GetDataBlock(uint8_t *data, size_t size);
-    size_t GetSize() const { return m_imageSize; }
+    uint64_t GetSize() const { return m_imageSize; }
     AstraImageType GetImageType() const { return m_imageType; }
 
 private:
     std::string m_imagePath;
     std::string m_imageName;
-    size_t m_imageSize;
+    uint64_t m_imageSize;
     AstraImageType m_imageType;
 
     FILE *m_fp;
+
+    uint64_t m_windowOffset = 0;
+    uint64_t m_windowSize = 0;
+    bool m_isWindow = false;
+    std::shared_ptr<const std::string> m_data;
+    uint64_t m_position = 0;
 };
 
 static std::string AstraSecureBootVersionToString(AstraSecureBootVersion version)
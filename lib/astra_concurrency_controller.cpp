@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#include <algorithm>
+
+#include "astra_concurrency_controller.hpp"
+#include "astra_log.hpp"
+
+AstraConcurrencyController::AstraConcurrencyController(size_t maxLimit)
+{
+    m_maxLimit = maxLimit == 0 ? m_defaultMaxLimit : maxLimit;
+    m_limit = std::min(m_initialLimit, m_maxLimit);
+}
+
+void AstraConcurrencyController::SetMaxLimit(size_t maxLimit)
+{
+    m_maxLimit = maxLimit == 0 ? m_defaultMaxLimit : maxLimit;
+    m_limit = std::min(m_limit, m_maxLimit);
+}
+
+bool AstraConcurrencyController::Update(const AstraThroughputSample &sample)
+{
+    ASTRA_LOG;
+
+    size_t limit = m_limit;
+
+    m_aggregateRate = m_smoothing * sample.m_aggregateRate + (1 - m_smoothing) * m_aggregateRate;
+
+    m_peakAggregateRate *= m_peakDecay;
+    if (m_aggregateRate >= m_peakAggregateRate) {
+        m_peakAggregateRate = m_aggregateRate;
+        m_peakSessions = sample.m_transferringSessions;
+    }
+
+    // Fewer sessions transferring, such as while boards boot or write to flash,
+    // lowers the total without the host being saturated
+    bool collapsed = sample.m_transferringSessions > 1 && sample.m_transferringSessions >= m_peakSessions &&
+        m_aggregateRate < m_peakAggregateRate * m_collapseRatio;
+
+    if (sample.m_errors != 0 || collapsed) {
+        limit = std::max<size_t>(1, static_cast<size_t>(m_limit * m_decreaseFactor));
+        // Throughput must rise past the current rate again before the next increase
+        m_lastIncreaseRate = m_aggregateRate;
+    } else if (sample.m_activeSessions >= m_limit && m_aggregateRate > m_lastIncreaseRate * m_minGain) {
+        // Only probe upwards when the limit is what is holding sessions back
+        limit = std::min(m_limit + 1, m_maxLimit);
+        m_lastIncreaseRate = m_aggregateRate;
+    }
+
+    if (limit == m_limit) {
+        return false;
+    }
+
+    log(ASTRA_LOG_LEVEL_INFO) << "Concurrency limit " << m_limit << " -> " << limit << " aggregate: "
+        << static_cast<uint64_t>(m_aggregateRate) << " B/s peak: " << static_cast<uint64_t>(m_peakAggregateRate)
+        << " B/s with " << m_peakSessions << " sessions, transferring: " << sample.m_transferringSessions
+        << " errors: " << sample.m_errors << endLog;
+    m_limit = limit;
+
+    return true;
+}
@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Throughput measured over one control interval
+struct AstraThroughputSample {
+    // Bytes per second sent by all sessions
+    double m_aggregateRate;
+    // Sessions which sent data during the interval
+    size_t m_transferringSessions;
+    // Sessions running when the sample was taken
+    size_t m_activeSessions;
+    // Block retries and failed sessions during the interval
+    uint32_t m_errors;
+};
+
+// Additive increase, multiplicative decrease control of the number of
+// concurrently active sessions. The limit grows by one while aggregate
+// throughput keeps rising when it is the limit holding sessions back, and
+// shrinks when errors appear or aggregate throughput falls well below the best
+// seen with as many sessions transferring, which happens once the disk or host
+// thrashes. Throughput per device is not used: it also falls when a hub's
+// bandwidth is shared by more devices, without the total getting worse.
+class AstraConcurrencyController
+{
+public:
+    // maxLimit of 0 uses m_defaultMaxLimit
+    AstraConcurrencyController(size_t maxLimit = 0);
+
+    void SetMaxLimit(size_t maxLimit);
+    size_t GetLimit() const { return m_limit; }
+
+    // Returns true if the limit changed
+    bool Update(const AstraThroughputSample &sample);
+
+private:
+    size_t m_limit;
+    size_t m_maxLimit;
+    // Smoothed aggregate rate, and its value at the last increase
+    double m_aggregateRate = 0;
+    double m_lastIncreaseRate = 0;
+    // Best smoothed aggregate rate and the sessions transferring when it was seen.
+    // Decays so it can follow slower images.
+    double m_peakAggregateRate = 0;
+    size_t m_peakSessions = 0;
+
+    static constexpr size_t m_initialLimit = 2;
+    static constexpr size_t m_defaultMaxLimit = 64;
+    // Weight of the newest sample in the smoothed rates
+    static constexpr double m_smoothing = 0.5;
+    // Aggregate rate must rise by this much for another increase
+    static constexpr double m_minGain = 1.05;
+    // Aggregate rate below this fraction of the peak, with at least as many
+    // sessions transferring, is a collapse
+    static constexpr double m_collapseRatio = 0.75;
+    static constexpr double m_decreaseFactor = 0.75;
+    static constexpr double m_peakDecay = 0.995;
+};
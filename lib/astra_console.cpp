@@ -6,7 +6,8 @@
 #include "astra_console.hpp"
 #include "astra_log.hpp"
 
-AstraConsole::AstraConsole(std::string deviceName, std::string logPath)
+AstraConsole::AstraConsole(std::string deviceName, std::string logPath, AstraSessionMemory::Allocator<char> allocator)
+    : m_consoleData{allocator}
 {
     ASTRA_LOG;
 
@@ -19,43 +20,84 @@ AstraConsole::~AstraConsole()
     ASTRA_LOG;
 }
 
-void AstraConsole::Append(const std::string &data)
+void AstraConsole::Append(std::string_view data)
 {
     ASTRA_LOG;
 
-    std::string trimmedData = data;
-    trimmedData.erase(trimmedData.find_last_not_of(" \t\n\r\f\v") + 1);
+    std::string_view trimmedData = data.substr(0, data.find_last_not_of(" \t\n\r\f\v") + 1);
 
-    if (trimmedData.size() >= m_uBootPrompt.size() &&
-        trimmedData.rfind(m_uBootPrompt) == (trimmedData.size() - m_uBootPrompt.size()))
+    bool prompt = trimmedData.size() >= m_uBootPrompt.size() &&
+        trimmedData.rfind(m_uBootPrompt) == (trimmedData.size() - m_uBootPrompt.size());
+
+    uint64_t promptCount;
+    std::function<void(uint64_t promptCount)> promptCallback;
     {
+        std::lock_guard<std::mutex> lock(m_promptMutex);
+        m_consoleData += data;
+        if (prompt) {
+            ++m_promptCount;
+        }
+        promptCount = m_promptCount;
+        promptCallback = m_promptCallback;
+    }
+
+    if (prompt) {
         log(ASTRA_LOG_LEVEL_DEBUG) << "U-Boot prompt detected." << endLog;
-        m_promptCV.notify_one();
+        m_promptCV.notify_all();
+        if (promptCallback) {
+            promptCallback(promptCount);
+        }
     }
 
-    m_consoleData += data;
     m_consoleLog << data;
     m_consoleLog.flush();
 }
 
-std::string &AstraConsole::Get()
+void AstraConsole::SetPromptCallback(std::function<void(uint64_t promptCount)> promptCallback)
+{
+    std::lock_guard<std::mutex> lock(m_promptMutex);
+    m_promptCallback = promptCallback;
+}
+
+std::string AstraConsole::Get()
 {
     ASTRA_LOG;
 
-    return m_consoleData;
+    std::lock_guard<std::mutex> lock(m_promptMutex);
+    return std::string(m_consoleData.data(), m_consoleData.size());
 }
 
-bool AstraConsole::WaitForPrompt()
+bool AstraConsole::WaitForPrompt(uint64_t promptCount, std::chrono::milliseconds timeout)
 {
     ASTRA_LOG;
 
     std::unique_lock<std::mutex> lock(m_promptMutex);
-    m_promptCV.wait(lock);
-    if (m_shutdown.load()) {
-        return false;
-    }
+    bool prompt = m_promptCV.wait_for(lock, timeout, [this, promptCount] {
+        return m_promptCount > promptCount || m_shutdown.load();
+    });
 
-    return true;
+    return prompt && !m_shutdown.load();
+}
+
+uint64_t AstraConsole::GetPromptCount()
+{
+    std::lock_guard<std::mutex> lock(m_promptMutex);
+    return m_promptCount;
+}
+
+size_t AstraConsole::GetSize()
+{
+    std::lock_guard<std::mutex> lock(m_promptMutex);
+    return m_consoleData.size();
+}
+
+std::string AstraConsole::GetSince(size_t position)
+{
+    std::lock_guard<std::mutex> lock(m_promptMutex);
+    if (position >= m_consoleData.size()) {
+        return "";
+    }
+    return std::string(m_consoleData.data() + position, m_consoleData.size() - position);
 }
 
 void AstraConsole::Shutdown()
@@ -65,4 +107,11 @@ void AstraConsole::Shutdown()
     m_shutdown.store(true);
     m_promptCV.notify_all();
     m_consoleLog.close();
-}
\ No newline at end of file
+}
+
+void AstraConsole::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_promptMutex);
+    AstraSessionMemory::String empty(m_consoleData.get_allocator());
+    m_consoleData.swap(empty);
+}
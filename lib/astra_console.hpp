@@ -4,29 +4,47 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <iostream>
 #include <condition_variable>
 #include <mutex>
 #include <fstream>
+#include <functional>
+
+#include "astra_session_memory.hpp"
 
 class AstraConsole
 {
 public:
-    AstraConsole(std::string deviceName, std::string logPath);
+    // The console text is allocated with allocator, normally from the session pool
+    AstraConsole(std::string deviceName, std::string logPath,
+        AstraSessionMemory::Allocator<char> allocator = AstraSessionMemory::Allocator<char>());
     ~AstraConsole();
 
-    void Append(const std::string &data);
-    std::string &Get();
+    void Append(std::string_view data);
+    // Called from Append() with the new prompt count each time a prompt is received
+    void SetPromptCallback(std::function<void(uint64_t promptCount)> promptCallback);
+    std::string Get();
 
-    bool WaitForPrompt();
+    // Wait until more than promptCount prompts have been received
+    bool WaitForPrompt(uint64_t promptCount, std::chrono::milliseconds timeout);
+    uint64_t GetPromptCount();
+    size_t GetSize();
+    std::string GetSince(size_t position);
     void Shutdown();
+    // Free the console text once the session is closed so its pool can be released
+    void Clear();
 
 private:
-    std::string m_consoleData;
+    AstraSessionMemory::String m_consoleData;
     const std::string m_uBootPrompt = "=>";
     std::condition_variable m_promptCV;
     std::mutex m_promptMutex;
+    uint64_t m_promptCount = 0;
+    std::function<void(uint64_t promptCount)> m_promptCallback;
     std::atomic<bool> m_shutdown{false};
     std::ofstream m_consoleLog;
 };
\ No newline at end of file
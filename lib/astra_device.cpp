@@ -14,17 +14,29 @@
 #include "astra_boot_image.hpp"
 #include "flash_image.hpp"
 #include "astra_console.hpp"
+#include "astra_reactor.hpp"
+#include "astra_device_state.hpp"
+#include "astra_flash_watchdog.hpp"
+#include "astra_session_memory.hpp"
+#include "transfer_buffer_pool.hpp"
 #include "usb_device.hpp"
+#include "usb_topology.hpp"
 #include "image.hpp"
+#include "fastboot_client.hpp"
+#include "sparse_image.hpp"
 #include "utils.hpp"
 #include "astra_log.hpp"
 
 class AstraDevice::AstraDeviceImpl {
 public:
-    AstraDeviceImpl(std::unique_ptr<USBDevice> device, const std::string &tempDir, bool bootOnly, const std::string &bootCommand)
-        : m_usbDevice{std::move(device)}, m_tempDir{tempDir}, m_bootOnly{bootOnly}, m_bootCommand{bootCommand}
+    AstraDeviceImpl(std::unique_ptr<USBDevice> device, AstraReactor &reactor, USBTopology &topology, const std::string &tempDir,
+        bool bootOnly, const std::string &bootCommand)
+        : m_usbDevice{std::move(device)}, m_strand{std::make_shared<AstraStrand>(reactor)}, m_topology{topology}, m_tempDir{tempDir},
+        m_bootOnly{bootOnly}, m_bootCommand{bootCommand}
     {
         ASTRA_LOG;
+
+        m_usbPath = m_usbDevice->GetUSBPath();
     }
 
     ~AstraDeviceImpl()
@@ -51,13 +63,16 @@ public:
         m_uEnvSupport = bootImage->GetUEnvSupport();
         m_finalBootImage = bootImage->GetFinalBootImage();
 
-        ret = m_usbDevice->Open(std::bind(&AstraDeviceImpl::USBEventHandler, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+        ret = OpenUSBDevice();
         if (ret < 0) {
             log(ASTRA_LOG_LEVEL_ERROR) << "Failed to open device" << endLog;
             return ret;
         }
+        m_serialNumber = m_usbDevice->GetSerialNumber();
 
-        m_deviceName = "device:" + m_usbDevice->GetUSBPath();
+        m_deviceName = "device:" + m_usbPath;
+        m_deviceId = AstraNames::Intern(m_deviceName);
+        m_sizeRequestImageId = AstraNames::Intern(m_sizeRequestImageFilename);
         log(ASTRA_LOG_LEVEL_INFO) << "Device name: " << m_deviceName << endLog;
 
         std::string modifiedDeviceName = m_deviceName;
@@ -67,7 +82,12 @@ public:
         m_deviceDir = m_tempDir + "/" + modifiedDeviceName;
         std::filesystem::create_directories(m_deviceDir);
 
-        m_console = std::make_unique<AstraConsole>(modifiedDeviceName, m_deviceDir);
+        m_console = std::make_unique<AstraConsole>(modifiedDeviceName, m_deviceDir, m_memory.GetAllocator<char>());
+        m_console->SetPromptCallback([this](uint64_t promptCount) {
+            m_strand->Post([this, promptCount] {
+                OnConsolePrompt(promptCount);
+            });
+        });
 
         std::ofstream imageFile(m_deviceDir + "/" + m_usbPathImageFilename);
         if (!imageFile) {
@@ -75,48 +95,40 @@ public:
             return -1;
         }
 
-        imageFile << m_usbDevice->GetUSBPath();
+        imageFile << m_usbPath;
         imageFile.close();
 
         Image usbPathImage(m_deviceDir + "/"  + m_usbPathImageFilename, ASTRA_IMAGE_TYPE_BOOT);
         m_sizeRequestImage = std::make_unique<Image>(m_deviceDir + "/" + m_sizeRequestImageFilename, ASTRA_IMAGE_TYPE_UPDATE_EMMC);
 
-        m_status = ASTRA_DEVICE_STATUS_OPENED;
+        m_state.Transition(ASTRA_DEVICE_STATUS_OPENED);
 
         std::vector<Image> bootImageSubimages = bootImage->GetImages();
 
-        {
-            std::lock_guard<std::mutex> lock(m_imageMutex);
-            m_images.insert(m_images.end(), bootImageSubimages.begin(), bootImageSubimages.end());
-
-            auto it = std::find_if(m_images.begin(), m_images.end(), [this](const Image &img) {
-                return img.GetName() == m_uEnvFilename;
-            });
-
-            // If uEnv.txt is not in the image list and uEnv is supported
-            // then create a uEnv image in the temp directory using the boot command
-            if (it == m_images.end() && m_uEnvSupport) {
-                log(ASTRA_LOG_LEVEL_DEBUG) << "Adding uEnv.txt to image list" << endLog;
-                Image uEnvImage(m_deviceDir + "/" + m_uEnvFilename, ASTRA_IMAGE_TYPE_BOOT);
+        auto it = std::find_if(bootImageSubimages.begin(), bootImageSubimages.end(), [this](const Image &img) {
+            return img.GetName() == m_uEnvFilename;
+        });
 
-                WriteUEnvFile(m_bootCommand);
+        // If uEnv.txt is not in the image list and uEnv is supported
+        // then create a uEnv image in the temp directory using the boot command
+        if (it == bootImageSubimages.end() && m_uEnvSupport) {
+            log(ASTRA_LOG_LEVEL_DEBUG) << "Adding uEnv.txt to image list" << endLog;
+            Image uEnvImage(m_deviceDir + "/" + m_uEnvFilename, ASTRA_IMAGE_TYPE_BOOT);
 
-                m_images.push_back(uEnvImage);
-            }
+            WriteUEnvFile(m_bootCommand);
 
-            m_images.push_back(usbPathImage);
-            m_images.push_back(*m_sizeRequestImage);
+            bootImageSubimages.push_back(uEnvImage);
         }
 
-        m_running.store(true);
-        m_status = ASTRA_DEVICE_STATUS_BOOT_START;
-        m_imageRequestThread= std::thread(std::bind(&AstraDeviceImpl::ImageRequestThread, this));
+        bootImageSubimages.push_back(usbPathImage);
+        bootImageSubimages.push_back(*m_sizeRequestImage);
+        AddImages(bootImageSubimages);
 
-        {
-            log(ASTRA_LOG_LEVEL_DEBUG) << "Waiting for imageRequest thread to be ready" << endLog;
-            std::unique_lock<std::mutex> lock(m_imageRequestThreadReadyMutex);
-            m_imageRequestThreadReadyCV.wait(lock, [this] { return m_imageRequestThreadReady.load(); });
-        }
+        m_running.store(true);
+        m_state.Transition(ASTRA_DEVICE_STATUS_BOOT_START);
+        m_deadlineTimer = StartWatchdog(m_timeouts.m_boot, [this] {
+            OnPhaseDeadline(true);
+        });
 
         ret = m_usbDevice->EnableInterrupts();
         if (ret < 0) {
@@ -127,22 +139,22 @@ public:
         return 0;
     }
 
-    int Update(std::shared_ptr<FlashImage> flashImage)
+    int Update(std::vector<std::shared_ptr<FlashImage>> flashImages)
     {
         ASTRA_LOG;
 
-        m_finalUpdateImage = flashImage->GetFinalImage();
-        m_resetWhenComplete = flashImage->GetResetWhenComplete();
-
-        {
-            std::lock_guard<std::mutex> lock(m_imageMutex);
-            m_images.insert(m_images.end(), flashImage->GetImages().begin(), flashImage->GetImages().end());
+        if (flashImages.empty()) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "No flash targets" << endLog;
+            return -1;
         }
 
+        m_flashTargets = std::move(flashImages);
+        m_flashTarget = 0;
+        StartFlashTarget();
+
         if (!m_uEnvSupport && m_ubootConsole == ASTRA_UBOOT_CONSOLE_USB) {
-            if (m_console->WaitForPrompt()) {
-                SendToConsole(flashImage->GetFlashCommand() + "\n");
-            }
+            // Sent from OnConsolePrompt() once U-Boot reaches the prompt
+            m_sendFlashCommand = true;
         }
 
         return 0;
@@ -152,43 +164,27 @@ public:
     {
         ASTRA_LOG;
 
-        if (m_uEnvSupport || m_ubootConsole == ASTRA_UBOOT_CONSOLE_UART) {
-            for (;;) {
-                std::unique_lock<std::mutex> lock(m_deviceEventMutex);
-                m_deviceEventCV.wait(lock);
-                if (m_bootOnly) {
-                    if (m_status == ASTRA_DEVICE_STATUS_BOOT_COMPLETE) {
-                        // Device successfully reset after boot
-                        SendStatus(m_status, 100, "", "Success");
-                    }
-                } else {
-                    if (m_status == ASTRA_DEVICE_STATUS_UPDATE_COMPLETE) {
-                        // Device successfully reset after update
-                        SendStatus(m_status, 100, "", "Success");
-                    }
-                }
+        std::unique_lock<std::mutex> lock(m_finishedMutex);
+        m_finishedCV.wait(lock, [this] { return m_finished; });
 
-                if (!m_running.load()) {
-                    log(ASTRA_LOG_LEVEL_DEBUG) << "Device event received: shutting down" << endLog;
-                    break;
-                }
-            }
-        } else if (m_ubootConsole == ASTRA_UBOOT_CONSOLE_USB) {
-            if (m_console->WaitForPrompt()) {
-                if (m_resetWhenComplete) {
-                    SendToConsole("reset\n");
-                }
-                // Update does not require a reset, but the
-                // console is back at the U-Boot prompt.
-                if (m_status == ASTRA_DEVICE_STATUS_UPDATE_COMPLETE) {
-                    SendStatus(m_status, 100, "", "Success");
-                }
-            }
+        return 0;
+    }
+
+    int WaitForCompletion(std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(m_finishedMutex);
+        if (!m_finishedCV.wait_for(lock, timeout, [this] { return m_finished; })) {
+            return -1;
         }
 
         return 0;
     }
 
+    void SetTimeouts(const AstraDeviceTimeouts &timeouts)
+    {
+        m_timeouts = timeouts;
+    }
+
     int SendToConsole(const std::string &data)
     {
         ASTRA_LOG;
@@ -209,14 +205,119 @@ public:
         return 0;
     }
 
+    bool AttachFastbootDevice(std::unique_ptr<USBDevice> &device)
+    {
+        ASTRA_LOG;
+
+        if (!m_waitingForFastboot.load() || device->GetUSBPath() != m_usbPath) {
+            return false;
+        }
+
+        log(ASTRA_LOG_LEVEL_INFO) << "Fastboot device attached: " << device->GetUSBPath() << endLog;
+
+        {
+            std::lock_guard<std::mutex> lock(m_fastbootMutex);
+            m_fastbootDevice = std::move(device);
+            m_waitingForFastboot.store(false);
+        }
+
+        m_strand->Post([this] {
+            StartJob(&AstraDeviceImpl::RunFastboot);
+        });
+
+        return true;
+    }
+
+    bool AttachDevice(std::unique_ptr<USBDevice> &device)
+    {
+        ASTRA_LOG;
+
+        if (device->GetUSBPath() != m_usbPath) {
+            return false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_closeMutex);
+            if (m_shutdown.load()) {
+                return false;
+            }
+            if (!m_waitingForReattach.exchange(false)) {
+                if (!m_reattachExpected || m_reattachDevice) {
+                    return false;
+                }
+                // The device re-enumerated before OnDisconnect() ran on the strand.
+                // Keep it for OnDisconnect() to resume the session with.
+                m_reattachDevice = std::move(device);
+                log(ASTRA_LOG_LEVEL_INFO) << "Device reconnected on " << m_usbPath << " before its disconnect was handled" << endLog;
+                return true;
+            }
+            m_reattachDevice = std::move(device);
+        }
+
+        log(ASTRA_LOG_LEVEL_INFO) << "Device reconnected on " << m_usbPath << ", resuming session" << endLog;
+
+        m_strand->Post([this] {
+            OnReattach();
+        });
+
+        return true;
+    }
+
+    bool DeviceRemoved(const USBDevice &device)
+    {
+        ASTRA_LOG;
+
+        uint32_t generation;
+        {
+            std::lock_guard<std::mutex> lock(m_closeMutex);
+            if (m_shutdown.load() || !m_usbDevice->IsSameDevice(device)) {
+                return false;
+            }
+            generation = m_usbGeneration.load();
+        }
+
+        log(ASTRA_LOG_LEVEL_DEBUG) << "Device removed from " << m_usbPath << endLog;
+        m_strand->Post([this, generation] {
+            OnDisconnect(generation);
+        });
+
+        return true;
+    }
+
     std::string GetDeviceName()
     {
         return m_deviceName;
     }
 
+    AstraNameId GetDeviceId()
+    {
+        return m_deviceId;
+    }
+
     AstraDeviceStatus GetDeviceStatus()
     {
-        return m_status;
+        return m_state.Get();
+    }
+
+    std::vector<AstraDeviceTransition> GetStatusTrace()
+    {
+        return m_state.GetTrace();
+    }
+
+    AstraDeviceProgress GetProgress()
+    {
+        AstraDeviceProgress progress;
+
+        progress.m_deviceId = m_deviceId;
+        progress.m_status = m_state.Get();
+        progress.m_imageId = m_progressImageId.load(std::memory_order_relaxed);
+        progress.m_imageBytesSent = m_progressImageBytes.load(std::memory_order_relaxed);
+        progress.m_imageSize = m_progressImageSize.load(std::memory_order_relaxed);
+        progress.m_totalBytesSent = m_progressTotalBytes.load(std::memory_order_relaxed);
+        progress.m_imagesSent = m_progressImagesSent.load(std::memory_order_relaxed);
+        progress.m_progress = progress.m_imageSize ? ((double)progress.m_imageBytesSent / progress.m_imageSize) * 100 : 0;
+
+        return progress;
     }
 
     void Close() {
@@ -225,59 +326,191 @@ public:
         std::lock_guard<std::mutex> lock(m_closeMutex);
         if (!m_shutdown.exchange(true)) {
             m_running.store(false);
-            m_deviceEventCV.notify_all();
-            m_imageRequestCV.notify_all();
+            m_flashWatchdog.Cancel();
+            m_strand->CancelTimer(m_bootRequestTimer);
+            m_strand->CancelTimer(m_reattachTimer);
+            m_strand->CancelTimer(m_retryTimer);
+            m_strand->CancelTimer(m_throttleTimer);
+            m_strand->CancelTimer(m_deadlineTimer);
+            m_strand->CancelTimer(m_stallTimer);
+            m_waitingForReattach.store(false);
+            TransferBufferPool::GetInstance().CancelWaiters(this);
 
-            if (m_imageRequestThread.joinable()) {
-                log(ASTRA_LOG_LEVEL_DEBUG) << "Joining image request thread" << endLog;
-                m_imageRequestThread.join();
-            } else {
-                log(ASTRA_LOG_LEVEL_DEBUG) << "Image request thread not joinable" << endLog;
-            }
             log(ASTRA_LOG_LEVEL_DEBUG) << "Shutting down console" << endLog;
             if (m_console.get()) {
                 m_console->Shutdown();
             }
 
-            m_images.clear();
-
             log(ASTRA_LOG_LEVEL_DEBUG) << "Closing USB device" << endLog;
             m_usbDevice->Close();
+            m_reattachDevice.reset();
+            {
+                std::lock_guard<std::mutex> fastbootLock(m_fastbootMutex);
+                if (m_fastbootDevice) {
+                    m_fastbootDevice->Close();
+                }
+            }
+
+            m_state.Transition(ASTRA_DEVICE_STATUS_CLOSED);
+
+            {
+                // Drop the image table and console text and return the session pool. If an
+                // image is still being sent the pool is returned when the session is destroyed.
+                std::lock_guard<std::mutex> imageTableLock(m_imageTableWriteMutex);
+                std::atomic_store(&m_imageTable, std::make_shared<const ImageTable>());
+                if (m_console) {
+                    m_console->Clear();
+                }
+                m_memory.Release();
+            }
+
+            {
+                std::lock_guard<std::mutex> finishedLock(m_finishedMutex);
+                m_finished = true;
+            }
+            m_finishedCV.notify_all();
             log(ASTRA_LOG_LEVEL_DEBUG) << "Close complete" << endLog;
         }
     }
 
+    AstraDeviceMemoryStats GetMemoryStats()
+    {
+        return m_memory.GetStats();
+    }
+
+    AstraDeviceRetryStats GetRetryStats()
+    {
+        AstraDeviceRetryStats stats;
+
+        stats.m_retries = m_blockRetryCount.load(std::memory_order_relaxed);
+        stats.m_recoveredBlocks = m_recoveredBlocks.load(std::memory_order_relaxed);
+        stats.m_failedBlocks = m_failedBlocks.load(std::memory_order_relaxed);
+
+        return stats;
+    }
+
+    void SetCompletionCallback(std::function<void(AstraDeviceStatus)> completionCallback)
+    {
+        m_completionCallback = completionCallback;
+    }
+
+    void Retire(bool removeFiles, std::function<void()> retired)
+    {
+        m_strand->Post([this, removeFiles, retired] {
+            m_removeFilesOnRetire = removeFiles;
+            m_retired = retired;
+            // A console script or fastboot job still references the session,
+            // it is retired when the job returns
+            if (!m_jobRunning) {
+                CloseStrand();
+            }
+        });
+    }
+
 private:
+    // Declared first so it outlives everything allocated from it
+    AstraSessionMemory m_memory;
     std::unique_ptr<USBDevice> m_usbDevice;
-    AstraDeviceStatus m_status;
+    AstraDeviceState m_state;
     std::function<void(AstraDeviceManagerResponse)> m_statusCallback;
+    std::function<void(AstraDeviceStatus)> m_completionCallback;
     std::atomic<bool> m_running{false};
     std::atomic<bool> m_shutdown{false};
     bool m_uEnvSupport = false;
     std::string m_deviceName;
-    bool m_resetWhenComplete;
-
-    std::mutex m_imageMutex;
-    std::vector<Image> m_images;
+    AstraNameId m_deviceId = ASTRA_NAME_NONE;
+    bool m_resetWhenComplete = false;
+
+    // All session events run on the strand, one at a time, on the reactor threads
+    std::shared_ptr<AstraStrand> m_strand;
+    // Shares the bandwidth of the hubs above this device with the other sessions
+    USBTopology &m_topology;
+    AstraDeviceTimeouts m_timeouts;
+    // Flash command or fastboot attach of the current target, from the end of the boot
+    AstraFlashWatchdog m_flashWatchdog{m_strand};
+    AstraReactor::TimerId m_bootRequestTimer = 0;
+    // Deadline for the whole boot or the whole update
+    AstraReactor::TimerId m_deadlineTimer = 0;
+    // Checks that an image being sent is still moving
+    AstraReactor::TimerId m_stallTimer = 0;
+    uint64_t m_stallLastBytes = 0;
+    std::chrono::steady_clock::time_point m_stallLastProgress;
+    static constexpr std::chrono::seconds m_stallCheckInterval{1};
+    bool m_jobRunning = false;
+    // Shared by a blocking job and the cancel it gives the reactor
+    struct JobCancel {
+        std::mutex m_mutex;
+        AstraDeviceImpl *m_session;
+    };
+    // Set by Retire(), called once nothing on the strand references the session
+    std::function<void()> m_retired;
+    bool m_removeFilesOnRetire = false;
+
+    std::mutex m_finishedMutex;
+    std::condition_variable m_finishedCV;
+    bool m_finished = false;
+
+    // Transfer progress, updated with relaxed atomics on every block and read by
+    // GetProgress(). Only the start and end of an image are reported as events.
+    std::atomic<AstraNameId> m_progressImageId{ASTRA_NAME_NONE};
+    std::atomic<uint64_t> m_progressImageBytes{0};
+    std::atomic<uint64_t> m_progressImageSize{0};
+    std::atomic<uint64_t> m_progressTotalBytes{0};
+    std::atomic<uint32_t> m_progressImagesSent{0};
+
+    // Immutable snapshot of the images the device may request. Writers copy it,
+    // append and swap the pointer. Readers load it without taking a lock.
+    struct ImageEntry {
+        std::shared_ptr<Image> m_image;
+        AstraNameId m_nameId;
+    };
+    using ImageTable = AstraSessionMemory::Vector<ImageEntry>;
+    std::shared_ptr<const ImageTable> m_imageTable = std::make_shared<const ImageTable>();
+    std::mutex m_imageTableWriteMutex;
 
-    std::condition_variable m_deviceEventCV;
-    std::mutex m_deviceEventMutex;
+    // Guards swapping m_usbDevice when the device re-enumerates against Close()
     std::mutex m_closeMutex;
 
-    std::thread m_imageRequestThread;
-    std::condition_variable m_imageRequestCV;
-    std::mutex m_imageRequestMutex;
-    std::atomic<bool> m_imageRequestReady = false;
+    std::string m_usbPath;
+    std::string m_serialNumber;
+    // Bumped each time a USB device is opened so events from a replaced device are ignored
+    std::atomic<uint32_t> m_usbGeneration{0};
+    std::atomic<bool> m_waitingForReattach{false};
+    // Set under m_closeMutex when gen3_miniloader.bin.usb is requested, so a device
+    // which re-enumerates before OnDisconnect() runs is kept in m_reattachDevice
+    bool m_reattachExpected = false;
+    std::unique_ptr<USBDevice> m_reattachDevice;
+    AstraReactor::TimerId m_reattachTimer = 0;
+    uint32_t m_reattachCount = 0;
+
     uint8_t m_imageType;
     std::string m_requestedImageName;
-    std::condition_variable m_imageRequestThreadReadyCV;
-    std::mutex m_imageRequestThreadReadyMutex;
-    std::atomic<bool> m_imageRequestThreadReady = false;
     bool m_bootOnly = false;
+    bool m_imageRequestsStopped = false;
+    bool m_waitForSizeRequest = false;
+
+    // Image currently being sent by the chain of asynchronous writes
+    std::shared_ptr<Image> m_sendImage;
+    AstraNameId m_sendImageId = ASTRA_NAME_NONE;
+    uint64_t m_sendTransferred = 0;
+    uint64_t m_sendTotalSize = 0;
 
     const std::string m_imageRequestString = "i*m*g*r*q*";
-    static constexpr int m_imageBufferSize = (1 * 1024 * 1024) + 4;
-    uint8_t m_imageBuffer[m_imageBufferSize];
+    // Leased from the shared pool only while an image is being sent
+    TransferBufferPool::Buffer m_transferBuffer;
+    // Block currently in the transfer buffer and how much of it the device has acknowledged
+    uint64_t m_blockSize = 0;
+    uint64_t m_blockOffset = 0;
+    int m_blockRetries = 0;
+    bool m_writePending = false;
+    AstraReactor::TimerId m_retryTimer = 0;
+    // Holds the next block until the hubs above the device have bandwidth for it
+    AstraReactor::TimerId m_throttleTimer = 0;
+    static constexpr int m_maxBlockRetries = 5;
+    static constexpr std::chrono::milliseconds m_retryBaseDelay{50};
+    std::atomic<uint32_t> m_blockRetryCount{0};
+    std::atomic<uint32_t> m_recoveredBlocks{0};
+    std::atomic<uint32_t> m_failedBlocks{0};
     std::string m_finalBootImage;
 
     std::unique_ptr<AstraConsole> m_console;
@@ -290,331 +523,1216 @@ private:
     const std::string m_uEnvFilename = "uEnv.txt";
     std::string m_finalUpdateImage;
     std::unique_ptr<Image> m_sizeRequestImage;
+    AstraNameId m_sizeRequestImageId = ASTRA_NAME_NONE;
     std::string m_bootCommand;
+    std::string m_flashCommand;
+    bool m_sendFlashCommand = false;
 
     int m_imageCount = 0;
 
-    void SendStatus(AstraDeviceStatus status, double progress, const std::string &imageName, const std::string &message = "")
+    // Flashed one after another in the same U-Boot session
+    std::vector<std::shared_ptr<FlashImage>> m_flashTargets;
+    size_t m_flashTarget = 0;
+    // A target other than the last has been written, the next one starts at the prompt
+    bool m_flashTargetWritten = false;
+
+    std::shared_ptr<FlashImage> m_consoleUpdateImage;
+    uint64_t m_flashCommandPromptCount = 0;
+    static constexpr std::chrono::seconds m_consoleCommandTimeout{60};
+
+    std::shared_ptr<FlashImage> m_fastbootImage;
+    std::unique_ptr<USBDevice> m_fastbootDevice;
+    std::atomic<bool> m_waitingForFastboot{false};
+    std::mutex m_fastbootMutex;
+    static constexpr uint32_t m_sparseBlockSize = 4096;
+    static constexpr uint64_t m_defaultMaxDownloadSize = 0x8000000;
+
+    void SendStatus(AstraDeviceStatus status, double progress, AstraNameId imageId,
+        AstraDeviceMessage message = ASTRA_DEVICE_MESSAGE_NONE)
     {
         ASTRA_LOG;
 
-        if (imageName != m_sizeRequestImageFilename) { //filter out size request image
+        if (imageId != m_sizeRequestImageId) { //filter out size request image
             log(ASTRA_LOG_LEVEL_INFO) << "Device status: " << AstraDeviceStatusToString(status) << " Progress: " << progress
-                << " Image: " << imageName << " Message: " << message << endLog;
-            m_statusCallback({DeviceResponse{m_deviceName, status, progress, imageName, message}});
+                << " Image: " << AstraNames::Lookup(imageId) << " Message: " << AstraDeviceMessageToString(message) << endLog;
+            m_statusCallback({DeviceResponse{m_deviceId, status, progress, imageId, message}});
         }
     }
 
-    void ImageRequestThread()
+    void StartProgress(AstraNameId imageId, uint64_t size)
     {
-        ASTRA_LOG;
+        m_progressImageId.store(imageId, std::memory_order_relaxed);
+        m_progressImageBytes.store(0, std::memory_order_relaxed);
+        m_progressImageSize.store(size, std::memory_order_relaxed);
+    }
 
-        int ret = HandleImageRequests();
-        if (ret < 0) {
-            log(ASTRA_LOG_LEVEL_ERROR) << "Failed to handle image request" << endLog;
-        }
+    void AddProgress(uint64_t bytes)
+    {
+        m_progressImageBytes.fetch_add(bytes, std::memory_order_relaxed);
+        m_progressTotalBytes.fetch_add(bytes, std::memory_order_relaxed);
     }
 
-    void HandleInterrupt(uint8_t *buf, size_t size)
+    // Called on the strand when the session has nothing left to do
+    void Finish()
     {
         ASTRA_LOG;
 
-        log(ASTRA_LOG_LEVEL_DEBUG) << "Interrupt received: size:" << size << endLog;
-
-        std::string message(reinterpret_cast<char *>(buf), size);
-
-        auto it = message.find(m_imageRequestString);
-        if (it != std::string::npos) {
-            if (m_status == ASTRA_DEVICE_STATUS_BOOT_COMPLETE && !m_bootOnly) {
-                m_status = ASTRA_DEVICE_STATUS_UPDATE_START;
+        {
+            std::lock_guard<std::mutex> lock(m_finishedMutex);
+            if (m_finished) {
+                return;
             }
+            m_finished = true;
+        }
+        m_finishedCV.notify_all();
+
+        m_flashWatchdog.Cancel();
+        m_strand->CancelTimer(m_bootRequestTimer);
+        m_strand->CancelTimer(m_reattachTimer);
+        m_strand->CancelTimer(m_retryTimer);
+        m_strand->CancelTimer(m_throttleTimer);
+        m_strand->CancelTimer(m_deadlineTimer);
+        m_strand->CancelTimer(m_stallTimer);
+
+        AstraDeviceStatus status = m_state.Get();
+        log(ASTRA_LOG_LEVEL_DEBUG) << "Session finished: " << AstraDeviceStatusToString(status) << endLog;
+        LogStatusTrace();
+
+        AstraDeviceRetryStats retryStats = GetRetryStats();
+        if (retryStats.m_retries) {
+            log(ASTRA_LOG_LEVEL_INFO) << m_deviceName << ": block retries: " << retryStats.m_retries << " recovered: "
+                << retryStats.m_recoveredBlocks << " failed: " << retryStats.m_failedBlocks << endLog;
+        }
 
-            it += m_imageRequestString.size();
-            m_imageType = buf[it];
-            log(ASTRA_LOG_LEVEL_DEBUG) << "Image type: " << std::hex << m_imageType << std::dec << endLog;
-            std::string imageName = message.substr(it + 1);
-
-            // Strip off Null character
-            size_t end = imageName.find_last_not_of('\0');
-            if (end != std::string::npos) {
-                m_requestedImageName = imageName.substr(0, end + 1);
-            } else {
-                m_requestedImageName = imageName;
-            }
-            log(ASTRA_LOG_LEVEL_DEBUG) << "Requested image name: '" << m_requestedImageName << "'" << endLog;
+        AstraDeviceMemoryStats memoryStats = m_memory.GetStats();
+        log(ASTRA_LOG_LEVEL_DEBUG) << "Image table memory: allocations: " << memoryStats.m_allocations << " in use: "
+            << memoryStats.m_bytesInUse << " peak: " << memoryStats.m_peakBytesInUse << endLog;
 
-            m_imageRequestReady.store(true);
-            m_imageRequestCV.notify_one();
-        } else {
-            m_console->Append(message);
+        if (m_completionCallback) {
+            m_completionCallback(status);
         }
     }
 
-    void USBEventHandler(USBDevice::USBEvent event, uint8_t *buf, size_t size)
+    void LogStatusTrace()
     {
         ASTRA_LOG;
 
-        if (event == USBDevice::USB_DEVICE_EVENT_INTERRUPT) {
-            HandleInterrupt(buf, size);
-        } else if (event == USBDevice::USB_DEVICE_EVENT_NO_DEVICE || event == USBDevice::USB_DEVICE_EVENT_TRANSFER_CANCELED ||
-            event == USBDevice::USB_DEVICE_EVENT_TRANSFER_ERROR)
-        {
-            // When using SU-Boot the gen3_miniloader.bin.usb image seems to
-            // cause the device to reset and reconnect. Suppress reporting this as a failure.
-            if (m_requestedImageName == "gen3_miniloader.bin.usb") {
-                log(ASTRA_LOG_LEVEL_WARNING) << "Device disconnected: after sending gen3_miniloader.bin.usb" << endLog;
-            } else {
-                // device disappeared or reported an error.
-                // If this occurred during boot or an update then report a failure.
-                // This this happened after and successful update then this is just
-                // the device rebooting so report success.
-                log(ASTRA_LOG_LEVEL_DEBUG) << "Device disconnected: shutting down" << endLog;
-                if (m_status == ASTRA_DEVICE_STATUS_UPDATE_PROGRESS) {
-                    m_status = ASTRA_DEVICE_STATUS_UPDATE_FAIL;
-                } else if (m_status == ASTRA_DEVICE_STATUS_BOOT_PROGRESS) {
-                    m_status = ASTRA_DEVICE_STATUS_BOOT_FAIL;
-                }
-                if (m_status != ASTRA_DEVICE_STATUS_UPDATE_COMPLETE && m_status != ASTRA_DEVICE_STATUS_BOOT_COMPLETE) {
-                    // ASTRA_DEVICE_STATUS_UPDATE_COMPLETE and ASTRA_DEVICE_STATUS_BOOT_COMPLETE will get sent
-                    // from WaitForCompletion.
-                    SendStatus(m_status, 0, "", "Device disconnected");
-                }
-            }
-            m_running.store(false);
-            m_deviceEventCV.notify_all();
+        std::vector<AstraDeviceTransition> trace = m_state.GetTrace();
+        for (size_t i = 0; i < trace.size(); ++i) {
+            auto elapsed = i == 0 ? std::chrono::steady_clock::duration::zero() : trace[i].m_time - trace[i - 1].m_time;
+            log(ASTRA_LOG_LEVEL_INFO) << m_deviceName << ": " << AstraDeviceStatusToString(trace[i].m_from) << " -> "
+                << AstraDeviceStatusToString(trace[i].m_to) << " after "
+                << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() << " ms" << endLog;
         }
     }
 
-    int UpdateImageSizeRequestFile(uint32_t fileSize)
+    bool IsLastFlashTarget() const
+    {
+        return m_flashTarget + 1 >= m_flashTargets.size();
+    }
+
+    // Load the images and flash command of the current target. The first target's
+    // command is run from uEnv.txt or sent at the first prompt, later ones are sent
+    // by StartNextFlashTarget().
+    void StartFlashTarget()
     {
         ASTRA_LOG;
 
-        if (m_imageType > 0x79)
-        {
-            std::string imageName = m_sizeRequestImage->GetPath();
-            FILE *sizeFile = fopen(imageName.c_str(), "wb");
-            if (!sizeFile) {
-                log(ASTRA_LOG_LEVEL_ERROR) << "Failed to open " << imageName << " file" << endLog;
-                return -1;
-            }
-            log(ASTRA_LOG_LEVEL_DEBUG) << "Writing image size to 07_IMAGE: " << fileSize << endLog;
+        std::shared_ptr<FlashImage> flashImage = m_flashTargets[m_flashTarget];
+        bool lastTarget = IsLastFlashTarget();
 
-            if (fwrite(&fileSize, sizeof(fileSize), 1, sizeFile) != 1) {
-                log(ASTRA_LOG_LEVEL_ERROR) << "Failed to write image size to file" << endLog;
-                fclose(sizeFile);
-                return -1;
-            }
-            fflush(sizeFile);
-            fclose(sizeFile);
+        m_finalUpdateImage = flashImage->GetFinalImage();
+        m_resetWhenComplete = lastTarget && flashImage->GetResetWhenComplete();
+        m_flashCommand = flashImage->GetFlashCommand(lastTarget);
+        m_waitForSizeRequest = false;
+        m_flashTargetWritten = false;
+        m_consoleUpdateImage = flashImage->GetRequiresConsole() ? flashImage : nullptr;
+
+        AddImages(flashImage->GetImages());
+
+        if (flashImage->GetUseFastboot()) {
+            // The flash command switches U-Boot to fastboot, which reconnects with a different
+            // VID:PID. The manager hands the new device to AttachFastbootDevice.
+            m_fastbootImage = flashImage;
+            m_waitingForFastboot.store(true);
+            m_flashWatchdog.Arm(m_timeouts.m_fastbootAttach, [this] {
+                OnFastbootAttachTimeout();
+            });
+        } else if (m_consoleUpdateImage) {
+            m_flashWatchdog.Arm(m_timeouts.m_flashCommand, [this] {
+                OnFlashCommandTimeout();
+            });
+        } else {
+            m_flashWatchdog.Cancel();
         }
-
-        return 0;
     }
 
-    int SendImage(Image *image)
+    // Called on the strand with U-Boot at the prompt after a target other than the
+    // last has been written
+    void StartNextFlashTarget(uint64_t promptCount)
     {
         ASTRA_LOG;
 
-        int ret;
-        int totalTransferred = 0;
-        int transferred = 0;
-
-        ret = image->Load();
-        if (ret < 0) {
-            log(ASTRA_LOG_LEVEL_ERROR) << "Failed to load image" << endLog;
-            return ret;
+        if (m_shutdown.load() || m_state.Get() != ASTRA_DEVICE_STATUS_UPDATE_PROGRESS) {
+            Finish();
+            return;
         }
 
-        SendStatus(ASTRA_DEVICE_STATUS_IMAGE_SEND_START, 0, image->GetName());
+        ++m_flashTarget;
+        log(ASTRA_LOG_LEVEL_INFO) << m_deviceName << ": starting flash target " << m_flashTarget + 1 << " of "
+            << m_flashTargets.size() << endLog;
 
-        const int imageHeaderSize = sizeof(uint32_t) * 2;
-        uint32_t imageSizeLE = HostToLE(image->GetSize());
-        std::memset(m_imageBuffer, 0, imageHeaderSize);
-        std::memcpy(m_imageBuffer, &imageSizeLE, sizeof(imageSizeLE));
+        StartFlashTarget();
+        m_flashCommandPromptCount = promptCount;
+        SendToConsole(m_flashCommand + "\n");
+    }
 
-        const int totalTransferSize = image->GetSize() + imageHeaderSize;
+    // The current target has been written. Only the last one completes the update.
+    void CompleteFlashTarget()
+    {
+        ASTRA_LOG;
 
-        // Send the image header
-        ret = m_usbDevice->Write(m_imageBuffer, imageHeaderSize, &transferred);
-        if (ret < 0) {
-            log(ASTRA_LOG_LEVEL_ERROR) << "Failed to write image" << endLog;
-            SendStatus(ASTRA_DEVICE_STATUS_IMAGE_SEND_FAIL, 0, image->GetName(),
-                "Failed to write image");
-            return ret;
+        if (IsLastFlashTarget()) {
+            m_state.Transition(ASTRA_DEVICE_STATUS_UPDATE_COMPLETE);
+            return;
         }
 
-        totalTransferred += transferred;
+        log(ASTRA_LOG_LEVEL_INFO) << m_deviceName << ": flash target " << m_flashTarget + 1 << " of "
+            << m_flashTargets.size() << " written" << endLog;
+        m_flashTargetWritten = true;
+    }
 
-        SendStatus(ASTRA_DEVICE_STATUS_IMAGE_SEND_PROGRESS,
-            ((double)totalTransferred / totalTransferSize) * 100, image->GetName());
+    // Console scripts and fastboot block on the device for minutes, so they run
+    // outside the reactor pool and post back to the strand when they are done.
+    void StartJob(int (AstraDeviceImpl::*job)())
+    {
+        ASTRA_LOG;
 
-        log(ASTRA_LOG_LEVEL_DEBUG) << "Total transfer size: " << totalTransferSize << endLog;
-        log(ASTRA_LOG_LEVEL_DEBUG) << "Total transferred: " << totalTransferred << endLog;
-        while (totalTransferred < totalTransferSize) {
-            int dataBlockSize = image->GetDataBlock(m_imageBuffer, m_imageBufferSize);
-            if (dataBlockSize < 0) {
-                log(ASTRA_LOG_LEVEL_ERROR) << "Failed to get data block" << endLog;
-                SendStatus(ASTRA_DEVICE_STATUS_IMAGE_SEND_FAIL, 0,
-                    image->GetName(), "Failed to get data block");
-                return -1;
-            }
+        if (m_shutdown.load() || m_jobRunning) {
+            return;
+        }
 
-            ret = m_usbDevice->Write(m_imageBuffer, dataBlockSize, &transferred);
-            if (ret < 0) {
-                log(ASTRA_LOG_LEVEL_ERROR) << "Failed to write image" << endLog;
-                SendStatus(ASTRA_DEVICE_STATUS_IMAGE_SEND_FAIL, 0, image->GetName(), "Failed to write image");
-                return ret;
-            }
+        m_flashWatchdog.Cancel();
+        m_jobRunning = true;
 
-            totalTransferred += transferred;
+        // The reactor closes the session to stop a job still running at shutdown.
+        // The job clears m_session before posting its result, after which the
+        // session may be destroyed.
+        auto cancel = std::make_shared<JobCancel>();
+        cancel->m_session = this;
 
-            SendStatus(ASTRA_DEVICE_STATUS_IMAGE_SEND_PROGRESS,
-                ((double)totalTransferred / totalTransferSize) * 100, image->GetName());
-        }
+        m_strand->GetReactor().PostBlocking([this, job, cancel] {
+            int ret = (this->*job)();
+            {
+                std::lock_guard<std::mutex> lock(cancel->m_mutex);
+                cancel->m_session = nullptr;
+            }
+            m_strand->Post([this, ret] {
+                ASTRA_LOG;
+
+                log(ASTRA_LOG_LEVEL_DEBUG) << "Job complete: " << ret << endLog;
+                m_jobRunning = false;
+                if (ret >= 0 && m_flashTargetWritten && !m_retired) {
+                    // The console script left U-Boot at the prompt for the next target
+                    StartNextFlashTarget(m_console->GetPromptCount());
+                    return;
+                }
+                Finish();
+                if (m_retired) {
+                    CloseStrand();
+                }
+            });
+        }, [cancel] {
+            std::lock_guard<std::mutex> lock(cancel->m_mutex);
+            if (cancel->m_session) {
+                cancel->m_session->Close();
+            }
+        });
+    }
 
-        if (totalTransferred != totalTransferSize) {
-            log(ASTRA_LOG_LEVEL_ERROR) << "Failed to transfer entire image" << endLog;
-            SendStatus(ASTRA_DEVICE_STATUS_IMAGE_SEND_FAIL, 0, image->GetName(), "Failed to transfer entire image");
-            return -1;
-        }
+    // Runs on the strand after Close(). Timers and USB callbacks which still post to
+    // the strand are dropped from here on, so the session can be destroyed.
+    void CloseStrand()
+    {
+        ASTRA_LOG;
 
-        ret = UpdateImageSizeRequestFile(image->GetSize());
-        if (ret < 0) {
-            log(ASTRA_LOG_LEVEL_ERROR) << "Failed to update image size request file" << endLog;
-        }
+        m_strand->Close();
 
-        SendStatus(ASTRA_DEVICE_STATUS_IMAGE_SEND_COMPLETE, 100, image->GetName());
+        if (m_removeFilesOnRetire && !m_deviceDir.empty()) {
+            std::error_code ec;
+            std::filesystem::remove_all(m_deviceDir, ec);
+            if (ec) {
+                log(ASTRA_LOG_LEVEL_WARNING) << "Failed to remove " << m_deviceDir << ": " << ec.message() << endLog;
+            }
+        }
 
-        return 0;
+        std::function<void()> retired = std::move(m_retired);
+        m_retired = nullptr;
+        m_strand->GetReactor().Post(retired);
     }
 
-    int HandleImageRequests()
+    void HandleInterrupt(uint8_t *buf, size_t size)
     {
         ASTRA_LOG;
 
-        int ret = 0;
+        log(ASTRA_LOG_LEVEL_DEBUG) << "Interrupt received: size:" << size << endLog;
 
-        log(ASTRA_LOG_LEVEL_DEBUG) << "Signal image request thread ready" << endLog;
+        // Parsed in place, console output is appended without a copy
+        std::string_view message(reinterpret_cast<char *>(buf), size);
 
-        m_imageRequestThreadReady.store(true);
-        m_imageRequestThreadReadyCV.notify_all();
+        auto it = message.find(m_imageRequestString);
+        if (it != std::string_view::npos) {
+            it += m_imageRequestString.size();
+            uint8_t imageType = buf[it];
+            log(ASTRA_LOG_LEVEL_DEBUG) << "Image type: " << std::hex << imageType << std::dec << endLog;
+            std::string_view imageName = message.substr(it + 1);
 
-        bool waitForSizeRequest = false;
+            // Strip off Null character
+            size_t end = imageName.find_last_not_of('\0');
+            if (end != std::string_view::npos) {
+                imageName = imageName.substr(0, end + 1);
+            }
+            log(ASTRA_LOG_LEVEL_DEBUG) << "Requested image name: '" << imageName << "'" << endLog;
 
-        while (true) {
-            bool notified = false;
+            m_strand->Post([this, imageType, imageName = std::string(imageName)] {
+                OnImageRequest(imageType, imageName);
+            });
+        } else {
+            m_console->Append(message);
+        }
+    }
 
-            {
-                std::unique_lock<std::mutex> lock(m_imageRequestMutex);
-                log(ASTRA_LOG_LEVEL_DEBUG) << "before  m_imageRequestCV.wait()" << endLog;
+    int OpenUSBDevice()
+    {
+        uint32_t generation = ++m_usbGeneration;
 
-                auto timeout = std::chrono::seconds(10);
+        return m_usbDevice->Open([this, generation](USBDevice::USBEvent event, uint8_t *buf, size_t size) {
+            USBEventHandler(generation, event, buf, size);
+        });
+    }
 
-                notified = m_imageRequestCV.wait_for(lock, timeout, [this] {
-                    bool previousValue = m_imageRequestReady.load();
-                    if (previousValue) {
-                        m_imageRequestReady.store(false);
-                    }
-                    return previousValue  || !m_running.load();
-                });
-            }
+    void USBEventHandler(uint32_t generation, USBDevice::USBEvent event, uint8_t *buf, size_t size)
+    {
+        ASTRA_LOG;
 
-            log(ASTRA_LOG_LEVEL_DEBUG) << "after m_imageRequestCV.wait()" << endLog;
-            if (!m_running.load()) {
-                log(ASTRA_LOG_LEVEL_DEBUG) << "Image Request received when AstraDevice is not running" << endLog;
-                return 0;
-            }
+        if (event == USBDevice::USB_DEVICE_EVENT_INTERRUPT) {
+            HandleInterrupt(buf, size);
+        } else if (event == USBDevice::USB_DEVICE_EVENT_NO_DEVICE || event == USBDevice::USB_DEVICE_EVENT_TRANSFER_CANCELED ||
+            event == USBDevice::USB_DEVICE_EVENT_TRANSFER_ERROR)
+        {
+            m_strand->Post([this, generation] {
+                OnDisconnect(generation);
+            });
+        }
+    }
 
-            if (!notified) {
-                log(ASTRA_LOG_LEVEL_DEBUG) << "Timeout waiting for image request" << endLog;
-                if (m_status == ASTRA_DEVICE_STATUS_BOOT_PROGRESS) {
-                    SendStatus(ASTRA_DEVICE_STATUS_BOOT_FAIL, 0, "", "Timeout during boot, press RESET while holding USB_BOOT to try again");
-                    return -1;
-                } else {
-                    continue;
-                }
-            }
+    void OnDisconnect(uint32_t generation)
+    {
+        ASTRA_LOG;
 
-            std::string imageNamePrefix;
+        if (m_shutdown.load() || !m_running.load() || generation != m_usbGeneration.load()) {
+            return;
+        }
 
-            if (m_requestedImageName.find('/') != std::string::npos) {
-                size_t pos = m_requestedImageName.find('/');
-                imageNamePrefix = m_requestedImageName.substr(0, pos);
-                m_requestedImageName = m_requestedImageName.substr(pos + 1);
-                log(ASTRA_LOG_LEVEL_DEBUG) << "Requested image name prefix: '" << imageNamePrefix << "', requested Image Name: '" << m_requestedImageName << "'" << endLog;
-            }
+        // When using SU-Boot the gen3_miniloader.bin.usb image seems to
+        // cause the device to reset and reconnect on the same port. Keep the
+        // session so AttachDevice() can resume the boot with the new device.
+        if (m_requestedImageName == "gen3_miniloader.bin.usb") {
+            m_running.store(false);
+            m_strand->CancelTimer(m_bootRequestTimer);
 
+            bool reattached;
             {
-                std::lock_guard<std::mutex> lock(m_imageMutex);
-                auto it = std::find_if(m_images.begin(), m_images.end(), [requestedImageName = m_requestedImageName](const Image &img) {
-                    return img.GetName() == requestedImageName;
-                });
-
-                Image *image;
-                if (it == m_images.end()) {
-                    log(ASTRA_LOG_LEVEL_ERROR) << "Requested image not found: " << m_requestedImageName << endLog;
-                    if (m_status == ASTRA_DEVICE_STATUS_BOOT_START || m_status == ASTRA_DEVICE_STATUS_BOOT_PROGRESS) {
-                        SendStatus(ASTRA_DEVICE_STATUS_BOOT_FAIL, 0, m_requestedImageName, m_requestedImageName + " image not found");
-                    } else if (m_status == ASTRA_DEVICE_STATUS_UPDATE_START || m_status == ASTRA_DEVICE_STATUS_UPDATE_PROGRESS) {
-                        SendStatus(ASTRA_DEVICE_STATUS_UPDATE_FAIL, 0, m_requestedImageName, m_requestedImageName + " image not found");
-                    } else {
-                        log(ASTRA_LOG_LEVEL_WARNING) << "Requested image not found: " << m_requestedImageName << " while in "
-                            << AstraDeviceStatusToString(m_status) << endLog;
-                    }
-                    return -1;
+                std::lock_guard<std::mutex> lock(m_closeMutex);
+                reattached = m_reattachDevice != nullptr;
+                m_waitingForReattach.store(!reattached);
+            }
+            if (reattached) {
+                OnReattach();
+                return;
+            }
+
+            log(ASTRA_LOG_LEVEL_INFO) << "Device disconnected after gen3_miniloader.bin.usb, waiting for it to reconnect" << endLog;
+            m_reattachTimer = StartWatchdog(m_timeouts.m_reattach, [this] {
+                OnReattachTimeout();
+            });
+            return;
+        } else if (m_waitingForFastboot.load() && m_state.Get() != ASTRA_DEVICE_STATUS_BOOT_START &&
+            m_state.Get() != ASTRA_DEVICE_STATUS_BOOT_PROGRESS)
+        {
+            // U-Boot disconnects when it switches to fastboot
+            log(ASTRA_LOG_LEVEL_DEBUG) << "Device disconnected: waiting for fastboot device" << endLog;
+            return;
+        } else {
+            // device disappeared or reported an error.
+            // If this occurred during boot or an update then report a failure.
+            // This this happened after and successful update then this is just
+            // the device rebooting so report success.
+            log(ASTRA_LOG_LEVEL_DEBUG) << "Device disconnected: shutting down" << endLog;
+            m_state.Transition(ASTRA_DEVICE_STATUS_UPDATE_PROGRESS, ASTRA_DEVICE_STATUS_UPDATE_FAIL) ||
+                m_state.Transition(ASTRA_DEVICE_STATUS_BOOT_PROGRESS, ASTRA_DEVICE_STATUS_BOOT_FAIL);
+            AstraDeviceStatus status = m_state.Get();
+            if (status != ASTRA_DEVICE_STATUS_UPDATE_COMPLETE && status != ASTRA_DEVICE_STATUS_BOOT_COMPLETE) {
+                SendStatus(status, 0, ASTRA_NAME_NONE, ASTRA_DEVICE_MESSAGE_DEVICE_DISCONNECTED);
+            }
+        }
+        m_running.store(false);
+
+        if (m_jobRunning) {
+            // The job sees the disconnect and finishes the session
+            return;
+        }
+
+        AstraDeviceStatus status = m_state.Get();
+        if (m_bootOnly) {
+            if (status == ASTRA_DEVICE_STATUS_BOOT_COMPLETE) {
+                // Device successfully reset after boot
+                SendStatus(status, 100, ASTRA_NAME_NONE, ASTRA_DEVICE_MESSAGE_SUCCESS);
+            }
+        } else if (status == ASTRA_DEVICE_STATUS_UPDATE_COMPLETE) {
+            // Device successfully reset after update
+            SendStatus(status, 100, ASTRA_NAME_NONE, ASTRA_DEVICE_MESSAGE_SUCCESS);
+        }
+
+        Finish();
+    }
+
+    void OnReattach()
+    {
+        ASTRA_LOG;
+
+        m_strand->CancelTimer(m_reattachTimer);
+
+        std::unique_ptr<USBDevice> previousDevice;
+        {
+            std::lock_guard<std::mutex> lock(m_closeMutex);
+            if (m_shutdown.load() || !m_reattachDevice) {
+                return;
+            }
+            previousDevice = std::move(m_usbDevice);
+            m_usbDevice = std::move(m_reattachDevice);
+            m_reattachExpected = false;
+        }
+        previousDevice->Close();
+
+        int ret = OpenUSBDevice();
+        if (ret < 0) {
+            FailSession(ASTRA_DEVICE_MESSAGE_REATTACH_OPEN_FAILED);
+            return;
+        }
+
+        const std::string &serialNumber = m_usbDevice->GetSerialNumber();
+        if (!m_serialNumber.empty() && !serialNumber.empty() && serialNumber != m_serialNumber) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "Serial number changed from " << m_serialNumber << " to " << serialNumber << endLog;
+            FailSession(ASTRA_DEVICE_MESSAGE_REATTACH_WRONG_DEVICE, m_usbPath);
+            return;
+        }
+
+        m_running.store(true);
+        ret = m_usbDevice->EnableInterrupts();
+        if (ret < 0) {
+            FailSession(ASTRA_DEVICE_MESSAGE_REATTACH_START_FAILED);
+            return;
+        }
+
+        ++m_reattachCount;
+        log(ASTRA_LOG_LEVEL_INFO) << "Session resumed after " << m_reattachCount << " reconnect(s)" << endLog;
+
+        // The boot continues with the next image request
+        if (m_state.Get() == ASTRA_DEVICE_STATUS_BOOT_PROGRESS) {
+            m_bootRequestTimer = StartWatchdog(m_timeouts.m_bootRequest, [this] {
+                OnBootRequestTimeout();
+            });
+        }
+    }
+
+    void OnReattachTimeout()
+    {
+        ASTRA_LOG;
+
+        if (m_shutdown.load() || !m_waitingForReattach.exchange(false)) {
+            return;
+        }
+
+        FailSession(ASTRA_DEVICE_MESSAGE_REATTACH_TIMEOUT);
+    }
+
+    // Common failure path for errors and expired watchdogs. Reports the failure
+    // for the current phase and finishes the session so the manager closes it.
+    void FailSession(AstraDeviceMessage message, const std::string &detail = "")
+    {
+        ASTRA_LOG;
+
+        log(ASTRA_LOG_LEVEL_ERROR) << AstraDeviceMessageToString(message) << (detail.empty() ? "" : ": ") << detail << endLog;
+
+        AstraDeviceStatus status = m_state.Get();
+        if (status == ASTRA_DEVICE_STATUS_OPENED || status == ASTRA_DEVICE_STATUS_BOOT_START ||
+            status == ASTRA_DEVICE_STATUS_BOOT_PROGRESS)
+        {
+            m_state.Transition(ASTRA_DEVICE_STATUS_BOOT_FAIL);
+        } else if (status == ASTRA_DEVICE_STATUS_BOOT_COMPLETE || status == ASTRA_DEVICE_STATUS_UPDATE_START ||
+            status == ASTRA_DEVICE_STATUS_UPDATE_PROGRESS)
+        {
+            m_state.Transition(ASTRA_DEVICE_STATUS_UPDATE_FAIL);
+        }
+        SendStatus(m_state.Get(), 0, ASTRA_NAME_NONE, message);
+
+        m_imageRequestsStopped = true;
+        m_strand->CancelTimer(m_retryTimer);
+        m_strand->CancelTimer(m_throttleTimer);
+        m_strand->CancelTimer(m_stallTimer);
+        if (!m_writePending) {
+            // Otherwise released when the write completes or is cancelled by Close()
+            m_sendImage = nullptr;
+            m_transferBuffer.reset();
+        }
+
+        Finish();
+    }
+
+    AstraReactor::TimerId StartWatchdog(std::chrono::seconds timeout, AstraReactor::Task task)
+    {
+        if (timeout.count() == 0) {
+            return 0;
+        }
+
+        return m_strand->PostAfter(timeout, std::move(task));
+    }
+
+    void OnPhaseDeadline(bool boot)
+    {
+        ASTRA_LOG;
+
+        if (m_shutdown.load() || m_imageRequestsStopped) {
+            return;
+        }
+
+        AstraDeviceStatus status = m_state.Get();
+        if (boot && (status == ASTRA_DEVICE_STATUS_BOOT_START || status == ASTRA_DEVICE_STATUS_BOOT_PROGRESS)) {
+            FailSession(ASTRA_DEVICE_MESSAGE_BOOT_TIMEOUT, std::to_string(m_timeouts.m_boot.count()) + " seconds");
+        } else if (!boot && (status == ASTRA_DEVICE_STATUS_BOOT_COMPLETE || status == ASTRA_DEVICE_STATUS_UPDATE_START ||
+            status == ASTRA_DEVICE_STATUS_UPDATE_PROGRESS))
+        {
+            FailSession(ASTRA_DEVICE_MESSAGE_UPDATE_TIMEOUT, std::to_string(m_timeouts.m_update.count()) + " seconds");
+        }
+    }
+
+    void StartStallWatch()
+    {
+        m_strand->CancelTimer(m_stallTimer);
+        m_stallLastBytes = m_progressTotalBytes.load(std::memory_order_relaxed);
+        m_stallLastProgress = std::chrono::steady_clock::now();
+        if (m_timeouts.m_stall.count() != 0) {
+            m_stallTimer = m_strand->PostAfter(m_stallCheckInterval, [this] {
+                OnStallCheck();
+            });
+        }
+    }
+
+    // Fails the transfer when the device has not acknowledged any data for the stall timeout
+    void OnStallCheck()
+    {
+        ASTRA_LOG;
+
+        if (m_shutdown.load() || !m_sendImage || m_imageRequestsStopped) {
+            return;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        uint64_t bytes = m_progressTotalBytes.load(std::memory_order_relaxed);
+        if (bytes != m_stallLastBytes) {
+            m_stallLastBytes = bytes;
+            m_stallLastProgress = now;
+        } else if (now - m_stallLastProgress >= m_timeouts.m_stall) {
+            SendStatus(ASTRA_DEVICE_STATUS_IMAGE_SEND_FAIL, 0, m_sendImageId, ASTRA_DEVICE_MESSAGE_TRANSFER_STALLED);
+            FailSession(ASTRA_DEVICE_MESSAGE_TRANSFER_STALLED, "no data for " + std::to_string(m_timeouts.m_stall.count()) + " seconds");
+            return;
+        }
+
+        m_stallTimer = m_strand->PostAfter(m_stallCheckInterval, [this] {
+            OnStallCheck();
+        });
+    }
+
+    void OnConsolePrompt(uint64_t promptCount)
+    {
+        ASTRA_LOG;
+
+        if (m_shutdown.load() || m_jobRunning) {
+            // A running console job waits for its own prompts
+            return;
+        }
+
+        if (m_sendFlashCommand) {
+            m_sendFlashCommand = false;
+            m_flashCommandPromptCount = promptCount;
+            SendToConsole(m_flashCommand + "\n");
+            return;
+        }
+
+        if (m_fastbootImage) {
+            // Completes from AttachFastbootDevice
+            return;
+        }
+
+        if (m_consoleUpdateImage) {
+            // The flash command finished loading the image
+            if (promptCount > m_flashCommandPromptCount) {
+                StartJob(&AstraDeviceImpl::RunConsoleUpdate);
+            }
+            return;
+        }
+
+        if (!IsLastFlashTarget()) {
+            // The target's flash command has finished without resetting the device
+            if (promptCount > m_flashCommandPromptCount) {
+                if (m_flashTargetWritten) {
+                    StartNextFlashTarget(promptCount);
                 } else {
-                    image = &(*it);
+                    FailSession(ASTRA_DEVICE_MESSAGE_FLASH_TARGET_FAILED, "target " + std::to_string(m_flashTarget + 1));
+                }
+            }
+            return;
+        }
+
+        if (m_uEnvSupport || m_ubootConsole == ASTRA_UBOOT_CONSOLE_UART) {
+            // Completes when the device disconnects
+            return;
+        }
+
+        if (m_resetWhenComplete) {
+            SendToConsole("reset\n");
+        }
+        // Update does not require a reset, but the
+        // console is back at the U-Boot prompt.
+        if (m_state.Get() == ASTRA_DEVICE_STATUS_UPDATE_COMPLETE) {
+            SendStatus(ASTRA_DEVICE_STATUS_UPDATE_COMPLETE, 100, ASTRA_NAME_NONE, ASTRA_DEVICE_MESSAGE_SUCCESS);
+        }
+
+        Finish();
+    }
+
+    void OnFlashCommandTimeout()
+    {
+        ASTRA_LOG;
+
+        if (m_shutdown.load() || m_jobRunning || !m_running.load() || m_imageRequestsStopped) {
+            return;
+        }
+
+        FailSession(ASTRA_DEVICE_MESSAGE_FLASH_COMMAND_TIMEOUT, std::to_string(m_timeouts.m_flashCommand.count()) + " seconds");
+    }
+
+    void OnFastbootAttachTimeout()
+    {
+        ASTRA_LOG;
+
+        if (m_shutdown.load() || !m_waitingForFastboot.exchange(false)) {
+            return;
+        }
+
+        FailSession(ASTRA_DEVICE_MESSAGE_FASTBOOT_TIMEOUT, std::to_string(m_timeouts.m_fastbootAttach.count()) + " seconds");
+    }
+
+    void OnBootRequestTimeout()
+    {
+        ASTRA_LOG;
+
+        if (m_shutdown.load() || m_sendImage || m_imageRequestsStopped) {
+            return;
+        }
+
+        log(ASTRA_LOG_LEVEL_DEBUG) << "Timeout waiting for image request" << endLog;
+        if (m_state.Get() == ASTRA_DEVICE_STATUS_BOOT_PROGRESS) {
+            FailSession(ASTRA_DEVICE_MESSAGE_BOOT_REQUEST_TIMEOUT);
+        }
+    }
+
+    void AddImages(const std::vector<Image> &images)
+    {
+        ASTRA_LOG;
+
+        std::lock_guard<std::mutex> lock(m_imageTableWriteMutex);
+        if (m_shutdown.load()) {
+            return;
+        }
+
+        // The table and the images are allocated from the session pool
+        auto imageTable = m_memory.MakeShared<ImageTable>(*std::atomic_load(&m_imageTable));
+        for (const auto &image : images) {
+            imageTable->push_back({m_memory.MakeShared<Image>(image), AstraNames::Intern(image.GetName())});
+        }
+
+        log(ASTRA_LOG_LEVEL_DEBUG) << "Image table now has " << imageTable->size() << " images" << endLog;
+        std::atomic_store(&m_imageTable, std::shared_ptr<const ImageTable>(std::move(imageTable)));
+    }
+
+    ImageEntry FindImage(const std::string &imageName)
+    {
+        std::shared_ptr<const ImageTable> imageTable = std::atomic_load(&m_imageTable);
+
+        // Newest first, so a later flash target's image is found before an earlier one with the same name
+        auto it = std::find_if(imageTable->rbegin(), imageTable->rend(), [&imageName](const ImageEntry &entry) {
+            return entry.m_image->GetName() == imageName;
+        });
+
+        return it != imageTable->rend() ? *it : ImageEntry{nullptr, ASTRA_NAME_NONE};
+    }
+
+    int UpdateImageSizeRequestFile(uint32_t fileSize)
+    {
+        ASTRA_LOG;
+
+        if (m_imageType > 0x79)
+        {
+            std::string imageName = m_sizeRequestImage->GetPath();
+            FILE *sizeFile = fopen(imageName.c_str(), "wb");
+            if (!sizeFile) {
+                log(ASTRA_LOG_LEVEL_ERROR) << "Failed to open " << imageName << " file" << endLog;
+                return -1;
+            }
+            log(ASTRA_LOG_LEVEL_DEBUG) << "Writing image size to 07_IMAGE: " << fileSize << endLog;
+
+            if (fwrite(&fileSize, sizeof(fileSize), 1, sizeFile) != 1) {
+                log(ASTRA_LOG_LEVEL_ERROR) << "Failed to write image size to file" << endLog;
+                fclose(sizeFile);
+                return -1;
+            }
+            fflush(sizeFile);
+            fclose(sizeFile);
+        }
+
+        return 0;
+    }
+
+    void OnImageRequest(uint8_t imageType, std::string requestedImageName)
+    {
+        ASTRA_LOG;
+
+        if (m_shutdown.load() || !m_running.load() || m_imageRequestsStopped) {
+            log(ASTRA_LOG_LEVEL_DEBUG) << "Image Request received when AstraDevice is not running" << endLog;
+            return;
+        }
+
+        if (m_sendImage) {
+            log(ASTRA_LOG_LEVEL_WARNING) << "Image request for " << requestedImageName << " while sending " << m_sendImage->GetName() << endLog;
+            return;
+        }
+
+        m_strand->CancelTimer(m_bootRequestTimer);
+
+        if (!m_bootOnly) {
+            m_state.Transition(ASTRA_DEVICE_STATUS_BOOT_COMPLETE, ASTRA_DEVICE_STATUS_UPDATE_START);
+        }
+
+        m_imageType = imageType;
+        m_requestedImageName = requestedImageName;
+
+        std::string imageNamePrefix;
+
+        if (m_requestedImageName.find('/') != std::string::npos) {
+            size_t pos = m_requestedImageName.find('/');
+            imageNamePrefix = m_requestedImageName.substr(0, pos);
+            m_requestedImageName = m_requestedImageName.substr(pos + 1);
+            log(ASTRA_LOG_LEVEL_DEBUG) << "Requested image name prefix: '" << imageNamePrefix << "', requested Image Name: '" << m_requestedImageName << "'" << endLog;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_closeMutex);
+            m_reattachExpected = m_requestedImageName == "gen3_miniloader.bin.usb";
+        }
+
+        ImageEntry entry = FindImage(m_requestedImageName);
+        if (!entry.m_image) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "Requested image not found: " << m_requestedImageName << endLog;
+            AstraNameId requestedImageId = AstraNames::Intern(m_requestedImageName);
+            AstraDeviceStatus status = m_state.Get();
+            if (status == ASTRA_DEVICE_STATUS_BOOT_START || status == ASTRA_DEVICE_STATUS_BOOT_PROGRESS) {
+                SendStatus(ASTRA_DEVICE_STATUS_BOOT_FAIL, 0, requestedImageId, ASTRA_DEVICE_MESSAGE_IMAGE_NOT_FOUND);
+            } else if (status == ASTRA_DEVICE_STATUS_UPDATE_START || status == ASTRA_DEVICE_STATUS_UPDATE_PROGRESS) {
+                SendStatus(ASTRA_DEVICE_STATUS_UPDATE_FAIL, 0, requestedImageId, ASTRA_DEVICE_MESSAGE_IMAGE_NOT_FOUND);
+            } else {
+                log(ASTRA_LOG_LEVEL_WARNING) << "Requested image not found: " << m_requestedImageName << " while in "
+                    << AstraDeviceStatusToString(status) << endLog;
+            }
+            m_imageRequestsStopped = true;
+            return;
+        }
+
+        if (m_state.Transition(ASTRA_DEVICE_STATUS_BOOT_START, ASTRA_DEVICE_STATUS_BOOT_PROGRESS)) {
+            log(ASTRA_LOG_LEVEL_DEBUG) << "Boot status set to ASTRA_DEVICE_STATUS_BOOT_PROGRESS" << endLog;
+        } else if (m_state.Transition(ASTRA_DEVICE_STATUS_UPDATE_START, ASTRA_DEVICE_STATUS_UPDATE_PROGRESS)) {
+            log(ASTRA_LOG_LEVEL_DEBUG) << "Update status set to ASTRA_DEVICE_STATUS_UPDATE_PROGRESS" << endLog;
+        }
+
+        StartSendImage(entry.m_image, entry.m_nameId);
+    }
+
+    // Sends the image as a chain of asynchronous bulk writes. Each completion
+    // is posted back to the strand which queues the next block.
+    void StartSendImage(std::shared_ptr<Image> image, AstraNameId imageId)
+    {
+        ASTRA_LOG;
+
+        m_sendImageId = imageId;
+
+        if (!m_transferBuffer) {
+            // The pool may call the waiter after Close() has cancelled it, so it holds
+            // the strand rather than reading it from the session. Once the strand is
+            // closed the task is dropped and the buffer goes back to the pool.
+            int ret = TransferBufferPool::GetInstance().Acquire(m_transferBuffer, this,
+                [strand = m_strand, this, image, imageId](TransferBufferPool::Buffer buffer) {
+                    strand->Post([this, image, imageId, buffer] {
+                        OnTransferBufferAvailable(image, imageId, buffer);
+                    });
+                });
+            if (ret < 0) {
+                SendStatus(ASTRA_DEVICE_STATUS_IMAGE_SEND_FAIL, 0, imageId, ASTRA_DEVICE_MESSAGE_BUFFER_ALLOCATION_FAILED);
+                OnImageSent(image, ret);
+                return;
+            } else if (ret > 0) {
+                // Hold off further image requests until the buffer arrives
+                log(ASTRA_LOG_LEVEL_DEBUG) << "Waiting for a transfer buffer" << endLog;
+                m_sendImage = image;
+                return;
+            }
+        }
+
+        int ret = image->Load();
+        if (ret < 0) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "Failed to load image" << endLog;
+            OnImageSent(image, ret);
+            return;
+        }
+
+        if (image->GetSize() > UINT32_MAX) {
+            // The image header only has room for a 32 bit size. Large images
+            // should have been split into chunks when the flash image was loaded.
+            log(ASTRA_LOG_LEVEL_ERROR) << "Image too large to send: " << image->GetName() << " size: " << image->GetSize() << endLog;
+            SendStatus(ASTRA_DEVICE_STATUS_IMAGE_SEND_FAIL, 0, imageId, ASTRA_DEVICE_MESSAGE_IMAGE_TOO_LARGE);
+            OnImageSent(image, -1);
+            return;
+        }
+
+        SendStatus(ASTRA_DEVICE_STATUS_IMAGE_SEND_START, 0, imageId);
+
+        const int imageHeaderSize = sizeof(uint32_t) * 2;
+        uint32_t imageSizeLE = HostToLE(static_cast<uint32_t>(image->GetSize()));
+        std::memset(m_transferBuffer.get(), 0, imageHeaderSize);
+        std::memcpy(m_transferBuffer.get(), &imageSizeLE, sizeof(imageSizeLE));
+
+        m_sendImage = image;
+        m_sendTransferred = 0;
+        m_sendTotalSize = image->GetSize() + imageHeaderSize;
+        StartProgress(imageId, m_sendTotalSize);
+        StartStallWatch();
+        log(ASTRA_LOG_LEVEL_DEBUG) << "Total transfer size: " << m_sendTotalSize << endLog;
+
+        // Send the image header
+        WriteImageBlock(imageHeaderSize);
+    }
+
+    void OnTransferBufferAvailable(std::shared_ptr<Image> image, AstraNameId imageId, TransferBufferPool::Buffer buffer)
+    {
+        ASTRA_LOG;
+
+        m_sendImage = nullptr;
+        if (m_shutdown.load() || m_imageRequestsStopped) {
+            return;
+        }
+
+        m_transferBuffer = buffer;
+        StartSendImage(image, imageId);
+    }
+
+    void WriteImageBlock(int size)
+    {
+        m_blockSize = size;
+        m_blockOffset = 0;
+        m_blockRetries = 0;
+
+        SubmitImageBlock();
+    }
+
+    // Writes the part of the current block which the device has not acknowledged yet,
+    // once the hubs above the device have bandwidth for it
+    void SubmitImageBlock()
+    {
+        auto wait = m_topology.Reserve(m_usbPath, m_blockSize - m_blockOffset);
+        if (wait > AstraReactor::Clock::duration::zero()) {
+            m_throttleTimer = m_strand->PostAfter(wait, [this] {
+                if (!m_sendImage) {
+                    return;
+                }
+                if (m_shutdown.load() || m_imageRequestsStopped) {
+                    m_sendImage = nullptr;
+                    m_transferBuffer.reset();
+                    return;
                 }
+                WriteImageBlockData();
+            });
+            return;
+        }
+
+        WriteImageBlockData();
+    }
+
+    void WriteImageBlockData()
+    {
+        ASTRA_LOG;
+
+        int ret = m_usbDevice->WriteAsync(m_transferBuffer.get() + m_blockOffset, m_blockSize - m_blockOffset,
+            [this](int ret, int transferred) {
+                m_strand->Post([this, ret, transferred] {
+                    OnImageBlockWritten(ret, transferred);
+                });
+            });
+        if (ret < 0) {
+            OnImageBlockWritten(ret, 0);
+            return;
+        }
+        m_writePending = true;
+    }
+
+    // A failed or timed out write is retried from the last acknowledged offset
+    // with exponential backoff. A stalled endpoint has already been cleared by USBDevice.
+    void RetryImageBlock(std::shared_ptr<Image> image)
+    {
+        ASTRA_LOG;
+
+        if (m_blockRetries >= m_maxBlockRetries || !m_running.load()) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "Failed to write image after " << m_blockRetries << " retries" << endLog;
+            m_failedBlocks.fetch_add(1, std::memory_order_relaxed);
+            SendStatus(ASTRA_DEVICE_STATUS_IMAGE_SEND_FAIL, 0, m_sendImageId, ASTRA_DEVICE_MESSAGE_WRITE_FAILED);
+            OnImageSent(image, -1);
+            return;
+        }
+
+        auto delay = m_retryBaseDelay * (1 << m_blockRetries);
+        ++m_blockRetries;
+        m_blockRetryCount.fetch_add(1, std::memory_order_relaxed);
+        log(ASTRA_LOG_LEVEL_WARNING) << "Retrying block at offset " << m_blockOffset << " of " << m_blockSize << " in "
+            << delay.count() << " ms, attempt " << m_blockRetries << " of " << m_maxBlockRetries << endLog;
+
+        m_retryTimer = m_strand->PostAfter(delay, [this] {
+            if (!m_sendImage) {
+                return;
+            }
+            if (m_shutdown.load() || m_imageRequestsStopped) {
+                m_sendImage = nullptr;
+                m_transferBuffer.reset();
+                return;
+            }
+            SubmitImageBlock();
+        });
+    }
+
+    void OnImageBlockWritten(int ret, int transferred)
+    {
+        ASTRA_LOG;
+
+        m_writePending = false;
+        std::shared_ptr<Image> image = m_sendImage;
+        if (!image) {
+            return;
+        }
+
+        if (m_shutdown.load() || m_imageRequestsStopped) {
+            m_sendImage = nullptr;
+            m_transferBuffer.reset();
+            return;
+        }
+
+        m_blockOffset += transferred;
+        m_sendTransferred += transferred;
+        AddProgress(transferred);
+
+        if (ret < 0) {
+            RetryImageBlock(image);
+            return;
+        }
+
+        if (m_blockOffset < m_blockSize) {
+            SubmitImageBlock();
+            return;
+        }
+
+        if (m_blockRetries > 0) {
+            m_recoveredBlocks.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (m_sendTransferred < m_sendTotalSize) {
+            int dataBlockSize = image->GetDataBlock(m_transferBuffer.get(), TransferBufferPool::m_bufferSize);
+            if (dataBlockSize < 0) {
+                log(ASTRA_LOG_LEVEL_ERROR) << "Failed to get data block" << endLog;
+                SendStatus(ASTRA_DEVICE_STATUS_IMAGE_SEND_FAIL, 0,
+                    m_sendImageId, ASTRA_DEVICE_MESSAGE_READ_IMAGE_FAILED);
+                OnImageSent(image, -1);
+                return;
+            }
+
+            WriteImageBlock(dataBlockSize);
+            return;
+        }
+
+        if (m_sendTransferred != m_sendTotalSize) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "Failed to transfer entire image" << endLog;
+            SendStatus(ASTRA_DEVICE_STATUS_IMAGE_SEND_FAIL, 0, m_sendImageId, ASTRA_DEVICE_MESSAGE_INCOMPLETE_TRANSFER);
+            OnImageSent(image, -1);
+            return;
+        }
+
+        ret = UpdateImageSizeRequestFile(static_cast<uint32_t>(image->GetSize()));
+        if (ret < 0) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "Failed to update image size request file" << endLog;
+        }
+
+        m_progressImagesSent.fetch_add(1, std::memory_order_relaxed);
+        SendStatus(ASTRA_DEVICE_STATUS_IMAGE_SEND_COMPLETE, 100, m_sendImageId);
+
+        OnImageSent(image, 0);
+    }
+
+    void OnImageSent(std::shared_ptr<Image> image, int ret)
+    {
+        ASTRA_LOG;
+
+        m_sendImage = nullptr;
+        m_transferBuffer.reset();
+        m_strand->CancelTimer(m_stallTimer);
+
+        log(ASTRA_LOG_LEVEL_DEBUG) << "After send image: " << image->GetName() << endLog;
+        if (ret < 0) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "Failed to send image" << endLog;
+            AstraDeviceStatus status = m_state.Get();
+            if (status == ASTRA_DEVICE_STATUS_BOOT_START || status == ASTRA_DEVICE_STATUS_BOOT_PROGRESS) {
+                m_state.Transition(ASTRA_DEVICE_STATUS_BOOT_FAIL);
+            } else if (status == ASTRA_DEVICE_STATUS_UPDATE_START || status == ASTRA_DEVICE_STATUS_UPDATE_PROGRESS) {
+                m_state.Transition(ASTRA_DEVICE_STATUS_UPDATE_FAIL);
+            }
+            SendStatus(m_state.Get(), 0, m_sendImageId, ASTRA_DEVICE_MESSAGE_SEND_FAILED);
+            m_imageRequestsStopped = true;
+            return;
+        }
+
+        log(ASTRA_LOG_LEVEL_DEBUG) << "Image sent successfully: " << image->GetName() << " final boot image '" << m_finalBootImage << "' final update image : '" << m_finalUpdateImage << "'" << endLog;
+        if (!m_finalBootImage.empty() && image->GetName().find(m_finalBootImage) != std::string::npos) {
+            log(ASTRA_LOG_LEVEL_DEBUG) << "Final boot image sent" << endLog;
+            m_strand->CancelTimer(m_deadlineTimer);
+            if (m_state.Transition(ASTRA_DEVICE_STATUS_BOOT_COMPLETE) && !m_bootOnly) {
+                m_deadlineTimer = StartWatchdog(m_timeouts.m_update, [this] {
+                    OnPhaseDeadline(false);
+                });
+                m_flashWatchdog.StartFlashPhase();
+                // ASTRA_DEVICE_STATUS_BOOT_COMPLETE will get sent when the
+                // session completes in boot only mode.
+                SendStatus(ASTRA_DEVICE_STATUS_BOOT_COMPLETE, 100, ASTRA_NAME_NONE, ASTRA_DEVICE_MESSAGE_SUCCESS);
+            }
+        } else if (!m_finalUpdateImage.empty() && image->GetName().find(m_finalUpdateImage) != std::string::npos) {
+            log(ASTRA_LOG_LEVEL_DEBUG) << "Final update image sent" << endLog;
+            if (image->GetImageType() == ASTRA_IMAGE_TYPE_UPDATE_EMMC || image->GetImageType() == ASTRA_IMAGE_TYPE_UPDATE_SPI
+                || image->GetImageType() == ASTRA_IMAGE_TYPE_UPDATE_NAND)
+            {
+                // EMMC update will ask for a request the size of the image
+                // just sent. Wait for that before marking the update complete.
+                m_waitForSizeRequest = true;
+            } else {
+                CompleteFlashTarget();
+            }
+        } else if (m_waitForSizeRequest && m_sendImageId == m_sizeRequestImageId) {
+            log(ASTRA_LOG_LEVEL_DEBUG) << "Size request image sent" << endLog;
+            CompleteFlashTarget();
+            m_waitForSizeRequest = false;
+        }
+        m_imageCount++;
+        log(ASTRA_LOG_LEVEL_DEBUG) << "Image count: " << m_imageCount << endLog;
+
+        if (m_state.Get() == ASTRA_DEVICE_STATUS_BOOT_PROGRESS) {
+            m_bootRequestTimer = StartWatchdog(m_timeouts.m_bootRequest, [this] {
+                OnBootRequestTimeout();
+            });
+        }
+    }
+
+    int RunConsoleCommand(const std::string &command, std::string &output)
+    {
+        ASTRA_LOG;
+
+        uint64_t promptCount = m_console->GetPromptCount();
+        size_t position = m_console->GetSize();
+
+        int ret = SendToConsole(command + "\n");
+        if (ret < 0) {
+            return ret;
+        }
+
+        if (!m_console->WaitForPrompt(promptCount, m_consoleCommandTimeout)) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "Timeout waiting for console command: " << command << endLog;
+            return -1;
+        }
 
-                if (m_status == ASTRA_DEVICE_STATUS_BOOT_START) {
-                    log(ASTRA_LOG_LEVEL_DEBUG) << "Boot status set to ASTRA_DEVICE_STATUS_BOOT_PROGRESS" << endLog;
-                    m_status = ASTRA_DEVICE_STATUS_BOOT_PROGRESS;
-                } else if (m_status == ASTRA_DEVICE_STATUS_UPDATE_START) {
-                    log(ASTRA_LOG_LEVEL_DEBUG) << "Update status set to ASTRA_DEVICE_STATUS_UPDATE_PROGRESS" << endLog;
-                    m_status = ASTRA_DEVICE_STATUS_UPDATE_PROGRESS;
+        output = m_console->GetSince(position);
+        return 0;
+    }
+
+    int RunConsoleUpdate()
+    {
+        ASTRA_LOG;
+
+        m_state.Transition(ASTRA_DEVICE_STATUS_UPDATE_PROGRESS);
+
+        int ret = m_consoleUpdateImage->RunConsoleUpdate([this](const std::string &command, std::string &output) {
+            return RunConsoleCommand(command, output);
+        });
+        if (ret < 0) {
+            m_state.Transition(ASTRA_DEVICE_STATUS_UPDATE_FAIL);
+            SendStatus(ASTRA_DEVICE_STATUS_UPDATE_FAIL, 0, ASTRA_NAME_NONE, ASTRA_DEVICE_MESSAGE_CONSOLE_UPDATE_FAILED);
+            return ret;
+        }
+
+        if (m_consoleUpdateImage->GetVerify()) {
+            ret = RunVerify();
+            if (ret < 0) {
+                // Leave the device at the U-Boot prompt so the flash can be inspected
+                return ret;
+            }
+        }
+
+        if (!IsLastFlashTarget()) {
+            CompleteFlashTarget();
+            return 0;
+        }
+
+        if (m_resetWhenComplete) {
+            SendToConsole("reset\n");
+        }
+
+        m_state.Transition(ASTRA_DEVICE_STATUS_UPDATE_COMPLETE);
+        SendStatus(ASTRA_DEVICE_STATUS_UPDATE_COMPLETE, 100, ASTRA_NAME_NONE, ASTRA_DEVICE_MESSAGE_SUCCESS);
+
+        return 0;
+    }
+
+    int RunVerify()
+    {
+        ASTRA_LOG;
+
+        SendStatus(ASTRA_DEVICE_STATUS_VERIFY_START, 0, ASTRA_NAME_NONE);
+
+        std::vector<std::string> mismatches;
+        int ret = m_consoleUpdateImage->Verify([this](const std::string &command, std::string &output) {
+            return RunConsoleCommand(command, output);
+        }, mismatches);
+        if (ret < 0) {
+            m_state.Transition(ASTRA_DEVICE_STATUS_UPDATE_FAIL);
+            SendStatus(ASTRA_DEVICE_STATUS_UPDATE_FAIL, 0, ASTRA_NAME_NONE, ASTRA_DEVICE_MESSAGE_VERIFY_READ_FAILED);
+            return ret;
+        }
+
+        for (const auto &region : mismatches) {
+            SendStatus(ASTRA_DEVICE_STATUS_VERIFY_FAIL, 0, AstraNames::Intern(region), ASTRA_DEVICE_MESSAGE_CRC_MISMATCH);
+        }
+
+        if (!mismatches.empty()) {
+            m_state.Transition(ASTRA_DEVICE_STATUS_UPDATE_FAIL);
+            SendStatus(ASTRA_DEVICE_STATUS_UPDATE_FAIL, 0, ASTRA_NAME_NONE, ASTRA_DEVICE_MESSAGE_VERIFY_FAILED);
+            return -1;
+        }
+
+        SendStatus(ASTRA_DEVICE_STATUS_VERIFY_COMPLETE, 100, ASTRA_NAME_NONE);
+
+        return 0;
+    }
+
+    int FastbootFail(AstraDeviceStatus status, AstraNameId imageId, AstraDeviceMessage message)
+    {
+        ASTRA_LOG;
+
+        log(ASTRA_LOG_LEVEL_ERROR) << AstraDeviceMessageToString(message) << " " << AstraNames::Lookup(imageId) << endLog;
+        if (status == ASTRA_DEVICE_STATUS_IMAGE_SEND_FAIL) {
+            SendStatus(status, 0, imageId, message);
+        }
+        m_state.Transition(ASTRA_DEVICE_STATUS_UPDATE_FAIL);
+        SendStatus(ASTRA_DEVICE_STATUS_UPDATE_FAIL, 0, imageId, message);
+        return -1;
+    }
+
+    int RunFastboot()
+    {
+        ASTRA_LOG;
+
+        if (m_shutdown.load()) {
+            return 0;
+        }
+
+        m_state.Transition(ASTRA_DEVICE_STATUS_UPDATE_PROGRESS);
+
+        int ret = m_fastbootDevice->Open([](USBDevice::USBEvent event, uint8_t *, size_t) {
+            ASTRA_LOG;
+            log(ASTRA_LOG_LEVEL_DEBUG) << "Fastboot device event: " << event << endLog;
+        });
+        if (ret < 0 || m_fastbootDevice->EnableInterrupts() < 0) {
+            return FastbootFail(ASTRA_DEVICE_STATUS_UPDATE_FAIL, ASTRA_NAME_NONE, ASTRA_DEVICE_MESSAGE_FASTBOOT_OPEN_FAILED);
+        }
+
+        FastbootClient fastboot(m_fastbootDevice.get());
+
+        uint64_t maxDownloadSize = m_defaultMaxDownloadSize;
+        std::string value;
+        if (fastboot.GetVar("max-download-size", value) == 0) {
+            uint64_t size = std::strtoull(value.c_str(), nullptr, 0);
+            if (size > 0) {
+                maxDownloadSize = size;
+            }
+        }
+        log(ASTRA_LOG_LEVEL_DEBUG) << "Fastboot max download size: " << maxDownloadSize << endLog;
+
+        for (const auto &partitionImage : m_fastbootImage->GetPartitionImages()) {
+            const std::string &partition = partitionImage.m_partitionName;
+            AstraNameId partitionId = AstraNames::Intern(partition);
+
+            std::vector<std::unique_ptr<SparseImage>> sparseImages;
+            ret = SparseImage::Create(partitionImage.m_imagePath, m_sparseBlockSize, maxDownloadSize, sparseImages);
+            if (ret < 0) {
+                return FastbootFail(ASTRA_DEVICE_STATUS_IMAGE_SEND_FAIL, partitionId, ASTRA_DEVICE_MESSAGE_SPARSE_IMAGE_FAILED);
+            }
+
+            uint64_t totalSize = 0;
+            for (const auto &sparseImage : sparseImages) {
+                totalSize += sparseImage->GetSize();
+            }
+
+            StartProgress(partitionId, totalSize);
+            SendStatus(ASTRA_DEVICE_STATUS_IMAGE_SEND_START, 0, partitionId);
+
+            for (const auto &sparseImage : sparseImages) {
+                uint64_t reported = 0;
+                ret = fastboot.Download(*sparseImage, [this, &reported](uint64_t transferred) {
+                    AddProgress(transferred - reported);
+                    reported = transferred;
+                });
+                if (ret < 0) {
+                    return FastbootFail(ASTRA_DEVICE_STATUS_IMAGE_SEND_FAIL, partitionId, ASTRA_DEVICE_MESSAGE_DOWNLOAD_FAILED);
                 }
 
-                ret = SendImage(image);
-                log(ASTRA_LOG_LEVEL_DEBUG) << "After send image: " << image->GetName() << endLog;
+                ret = fastboot.Flash(partition);
                 if (ret < 0) {
-                    log(ASTRA_LOG_LEVEL_ERROR) << "Failed to send image" << endLog;
-                    if (m_status == ASTRA_DEVICE_STATUS_BOOT_START || m_status == ASTRA_DEVICE_STATUS_BOOT_PROGRESS) {
-                        m_status = ASTRA_DEVICE_STATUS_BOOT_FAIL;
-                    } else if (m_status == ASTRA_DEVICE_STATUS_UPDATE_START || m_status == ASTRA_DEVICE_STATUS_UPDATE_PROGRESS) {
-                        m_status = ASTRA_DEVICE_STATUS_UPDATE_FAIL;
-                    }
-                    SendStatus(m_status, 0, image->GetName(), "Failed to send image");
-                    return ret;
-                } else {
-                    log(ASTRA_LOG_LEVEL_DEBUG) << "Image sent successfully: " << image->GetName() << " final boot image '" << m_finalBootImage << "' final update image : '" << m_finalUpdateImage << "'" << endLog;
-                    if (!m_finalBootImage.empty() && image->GetName().find(m_finalBootImage) != std::string::npos) {
-                        log(ASTRA_LOG_LEVEL_DEBUG) << "Final boot image sent" << endLog;
-                        m_status = ASTRA_DEVICE_STATUS_BOOT_COMPLETE;
-                        if (!m_bootOnly) {
-                            // ASTRA_DEVICE_STATUS_BOOT_COMPLETE will get sent from WaitForCompletion when
-                            // in boot only mode.
-                            SendStatus(m_status, 100, "", "Success");
-                        }
-                    } else if (!m_finalUpdateImage.empty() && image->GetName().find(m_finalUpdateImage) != std::string::npos) {
-                        log(ASTRA_LOG_LEVEL_DEBUG) << "Final update image sent" << endLog;
-                        if (image->GetImageType() == ASTRA_IMAGE_TYPE_UPDATE_EMMC || image->GetImageType() == ASTRA_IMAGE_TYPE_UPDATE_SPI) {
-                            // EMMC update will ask for a request the size of the image
-                            // just sent. Wait for that before marking the update complete.
-                            waitForSizeRequest = true;
-                        } else {
-                            m_status = ASTRA_DEVICE_STATUS_UPDATE_COMPLETE;
-                        }
-                    } else if (waitForSizeRequest && image->GetName() == m_sizeRequestImageFilename) {
-                        log(ASTRA_LOG_LEVEL_DEBUG) << "Size request image sent" << endLog;
-                        m_status = ASTRA_DEVICE_STATUS_UPDATE_COMPLETE;
-                        waitForSizeRequest = false;
-                    }
-                    m_imageCount++;
-                    log(ASTRA_LOG_LEVEL_DEBUG) << "Image count: " << m_imageCount << endLog;
+                    return FastbootFail(ASTRA_DEVICE_STATUS_IMAGE_SEND_FAIL, partitionId, ASTRA_DEVICE_MESSAGE_FLASH_FAILED);
                 }
             }
+
+            m_progressImagesSent.fetch_add(1, std::memory_order_relaxed);
+            SendStatus(ASTRA_DEVICE_STATUS_IMAGE_SEND_COMPLETE, 100, partitionId);
         }
 
+        if (m_resetWhenComplete) {
+            // The device may reset before sending a response
+            fastboot.Reboot();
+        }
+
+        m_state.Transition(ASTRA_DEVICE_STATUS_UPDATE_COMPLETE);
+        SendStatus(ASTRA_DEVICE_STATUS_UPDATE_COMPLETE, 100, ASTRA_NAME_NONE, ASTRA_DEVICE_MESSAGE_SUCCESS);
+
         return 0;
     }
 
@@ -635,8 +1753,9 @@ private:
     }
 };
 
-AstraDevice::AstraDevice(std::unique_ptr<USBDevice> device, const std::string &tempDir, bool bootOnly, const std::string &bootCommand) :
-    pImpl{std::make_unique<AstraDeviceImpl>(std::move(device), tempDir, bootOnly, bootCommand)} {}
+AstraDevice::AstraDevice(std::unique_ptr<USBDevice> device, AstraReactor &reactor, USBTopology &topology, const std::string &tempDir,
+    bool bootOnly, const std::string &bootCommand) :
+    pImpl{std::make_unique<AstraDeviceImpl>(std::move(device), reactor, topology, tempDir, bootOnly, bootCommand)} {}
 
 AstraDevice::~AstraDevice() = default;
 
@@ -644,18 +1763,42 @@ void AstraDevice::SetStatusCallback(std::function<void(AstraDeviceManagerRespons
     pImpl->SetStatusCallback(statusCallback);
 }
 
+void AstraDevice::SetCompletionCallback(std::function<void(AstraDeviceStatus)> completionCallback) {
+    pImpl->SetCompletionCallback(completionCallback);
+}
+
+void AstraDevice::SetTimeouts(const AstraDeviceTimeouts &timeouts) {
+    pImpl->SetTimeouts(timeouts);
+}
+
 int AstraDevice::Boot(std::shared_ptr<AstraBootImage> bootImage) {
     return pImpl->Boot(bootImage);
 }
 
 int AstraDevice::Update(std::shared_ptr<FlashImage> flashImage) {
-    return pImpl->Update(flashImage);
+    return pImpl->Update({flashImage});
+}
+
+int AstraDevice::Update(std::vector<std::shared_ptr<FlashImage>> flashImages) {
+    return pImpl->Update(flashImages);
 }
 
 int AstraDevice::WaitForCompletion() {
     return pImpl->WaitForCompletion();
 }
 
+int AstraDevice::WaitForCompletion(std::chrono::milliseconds timeout) {
+    return pImpl->WaitForCompletion(timeout);
+}
+
+bool AstraDevice::AttachFastbootDevice(std::unique_ptr<USBDevice> &device) {
+    return pImpl->AttachFastbootDevice(device);
+}
+
+bool AstraDevice::AttachDevice(std::unique_ptr<USBDevice> &device) {
+    return pImpl->AttachDevice(device);
+}
+
 int AstraDevice::SendToConsole(const std::string &data) {
     return pImpl->SendToConsole(data);
 }
@@ -668,14 +1811,42 @@ std::string AstraDevice::GetDeviceName() {
     return pImpl->GetDeviceName();
 }
 
+AstraNameId AstraDevice::GetDeviceId() {
+    return pImpl->GetDeviceId();
+}
+
 AstraDeviceStatus AstraDevice::GetDeviceStatus() {
     return pImpl->GetDeviceStatus();
 }
 
+std::vector<AstraDeviceTransition> AstraDevice::GetStatusTrace() {
+    return pImpl->GetStatusTrace();
+}
+
+AstraDeviceProgress AstraDevice::GetProgress() {
+    return pImpl->GetProgress();
+}
+
+AstraDeviceMemoryStats AstraDevice::GetMemoryStats() {
+    return pImpl->GetMemoryStats();
+}
+
+AstraDeviceRetryStats AstraDevice::GetRetryStats() {
+    return pImpl->GetRetryStats();
+}
+
 void AstraDevice::Close() {
     pImpl->Close();
 }
 
+bool AstraDevice::DeviceRemoved(const USBDevice &device) {
+    return pImpl->DeviceRemoved(device);
+}
+
+void AstraDevice::Retire(bool removeFiles, std::function<void()> retired) {
+    pImpl->Retire(removeFiles, retired);
+}
+
 const std::string AstraDevice::AstraDeviceStatusToString(AstraDeviceStatus status)
 {
     static const std::string statusStrings[] = {
@@ -694,7 +1865,48 @@ const std::string AstraDevice::AstraDeviceStatusToString(AstraDeviceStatus statu
         "ASTRA_DEVICE_STATUS_IMAGE_SEND_PROGRESS",
         "ASTRA_DEVICE_STATUS_IMAGE_SEND_COMPLETE",
         "ASTRA_DEVICE_STATUS_IMAGE_SEND_FAIL",
+        "ASTRA_DEVICE_STATUS_VERIFY_START",
+        "ASTRA_DEVICE_STATUS_VERIFY_COMPLETE",
+        "ASTRA_DEVICE_STATUS_VERIFY_FAIL",
     };
 
     return statusStrings[status];
-}
\ No newline at end of file
+}
+
+const std::string &AstraDevice::AstraDeviceMessageToString(AstraDeviceMessage message)
+{
+    static const std::string messageStrings[] = {
+        "",
+        "Success",
+        "Device disconnected",
+        "Failed to boot device",
+        "Failed to open reconnected device",
+        "A different device reconnected",
+        "Failed to start reconnected device",
+        "Device did not reconnect after gen3_miniloader.bin.usb",
+        "Boot did not complete in time",
+        "Timeout during boot, press RESET while holding USB_BOOT to try again",
+        "Update did not complete in time",
+        "Transfer stalled",
+        "Flash target did not complete",
+        "Timeout waiting for flash command",
+        "Image not found",
+        "Failed to allocate transfer buffer",
+        "Image too large to send",
+        "Failed to write image",
+        "Failed to read image",
+        "Failed to transfer entire image",
+        "Failed to send image",
+        "Console update failed",
+        "Failed to verify flash contents",
+        "CRC mismatch",
+        "Verification failed",
+        "Timeout waiting for fastboot device",
+        "Failed to open fastboot device",
+        "Failed to create sparse image",
+        "Failed to download",
+        "Failed to flash",
+    };
+
+    return messageStrings[message];
+}
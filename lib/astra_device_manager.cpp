@@ -1,17 +1,26 @@
 // SPDX-License-Identifier: Apache-2.0
 // Copyright 2025 Synaptics Incorporated
 
+#include <algorithm>
 #include <iostream>
 #include <queue>
 #include <memory>
 #include <thread>
 #include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 #include <filesystem>
 #include <condition_variable>
 #include "astra_device.hpp"
 #include "astra_device_manager.hpp"
+#include "astra_concurrency_controller.hpp"
+#include "astra_reactor.hpp"
+#include "astra_session_history.hpp"
 #include "boot_image_collection.hpp"
+#include "station_plan.hpp"
 #include "usb_transport.hpp"
+#include "transfer_buffer_pool.hpp"
+#include "usb_topology.hpp"
 #include "image.hpp"
 #include "astra_log.hpp"
 #include "utils.hpp"
@@ -34,6 +43,7 @@ public:
                 m_tempDir = "./";
             }
             m_removeTempOnClose = true;
+            m_ownsTempDir = true;
         } else {
             m_tempDir = tempDir;
             std::filesystem::create_directories(m_tempDir);
@@ -48,53 +58,94 @@ public:
         ASTRA_LOG;
     }
 
-    void Update(std::shared_ptr<FlashImage> flashImage, std::string bootImagesPath)
+    void Update(std::vector<std::shared_ptr<FlashImage>> flashImages, std::string bootImagesPath)
     {
         ASTRA_LOG;
 
-        m_flashImage = flashImage;
-        m_bootCommand = flashImage->GetFlashCommand();
+        m_managerMode = ASTRA_DEVICE_MANAGER_MODE_UPDATE;
+
+        if (flashImages.empty()) {
+            throw std::runtime_error("No update image");
+        }
+
+        BootImageCollection bootImageCollection = BootImageCollection(bootImagesPath);
+        bootImageCollection.Load();
+
+        // Images for the same VID:PID are flashed on one board in the order given
+        std::vector<uint32_t> deviceIds;
+        std::unordered_map<uint32_t, std::vector<std::shared_ptr<FlashImage>>> targetsByDeviceId;
+        for (auto &flashImage : flashImages) {
+            std::shared_ptr<AstraBootImage> bootImage = SelectBootImage(bootImageCollection, flashImage);
+            uint32_t deviceId = MakeDeviceId(bootImage->GetVendorId(), bootImage->GetProductId());
+            std::vector<std::shared_ptr<FlashImage>> &targets = targetsByDeviceId[deviceId];
+            if (targets.empty()) {
+                deviceIds.push_back(deviceId);
+            }
+            targets.push_back(flashImage);
+        }
+
+        for (uint32_t deviceId : deviceIds) {
+            std::shared_ptr<const Job> job = MakeUpdateJob(bootImageCollection, targetsByDeviceId[deviceId]);
+            m_jobsByDeviceId[deviceId] = job;
+            AddJob(job);
+        }
+
+        // Listen for every chip in the collection so boards without a job are reported
+        for (const auto &deviceId : bootImageCollection.GetDeviceIDs()) {
+            AddDeviceId(std::get<0>(deviceId), std::get<1>(deviceId));
+        }
+
+        Init();
+    }
+
+    void UpdateStation(std::string stationPlanPath, std::string bootImagesPath, std::map<std::string, std::string> config)
+    {
+        ASTRA_LOG;
 
         m_managerMode = ASTRA_DEVICE_MANAGER_MODE_UPDATE;
 
+        StationPlan plan{stationPlanPath};
+        plan.Load();
+
         BootImageCollection bootImageCollection = BootImageCollection(bootImagesPath);
         bootImageCollection.Load();
 
-        if (m_flashImage->GetBootImageId().empty()) {
-            // No boot images specified.
-            // Try to find the best boot image based on other properties
-            if (m_flashImage->GetChipName().empty()) {
-                throw std::runtime_error("Chip name and boot bootImage ID missing!");
+        // Each image is loaded once however many ports use it
+        std::unordered_map<std::string, std::shared_ptr<const Job>> jobsByName;
+        for (const auto &stationJob : plan.GetJobs()) {
+            std::map<std::string, std::string> jobConfig = stationJob.m_config;
+            jobConfig.insert(config.begin(), config.end());
+            std::shared_ptr<FlashImage> flashImage = FlashImage::FlashImageFactory(stationJob.m_flashImagePath, jobConfig,
+                stationJob.m_manifest);
+            if (flashImage->Load() < 0) {
+                throw std::runtime_error("Failed to load flash image for job " + stationJob.m_name);
             }
 
-            std::vector<std::shared_ptr<AstraBootImage>> bootImages = bootImageCollection.GetBootImagesForChip(m_flashImage->GetChipName(),
-            m_flashImage->GetSecureBootVersion(), m_flashImage->GetMemoryLayout(), m_flashImage->GetBoardName());
-            if (bootImages.size() == 0) {
-                throw std::runtime_error("No boot image found for chip: " + m_flashImage->GetChipName());
-            } else if (bootImages.size() > 1) {
-                m_bootImage = bootImages[0];
-                for (const auto& bootImage : bootImages) {
-                    log(ASTRA_LOG_LEVEL_INFO) << "Boot Image: " << bootImage->GetChipName() << " " << bootImage->GetBoardName() << endLog;
-                    if (bootImage->GetUbootVariant() == ASTRA_UBOOT_VARIANT_SYNAPTICS && bootImage->GetUEnvSupport()) {
-                        // Boot bootImages with Synaptics u-boot variant is preferred
-                        m_bootImage = bootImage;
-                        break;
-                    } else if (bootImage->GetUEnvSupport()) {
-                        // Boot bootImages with uEnv support is preferred
-                        m_bootImage = bootImage;
-                    } else if (!m_bootImage->GetUEnvSupport() && bootImage->GetUbootConsole() == ASTRA_UBOOT_CONSOLE_USB) {
-                        // Boot bootImages with USB console is preferred over UART
-                        // But only if there is no uEnv support
-                        m_bootImage = bootImage;
-                    }
-                }
+            std::shared_ptr<const Job> job = MakeUpdateJob(bootImageCollection, {flashImage});
+            jobsByName[stationJob.m_name] = job;
+            AddJob(job);
+        }
+
+        // Boards which are not in the plan get the job for their chip, unless it is ambiguous
+        std::unordered_map<uint32_t, size_t> jobsPerDeviceId;
+        for (const auto &[name, job] : jobsByName) {
+            uint32_t deviceId = MakeDeviceId(job->m_bootImage->GetVendorId(), job->m_bootImage->GetProductId());
+            if (++jobsPerDeviceId[deviceId] == 1) {
+                m_jobsByDeviceId[deviceId] = job;
             } else {
-                // Try the only option
-                m_bootImage = bootImages[0];
+                m_jobsByDeviceId.erase(deviceId);
             }
-        } else {
-            // Exact boot bootImages specified
-            m_bootImage = std::make_shared<AstraBootImage>(bootImageCollection.GetBootImage(m_flashImage->GetBootImageId()));
+        }
+
+        for (const auto &[port, jobName] : plan.GetPorts()) {
+            m_jobsByPort[port] = jobsByName[jobName];
+        }
+        for (const auto &[serialNumber, jobName] : plan.GetSerials()) {
+            m_jobsBySerial[serialNumber] = jobsByName[jobName];
+        }
+
+        for (const auto &deviceId : bootImageCollection.GetDeviceIDs()) {
+            AddDeviceId(std::get<0>(deviceId), std::get<1>(deviceId));
         }
 
         Init();
@@ -105,28 +156,104 @@ public:
         ASTRA_LOG;
 
         m_managerMode = ASTRA_DEVICE_MANAGER_MODE_BOOT;
-        m_bootCommand = bootCommand;
 
         AstraBootImage bootImage{bootImagePath};
         if (!bootImage.Load()) {
             throw std::runtime_error("Failed to load boot image");
         }
 
-        m_bootImage = std::make_shared<AstraBootImage>(bootImage);
+        auto job = std::make_shared<Job>();
+        job->m_bootImage = std::make_shared<AstraBootImage>(bootImage);
+        job->m_bootCommand = bootCommand;
+        m_jobsByDeviceId[MakeDeviceId(bootImage.GetVendorId(), bootImage.GetProductId())] = job;
+        AddJob(job);
 
         Init();
     }
 
-    bool Shutdown()
+    void SetDeviceTimeouts(const AstraDeviceTimeouts &timeouts)
+    {
+        std::lock_guard<std::mutex> lock(m_devicesMutex);
+        m_deviceTimeouts = timeouts;
+    }
+
+    void SetMaxActiveSessions(size_t maxActiveSessions)
     {
         ASTRA_LOG;
 
         std::lock_guard<std::mutex> lock(m_devicesMutex);
-        for (auto& device : m_devices) {
-            device->Close();
+        m_maxActiveSessions = maxActiveSessions;
+        m_concurrencyController.SetMaxLimit(m_maxActiveSessions);
+        log(ASTRA_LOG_LEVEL_INFO) << "Maximum active sessions: " << m_maxActiveSessions << endLog;
+
+        // An active session leases at most one transfer buffer at a time, so
+        // admitted sessions never wait for a buffer. Unlimited admission leaves
+        // the pool uncapped.
+        TransferBufferPool::GetInstance().SetLimit(m_maxActiveSessions);
+
+        if (m_reactor) {
+            m_reactor->SetBlockingThreadCount(GetBlockingThreadCount());
+            AdmitSessions();
+        }
+    }
+
+    void SetAdaptiveConcurrency(bool enable)
+    {
+        std::lock_guard<std::mutex> lock(m_devicesMutex);
+        m_adaptiveConcurrency = enable;
+    }
+
+    void SetHubBandwidth(uint64_t bytesPerSecond)
+    {
+        m_topology.SetHubBandwidth(bytesPerSecond);
+    }
+
+    int SetSessionHistory(size_t capacity, const std::string &spillPath)
+    {
+        std::lock_guard<std::mutex> lock(m_devicesMutex);
+        return m_sessionHistory.Configure(capacity, spillPath);
+    }
+
+    std::vector<AstraSessionSummary> GetSessionHistory()
+    {
+        std::lock_guard<std::mutex> lock(m_devicesMutex);
+        return m_sessionHistory.Get();
+    }
+
+    bool Shutdown()
+    {
+        ASTRA_LOG;
+
+        std::vector<std::shared_ptr<AstraDevice>> devices;
+        {
+            std::lock_guard<std::mutex> lock(m_devicesMutex);
+            m_shutdown = true;
+            devices = m_devices;
+        }
+
+        // Tasks still queued on the reactor and the hotplug callback take
+        // m_devicesMutex, so it is not held while they are drained
+        CloseDevices(devices);
+        if (m_transport) {
+            m_transport->Shutdown();
+        }
+        // Sessions are referenced by tasks still queued on the reactor
+        if (m_reactor) {
+            m_reactor->Shutdown();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_devicesMutex);
+            m_devices.clear();
+            m_sessionsByPort.clear();
+            m_admissionQueue.clear();
+            m_activeSessions.clear();
+            m_activeSessionsPerHub.clear();
+            log(ASTRA_LOG_LEVEL_INFO) << "Sessions finished: " << m_sessionHistory.GetTotalSessions() << " failed: "
+                << m_sessionHistory.GetFailedSessions() << endLog;
+            m_sessionHistory.Close();
         }
-        m_devices.clear();
-        m_transport->Shutdown();
+        devices.clear();
         AstraLogStore::getInstance().Close();
 
         if (m_removeTempOnClose) {
@@ -141,47 +268,340 @@ public:
     }
 
 
+    // Close the sessions in parallel. Each close waits a bounded time for its own
+    // transfer cancellations, so shutdown takes about as long as the slowest device
+    // instead of the sum of all of them. Sessions still closing after m_closeTimeout
+    // are logged and left to the reactor, which cancels their jobs on shutdown.
+    void CloseDevices(const std::vector<std::shared_ptr<AstraDevice>> &devices)
+    {
+        ASTRA_LOG;
+
+        if (!m_reactor || devices.size() < 2) {
+            for (auto &device : devices) {
+                device->Close();
+            }
+            return;
+        }
+
+        // Shared with the close jobs, which may outlive this call
+        struct CloseState {
+            std::mutex m_mutex;
+            std::condition_variable m_cv;
+            std::vector<bool> m_closed;
+            size_t m_remaining;
+        };
+        auto state = std::make_shared<CloseState>();
+        state->m_closed.resize(devices.size(), false);
+        state->m_remaining = devices.size();
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < devices.size(); ++i) {
+            m_reactor->PostBlocking([device = devices[i], state, i] {
+                device->Close();
+                std::lock_guard<std::mutex> lock(state->m_mutex);
+                state->m_closed[i] = true;
+                if (--state->m_remaining == 0) {
+                    state->m_cv.notify_one();
+                }
+            });
+        }
+
+        std::unique_lock<std::mutex> lock(state->m_mutex);
+        if (!state->m_cv.wait_for(lock, m_closeTimeout, [&state] { return state->m_remaining == 0; })) {
+            log(ASTRA_LOG_LEVEL_WARNING) << state->m_remaining << " of " << devices.size() << " devices not closed after "
+                << m_closeTimeout.count() << " s" << endLog;
+            for (size_t i = 0; i < devices.size(); ++i) {
+                if (!state->m_closed[i]) {
+                    log(ASTRA_LOG_LEVEL_WARNING) << "Session still closing: " << devices[i]->GetDeviceName() << endLog;
+                }
+            }
+            return;
+        }
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        log(ASTRA_LOG_LEVEL_DEBUG) << "Closed " << devices.size() << " devices in " << elapsed.count() << " ms" << endLog;
+    }
+
     std::string GetLogFile() const
     {
         return m_modifiedLogPath;
     }
 
+    std::vector<AstraDeviceProgress> GetProgressSnapshot()
+    {
+        std::vector<AstraDeviceProgress> progress;
+
+        std::lock_guard<std::mutex> lock(m_devicesMutex);
+        progress.reserve(m_devices.size());
+        for (auto &device : m_devices) {
+            progress.push_back(device->GetProgress());
+        }
+
+        return progress;
+    }
+
 private:
     std::unique_ptr<USBTransport> m_transport;
     std::function<void(AstraDeviceManagerResponse)> m_responseCallback;
-    std::shared_ptr<AstraBootImage> m_bootImage;
-    std::shared_ptr<FlashImage> m_flashImage;
-    std::string m_bootCommand;
+
+    // What to do with a device: the boot image to send and, in update mode, the
+    // images to flash in order once it has booted
+    struct Job {
+        std::shared_ptr<AstraBootImage> m_bootImage;
+        std::vector<std::shared_ptr<FlashImage>> m_flashImages;
+        std::string m_bootCommand;
+    };
+
+    std::vector<std::shared_ptr<const Job>> m_jobs;
+    // Jobs from a station plan by port path and by serial number. They take precedence
+    // over the job for the device's VID:PID.
+    std::unordered_map<std::string, std::shared_ptr<const Job>> m_jobsByPort;
+    std::unordered_map<std::string, std::shared_ptr<const Job>> m_jobsBySerial;
+    std::unordered_map<uint32_t, std::shared_ptr<const Job>> m_jobsByDeviceId;
+    // USB boot VID:PIDs of every job, and fastboot VID:PIDs of jobs which flash using fastboot
+    std::unordered_set<uint32_t> m_bootDeviceIds;
+    std::unordered_set<uint32_t> m_fastbootDeviceIds;
+    // VID:PIDs registered with the transport
+    std::vector<std::tuple<uint16_t, uint16_t>> m_deviceIds;
     std::string m_tempDir;
+    AstraDeviceTimeouts m_deviceTimeouts;
     AstraDeviceManangerMode m_managerMode;
     bool m_removeTempOnClose = false;
+    // The temp directory was created by the manager rather than given by the caller
+    bool m_ownsTempDir = false;
     bool m_runContinuously = false;
     bool m_deviceFound = false;
     bool m_usbDebug = false;
     bool m_failureReported = false;
     std::string m_modifiedLogPath;
 
+    // Sessions which have not finished yet. Finished sessions are retired and only
+    // their summary is kept, so memory stays bounded in continuous mode.
     std::vector<std::shared_ptr<AstraDevice>> m_devices;
+    AstraSessionHistory m_sessionHistory;
+    // Most recent session on each USB port path, so a device which re-enumerates
+    // on the same port is handed back to its session
+    std::unordered_map<std::string, std::shared_ptr<AstraDevice>> m_sessionsByPort;
     std::mutex m_devicesMutex;
+    bool m_shutdown = false;
+
+    struct QueuedSession {
+        std::shared_ptr<AstraDevice> m_device;
+        std::shared_ptr<const Job> m_job;
+        // Hub the device is connected to
+        std::string m_hub;
+    };
+
+    struct ActiveSession {
+        std::string m_hub;
+        // Counters at the last throughput sample
+        uint64_t m_bytesSent;
+        uint32_t m_retries;
+    };
+
+    // Sessions which have been started and not yet finished
+    std::unordered_map<std::shared_ptr<AstraDevice>, ActiveSession> m_activeSessions;
+    std::unordered_map<std::string, size_t> m_activeSessionsPerHub;
+    // Sessions of attached devices waiting to be started, oldest first
+    std::deque<QueuedSession> m_admissionQueue;
+    size_t m_maxActiveSessions = 0;
+    static constexpr size_t m_spareBlockingThreads = 4;
+    // Longest Shutdown() waits for the sessions to close
+    static constexpr std::chrono::seconds m_closeTimeout{5};
+
+    // Hub tree shared by every session to schedule bulk transfers
+    USBTopology m_topology;
+
+    bool m_adaptiveConcurrency = false;
+    AstraConcurrencyController m_concurrencyController;
+    // Sessions which failed since the last throughput sample
+    uint32_t m_sessionFailures = 0;
+    std::chrono::steady_clock::time_point m_lastSample;
+    static constexpr std::chrono::seconds m_sampleInterval{2};
+
+    // Drives every device session from a small fixed set of threads
+    std::unique_ptr<AstraReactor> m_reactor;
+
+    static uint32_t MakeDeviceId(uint16_t vendorId, uint16_t productId)
+    {
+        return (static_cast<uint32_t>(vendorId) << 16) | productId;
+    }
+
+    static std::string DeviceIdToString(uint16_t vendorId, uint16_t productId)
+    {
+        std::ostringstream os;
+        os << std::hex << std::uppercase << std::setw(4) << std::setfill('0') << vendorId << ":"
+            << std::setw(4) << std::setfill('0') << productId;
+        return os.str();
+    }
+
+    std::shared_ptr<AstraBootImage> SelectBootImage(const BootImageCollection &bootImageCollection,
+        std::shared_ptr<FlashImage> flashImage)
+    {
+        ASTRA_LOG;
+
+        // Jobs which boot the same image share one copy
+        auto findShared = [this](const std::string &id) -> std::shared_ptr<AstraBootImage> {
+            for (const auto &job : m_jobs) {
+                if (job->m_bootImage->GetID() == id) {
+                    return job->m_bootImage;
+                }
+            }
+            return nullptr;
+        };
+
+        if (!flashImage->GetBootImageId().empty()) {
+            // Exact boot bootImages specified
+            std::shared_ptr<AstraBootImage> shared = findShared(flashImage->GetBootImageId());
+            return shared ? shared : std::make_shared<AstraBootImage>(bootImageCollection.GetBootImage(flashImage->GetBootImageId()));
+        }
+
+        // No boot images specified.
+        // Try to find the best boot image based on other properties
+        if (flashImage->GetChipName().empty()) {
+            throw std::runtime_error("Chip name and boot bootImage ID missing!");
+        }
+
+        std::vector<std::shared_ptr<AstraBootImage>> bootImages = bootImageCollection.GetBootImagesForChip(flashImage->GetChipName(),
+        flashImage->GetSecureBootVersion(), flashImage->GetMemoryLayout(), flashImage->GetBoardName());
+        if (bootImages.size() == 0) {
+            throw std::runtime_error("No boot image found for chip: " + flashImage->GetChipName());
+        }
+
+        // Try the only option
+        std::shared_ptr<AstraBootImage> selected = bootImages[0];
+        if (bootImages.size() > 1) {
+            for (const auto& bootImage : bootImages) {
+                log(ASTRA_LOG_LEVEL_INFO) << "Boot Image: " << bootImage->GetChipName() << " " << bootImage->GetBoardName() << endLog;
+                if (bootImage->GetUbootVariant() == ASTRA_UBOOT_VARIANT_SYNAPTICS && bootImage->GetUEnvSupport()) {
+                    // Boot bootImages with Synaptics u-boot variant is preferred
+                    selected = bootImage;
+                    break;
+                } else if (bootImage->GetUEnvSupport()) {
+                    // Boot bootImages with uEnv support is preferred
+                    selected = bootImage;
+                } else if (!selected->GetUEnvSupport() && bootImage->GetUbootConsole() == ASTRA_UBOOT_CONSOLE_USB) {
+                    // Boot bootImages with USB console is preferred over UART
+                    // But only if there is no uEnv support
+                    selected = bootImage;
+                }
+            }
+        }
+
+        std::shared_ptr<AstraBootImage> shared = findShared(selected->GetID());
+        return shared ? shared : selected;
+    }
+
+    void AddDeviceId(uint16_t vendorId, uint16_t productId)
+    {
+        auto deviceId = std::make_tuple(vendorId, productId);
+        if (std::find(m_deviceIds.begin(), m_deviceIds.end(), deviceId) == m_deviceIds.end()) {
+            m_deviceIds.push_back(deviceId);
+        }
+    }
+
+    // The flash targets are written in order in one U-Boot session, so they must all
+    // boot the same way and only the last one may leave U-Boot for fastboot
+    std::shared_ptr<const Job> MakeUpdateJob(const BootImageCollection &bootImageCollection,
+        std::vector<std::shared_ptr<FlashImage>> flashImages)
+    {
+        auto job = std::make_shared<Job>();
+        job->m_flashImages = flashImages;
+        // uEnv.txt runs the first target's command, only the last target resets the device
+        job->m_bootCommand = flashImages.front()->GetFlashCommand(flashImages.size() == 1);
+        job->m_bootImage = SelectBootImage(bootImageCollection, flashImages.front());
+        bool usbConsole = job->m_bootImage->GetUbootConsole() == ASTRA_UBOOT_CONSOLE_USB;
+
+        if (flashImages.size() > 1 && !usbConsole) {
+            throw std::runtime_error("Flashing more than one image requires a boot image with a USB console");
+        }
+
+        for (size_t i = 0; i < flashImages.size(); ++i) {
+            const std::shared_ptr<FlashImage> &flashImage = flashImages[i];
+            if (flashImage->GetRequiresConsole() && !usbConsole) {
+                throw std::runtime_error("Update image requires a boot image with a USB console");
+            }
+            if (flashImage->GetUseFastboot() && i + 1 < flashImages.size()) {
+                throw std::runtime_error("Only the last image flashed on a device can use fastboot");
+            }
+        }
+
+        return job;
+    }
+
+    void AddJob(std::shared_ptr<const Job> job)
+    {
+        uint16_t vendorId = job->m_bootImage->GetVendorId();
+        uint16_t productId = job->m_bootImage->GetProductId();
+        m_bootDeviceIds.insert(MakeDeviceId(vendorId, productId));
+        AddDeviceId(vendorId, productId);
+
+        if (!job->m_flashImages.empty() && job->m_flashImages.back()->GetUseFastboot()) {
+            uint16_t fastbootVendorId = job->m_flashImages.back()->GetFastbootVendorId();
+            uint16_t fastbootProductId = job->m_flashImages.back()->GetFastbootProductId();
+            m_fastbootDeviceIds.insert(MakeDeviceId(fastbootVendorId, fastbootProductId));
+            AddDeviceId(fastbootVendorId, fastbootProductId);
+        }
+
+        m_jobs.push_back(job);
+    }
+
+    // Station plan ports first, then the job for the device's VID:PID
+    std::shared_ptr<const Job> FindJob(USBDevice &device)
+    {
+        auto portIt = m_jobsByPort.find(device.GetUSBPath());
+        if (portIt != m_jobsByPort.end()) {
+            return portIt->second;
+        }
+
+        auto deviceIt = m_jobsByDeviceId.find(MakeDeviceId(device.GetVendorId(), device.GetProductId()));
+        return deviceIt == m_jobsByDeviceId.end() ? nullptr : deviceIt->second;
+    }
+
+    // Runs on the reactor since reading the serial number needs control transfers,
+    // which cannot be made from the hotplug callback
+    void AddDeviceBySerial(std::unique_ptr<USBDevice> device)
+    {
+        ASTRA_LOG;
+
+        const std::string &serialNumber = device->ReadSerialNumber();
+        log(ASTRA_LOG_LEVEL_DEBUG) << "Serial number of " << device->GetUSBPath() << ": " << serialNumber << endLog;
+
+        auto it = m_jobsBySerial.find(serialNumber);
+        std::shared_ptr<const Job> job = it == m_jobsBySerial.end() ? FindJob(*device) : it->second;
+        AddSession(std::move(device), job);
+    }
 
     void Init()
     {
         ASTRA_LOG;
 
-        if (m_bootImage == nullptr) {
+        if (m_jobs.empty()) {
             throw std::runtime_error("Boot image not found");
         }
 
-        std::string bootImageDescription = "Boot Image: " + m_bootImage->GetChipName() + " " + m_bootImage->GetBoardName() + " (" + m_bootImage->GetID() + ")\n";
-        bootImageDescription += "    Secure Boot: " + AstraSecureBootVersionToString(m_bootImage->GetSecureBootVersion()) + "\n";
-        bootImageDescription += "    Memory Layout: " + AstraMemoryLayoutToString(m_bootImage->GetMemoryLayout()) + "\n";
-        bootImageDescription += "    U-Boot Console: " + std::string(m_bootImage->GetUbootConsole() == ASTRA_UBOOT_CONSOLE_UART ? "UART" : "USB") + "\n";
-        bootImageDescription += "    uEnt.txt Support: " + std::string(m_bootImage->GetUEnvSupport() ? "enabled" : "disabled") + "\n";
-        bootImageDescription += "    U-Boot Variant: " + std::string(m_bootImage->GetUbootVariant() == ASTRA_UBOOT_VARIANT_UBOOT ? "U-Boot" : "Synaptics U-Boot");
-        ResponseCallback({ManagerResponse{ASTRA_DEVICE_MANAGER_STATUS_INFO, bootImageDescription}});
+        std::string waitingFor;
+        for (const auto &job : m_jobs) {
+            const std::shared_ptr<AstraBootImage> &bootImage = job->m_bootImage;
+            std::string bootImageDescription = "Boot Image: " + bootImage->GetChipName() + " " + bootImage->GetBoardName() + " (" + bootImage->GetID() + ")\n";
+            bootImageDescription += "    Secure Boot: " + AstraSecureBootVersionToString(bootImage->GetSecureBootVersion()) + "\n";
+            bootImageDescription += "    Memory Layout: " + AstraMemoryLayoutToString(bootImage->GetMemoryLayout()) + "\n";
+            bootImageDescription += "    U-Boot Console: " + std::string(bootImage->GetUbootConsole() == ASTRA_UBOOT_CONSOLE_UART ? "UART" : "USB") + "\n";
+            bootImageDescription += "    uEnt.txt Support: " + std::string(bootImage->GetUEnvSupport() ? "enabled" : "disabled") + "\n";
+            bootImageDescription += "    U-Boot Variant: " + std::string(bootImage->GetUbootVariant() == ASTRA_UBOOT_VARIANT_UBOOT ? "U-Boot" : "Synaptics U-Boot");
+            ResponseCallback({ManagerResponse{ASTRA_DEVICE_MANAGER_STATUS_INFO, AstraNames::Intern(bootImageDescription)}});
 
-        uint16_t vendorId = m_bootImage->GetVendorId();
-        uint16_t productId = m_bootImage->GetProductId();
+            waitingFor += (waitingFor.empty() ? "" : ", ") + DeviceIdToString(bootImage->GetVendorId(), bootImage->GetProductId());
+        }
+
+        m_reactor = std::make_unique<AstraReactor>(0, GetBlockingThreadCount());
+        if (m_adaptiveConcurrency) {
+            log(ASTRA_LOG_LEVEL_INFO) << "Adaptive concurrency, initial limit: " << m_concurrencyController.GetLimit() << endLog;
+            m_lastSample = std::chrono::steady_clock::now();
+            m_reactor->PostAfter(m_sampleInterval, [this] {
+                SampleThroughput();
+            });
+        }
 
 #if PLATFORM_WINDOWS
         m_transport = std::make_unique<WinUSBTransport>(m_usbDebug);
@@ -189,7 +609,9 @@ private:
         m_transport = std::make_unique<USBTransport>(m_usbDebug);
 #endif
 
-        if (m_transport->Init(vendorId, productId,
+        m_transport->SetDeviceRemovedCallback(std::bind(&AstraDeviceManagerImpl::DeviceRemovedCallback, this,
+            std::placeholders::_1));
+        if (m_transport->Init(m_deviceIds,
                 std::bind(&AstraDeviceManagerImpl::DeviceAddedCallback, this, std::placeholders::_1)) < 0)
         {
             throw std::runtime_error("Failed to initialize USB transport");
@@ -197,9 +619,7 @@ private:
 
         log(ASTRA_LOG_LEVEL_DEBUG) << "USB transport initialized successfully" << endLog;
 
-        std::ostringstream os;
-        os << "Waiting for Astra Device (" << std::hex << std::uppercase << std::setw(4) << std::setfill('0') << vendorId << ":" << std::hex << std::uppercase << std::setw(4) << std::setfill('0') << productId << ")";
-        ResponseCallback({ManagerResponse{ASTRA_DEVICE_MANAGER_STATUS_START, os.str()}});
+        ResponseCallback({ManagerResponse{ASTRA_DEVICE_MANAGER_STATUS_START, AstraNames::Intern("Waiting for Astra Device (" + waitingFor + ")")}});
     }
 
     void ResponseCallback(AstraDeviceManagerResponse response)
@@ -212,7 +632,8 @@ private:
             }
         } else if (response.IsDeviceResponse()) {
             if (response.GetDeviceResponse().m_status == ASTRA_DEVICE_STATUS_BOOT_FAIL ||
-                response.GetDeviceResponse().m_status == ASTRA_DEVICE_STATUS_UPDATE_FAIL)
+                response.GetDeviceResponse().m_status == ASTRA_DEVICE_STATUS_UPDATE_FAIL ||
+                response.GetDeviceResponse().m_status == ASTRA_DEVICE_STATUS_VERIFY_FAIL)
             {
                 m_removeTempOnClose = false;
                 m_failureReported = true;
@@ -221,51 +642,199 @@ private:
         m_responseCallback(response);
     }
 
-    void AstraDeviceThread(std::shared_ptr<AstraDevice> astraDevice)
+    void StartDevice(std::shared_ptr<AstraDevice> astraDevice, std::shared_ptr<const Job> job)
     {
         ASTRA_LOG;
 
-        log(ASTRA_LOG_LEVEL_DEBUG) << "Booting device device" << endLog;
-
-        if (astraDevice) {
-            astraDevice->SetStatusCallback(m_responseCallback);
+        log(ASTRA_LOG_LEVEL_DEBUG) << "Calling boot" << endLog;
+        int ret = astraDevice->Boot(job->m_bootImage);
+        if (ret < 0) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "Failed to boot device" << endLog;
+            ResponseCallback({ DeviceResponse{astraDevice->GetDeviceId(), ASTRA_DEVICE_STATUS_BOOT_FAIL, 0, ASTRA_NAME_NONE,
+                ASTRA_DEVICE_MESSAGE_BOOT_FAILED}});
+            astraDevice->Close();
+            ReleaseSession(astraDevice);
+            RetireSession(astraDevice, ASTRA_DEVICE_STATUS_BOOT_FAIL);
+            return;
+        }
 
-            log(ASTRA_LOG_LEVEL_DEBUG) << "Calling boot" << endLog;
-            int ret = astraDevice->Boot(m_bootImage);
+        if (m_managerMode == ASTRA_DEVICE_MANAGER_MODE_UPDATE) {
+            log(ASTRA_LOG_LEVEL_DEBUG) << "calling from Update" << endLog;
+            ret = astraDevice->Update(job->m_flashImages);
             if (ret < 0) {
-                log(ASTRA_LOG_LEVEL_ERROR) << "Failed to boot device" << endLog;
-                ResponseCallback({ DeviceResponse{astraDevice->GetDeviceName(), ASTRA_DEVICE_STATUS_BOOT_FAIL, 0, "", "Failed to Boot Device"}});
+                log(ASTRA_LOG_LEVEL_ERROR) << "Failed to update device" << endLog;
+                astraDevice->Close();
+                ReleaseSession(astraDevice);
+                RetireSession(astraDevice, ASTRA_DEVICE_STATUS_UPDATE_FAIL);
                 return;
             }
+        }
+    }
 
-            if (m_managerMode == ASTRA_DEVICE_MANAGER_MODE_UPDATE) {
-                log(ASTRA_LOG_LEVEL_DEBUG) << "calling from Update" << endLog;
-                ret = astraDevice->Update(m_flashImage);
-                if (ret < 0) {
-                    log(ASTRA_LOG_LEVEL_ERROR) << "Failed to update device" << endLog;
-                    return;
-                }
-            }
+    void DeviceComplete(std::shared_ptr<AstraDevice> astraDevice, AstraDeviceStatus status)
+    {
+        ASTRA_LOG;
 
-            log(ASTRA_LOG_LEVEL_DEBUG) << "calling from WaitForCompletion" << endLog;
-            ret = astraDevice->WaitForCompletion();
-            if (ret < 0) {
-                log(ASTRA_LOG_LEVEL_ERROR) << "Failed to wait for completion" << endLog;
+        log(ASTRA_LOG_LEVEL_DEBUG) << "Device status: " << AstraDevice::AstraDeviceStatusToString(status) << endLog;
+        if (status == ASTRA_DEVICE_STATUS_UPDATE_COMPLETE && !m_runContinuously) {
+            log(ASTRA_LOG_LEVEL_DEBUG) << "Shutting down Astra Device Manager" << endLog;
+            ResponseCallback({ManagerResponse{ASTRA_DEVICE_MANAGER_STATUS_SHUTDOWN, AstraNames::Intern("Astra Device Manager shutting down")}});
+        } else if (m_managerMode == ASTRA_DEVICE_MANAGER_MODE_BOOT  &&  status == ASTRA_DEVICE_STATUS_BOOT_COMPLETE && !m_runContinuously) {
+            log(ASTRA_LOG_LEVEL_DEBUG) << "Shutting down Astra Device Manager" << endLog;
+            ResponseCallback({ManagerResponse{ASTRA_DEVICE_MANAGER_STATUS_SHUTDOWN, AstraNames::Intern("Astra Device Manager shutting down")}});
+        }
+
+        if (status == ASTRA_DEVICE_STATUS_BOOT_FAIL || status == ASTRA_DEVICE_STATUS_UPDATE_FAIL) {
+            std::lock_guard<std::mutex> lock(m_devicesMutex);
+            ++m_sessionFailures;
+        }
+
+        astraDevice->Close();
+        ReleaseSession(astraDevice);
+        RetireSession(astraDevice, status);
+    }
+
+    // Record the summary of a closed session and drop it. The session is destroyed
+    // on the reactor once nothing it posted can run any more.
+    void RetireSession(std::shared_ptr<AstraDevice> astraDevice, AstraDeviceStatus status)
+    {
+        AstraSessionSummary summary{};
+        AstraDeviceProgress progress = astraDevice->GetProgress();
+        std::vector<AstraDeviceTransition> trace = astraDevice->GetStatusTrace();
+        summary.m_deviceId = astraDevice->GetDeviceId();
+        summary.m_status = status;
+        summary.m_totalBytesSent = progress.m_totalBytesSent;
+        summary.m_imagesSent = progress.m_imagesSent;
+        summary.m_retries = astraDevice->GetRetryStats().m_retries;
+        summary.m_finishTime = std::chrono::system_clock::now();
+        if (!trace.empty()) {
+            summary.m_duration = trace.back().m_time - trace.front().m_time;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_devicesMutex);
+            auto it = std::find(m_devices.begin(), m_devices.end(), astraDevice);
+            if (it == m_devices.end()) {
+                // Already retired, or dropped by Shutdown()
                 return;
             }
+            m_devices.erase(it);
+            m_sessionHistory.Add(summary);
 
-            log(ASTRA_LOG_LEVEL_DEBUG) << "returned from WaitForCompletion" << endLog;
-            AstraDeviceStatus status = astraDevice->GetDeviceStatus();
-            log(ASTRA_LOG_LEVEL_DEBUG) << "Device status: " << AstraDevice::AstraDeviceStatusToString(status) << endLog;
-            if (status == ASTRA_DEVICE_STATUS_UPDATE_COMPLETE && !m_runContinuously) {
-                log(ASTRA_LOG_LEVEL_DEBUG) << "Shutting down Astra Device Manager" << endLog;
-                ResponseCallback({ManagerResponse{ASTRA_DEVICE_MANAGER_STATUS_SHUTDOWN, "Astra Device Manager shutting down"}});
-            } else if (m_managerMode == ASTRA_DEVICE_MANAGER_MODE_BOOT  &&  status == ASTRA_DEVICE_STATUS_BOOT_COMPLETE && !m_runContinuously) {
-                log(ASTRA_LOG_LEVEL_DEBUG) << "Shutting down Astra Device Manager" << endLog;
-                ResponseCallback({ManagerResponse{ASTRA_DEVICE_MANAGER_STATUS_SHUTDOWN, "Astra Device Manager shutting down"}});
+            for (auto portIt = m_sessionsByPort.begin(); portIt != m_sessionsByPort.end(); ++portIt) {
+                if (portIt->second == astraDevice) {
+                    m_sessionsByPort.erase(portIt);
+                    break;
+                }
             }
+        }
 
-            astraDevice->Close();
+        // Failed sessions keep their files for debugging
+        bool removeFiles = m_ownsTempDir && (status == ASTRA_DEVICE_STATUS_BOOT_COMPLETE ||
+            status == ASTRA_DEVICE_STATUS_UPDATE_COMPLETE);
+        astraDevice->Retire(removeFiles, [astraDevice] {});
+    }
+
+    // An active session runs at most one blocking job at a time. The spare threads
+    // close sessions on shutdown while the active sessions still hold theirs.
+    size_t GetBlockingThreadCount() const
+    {
+        return m_maxActiveSessions ? m_maxActiveSessions + m_spareBlockingThreads : 0;
+    }
+
+    size_t GetSessionLimit() const
+    {
+        return m_adaptiveConcurrency ? m_concurrencyController.GetLimit() : m_maxActiveSessions;
+    }
+
+    // Feed the bytes sent and the errors since the last sample to the concurrency controller
+    void SampleThroughput()
+    {
+        std::lock_guard<std::mutex> lock(m_devicesMutex);
+        if (m_shutdown) {
+            return;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - m_lastSample).count();
+        m_lastSample = now;
+
+        AstraThroughputSample sample{};
+        uint64_t bytesSent = 0;
+        for (auto &[astraDevice, session] : m_activeSessions) {
+            uint64_t sessionBytes = astraDevice->GetProgress().m_totalBytesSent;
+            uint32_t sessionRetries = astraDevice->GetRetryStats().m_retries;
+            if (sessionBytes > session.m_bytesSent) {
+                bytesSent += sessionBytes - session.m_bytesSent;
+                ++sample.m_transferringSessions;
+            }
+            sample.m_errors += sessionRetries - session.m_retries;
+            session.m_bytesSent = sessionBytes;
+            session.m_retries = sessionRetries;
+        }
+        sample.m_aggregateRate = elapsed > 0 ? bytesSent / elapsed : 0;
+        sample.m_activeSessions = m_activeSessions.size();
+        sample.m_errors += m_sessionFailures;
+        m_sessionFailures = 0;
+
+        if (m_concurrencyController.Update(sample)) {
+            AdmitSessions();
+        }
+
+        m_reactor->PostAfter(m_sampleInterval, [this] {
+            SampleThroughput();
+        });
+    }
+
+    // Start queued sessions while there are free slots. Called with m_devicesMutex held.
+    // The oldest session on the hub with the fewest active sessions goes first, so
+    // one hub is not oversubscribed while devices on other hubs wait.
+    void AdmitSessions()
+    {
+        ASTRA_LOG;
+
+        size_t limit = GetSessionLimit();
+        while (!m_shutdown && !m_admissionQueue.empty() && (limit == 0 || m_activeSessions.size() < limit))
+        {
+            auto next = std::min_element(m_admissionQueue.begin(), m_admissionQueue.end(),
+                [this](const QueuedSession &a, const QueuedSession &b) {
+                    return GetActiveSessionCount(a.m_hub) < GetActiveSessionCount(b.m_hub);
+                });
+            std::shared_ptr<AstraDevice> astraDevice = next->m_device;
+            std::shared_ptr<const Job> job = next->m_job;
+            std::string hub = next->m_hub;
+            m_admissionQueue.erase(next);
+            m_activeSessions[astraDevice] = {hub, 0, 0};
+            ++m_activeSessionsPerHub[hub];
+
+            m_reactor->Post([this, astraDevice, job] {
+                StartDevice(astraDevice, job);
+            });
+        }
+
+        if (!m_admissionQueue.empty()) {
+            log(ASTRA_LOG_LEVEL_INFO) << m_admissionQueue.size() << " devices waiting, " << m_activeSessions.size()
+                << " active" << endLog;
+        }
+    }
+
+    size_t GetActiveSessionCount(const std::string &hub) const
+    {
+        auto it = m_activeSessionsPerHub.find(hub);
+        return it == m_activeSessionsPerHub.end() ? 0 : it->second;
+    }
+
+    // Free the slot of a session which has finished or failed to start
+    void ReleaseSession(std::shared_ptr<AstraDevice> astraDevice)
+    {
+        std::lock_guard<std::mutex> lock(m_devicesMutex);
+        auto it = m_activeSessions.find(astraDevice);
+        if (it != m_activeSessions.end()) {
+            if (--m_activeSessionsPerHub[it->second.m_hub] == 0) {
+                m_activeSessionsPerHub.erase(it->second.m_hub);
+            }
+            m_activeSessions.erase(it);
+            AdmitSessions();
         }
     }
 
@@ -275,14 +844,145 @@ private:
 
         log(ASTRA_LOG_LEVEL_DEBUG) << "Device added AstraDeviceManagerImpl::DeviceAddedCallback" << endLog;
 
-        std::shared_ptr<AstraDevice> astraDevice = std::make_shared<AstraDevice>(std::move(device), m_tempDir,
-            m_managerMode == ASTRA_DEVICE_MANAGER_MODE_BOOT, m_bootCommand);
+        uint32_t deviceId = MakeDeviceId(device->GetVendorId(), device->GetProductId());
+        bool bootDevice = m_bootDeviceIds.find(deviceId) != m_bootDeviceIds.end();
+        bool useFastboot = m_fastbootDeviceIds.find(deviceId) != m_fastbootDeviceIds.end();
+
+        std::shared_ptr<AstraDevice> replacedDevice;
+        {
+            // A device which re-enumerated or switched to fastboot belongs to the session on the same port
+            std::lock_guard<std::mutex> lock(m_devicesMutex);
+            auto it = m_sessionsByPort.find(device->GetUSBPath());
+            if (it != m_sessionsByPort.end()) {
+                if (bootDevice && it->second->AttachDevice(device)) {
+                    return;
+                }
+                if (useFastboot && it->second->AttachFastbootDevice(device)) {
+                    return;
+                }
+
+                // The device was unplugged and plugged back in before its session started
+                auto queued = std::find_if(m_admissionQueue.begin(), m_admissionQueue.end(),
+                    [&it](const QueuedSession &session) {
+                        return session.m_device == it->second;
+                    });
+                if (queued != m_admissionQueue.end()) {
+                    log(ASTRA_LOG_LEVEL_DEBUG) << "Replacing queued session on " << device->GetUSBPath() << endLog;
+                    replacedDevice = queued->m_device;
+                    m_admissionQueue.erase(queued);
+                }
+            }
+        }
+
+        if (replacedDevice) {
+            AstraDeviceStatus status = replacedDevice->GetDeviceStatus();
+            replacedDevice->Close();
+            RetireSession(replacedDevice, status);
+        }
+
+        if (useFastboot && !bootDevice) {
+            log(ASTRA_LOG_LEVEL_WARNING) << "Ignoring fastboot device without an active update: " << device->GetUSBPath() << endLog;
+            return;
+        }
+
+        if (!bootDevice) {
+            log(ASTRA_LOG_LEVEL_WARNING) << "No job for device " << DeviceIdToString(device->GetVendorId(), device->GetProductId())
+                << " on " << device->GetUSBPath() << endLog;
+            return;
+        }
+
+        if (!m_jobsBySerial.empty() && m_jobsByPort.find(device->GetUSBPath()) == m_jobsByPort.end()) {
+            auto holder = std::make_shared<std::unique_ptr<USBDevice>>(std::move(device));
+            m_reactor->Post([this, holder] {
+                AddDeviceBySerial(std::move(*holder));
+            });
+            return;
+        }
+
+        std::shared_ptr<const Job> job = FindJob(*device);
+        AddSession(std::move(device), job);
+    }
+
+    // Runs in the hotplug callback. Hands the removal to the session on the port, or
+    // drops the session if it was still waiting to start.
+    void DeviceRemovedCallback(std::unique_ptr<USBDevice> device)
+    {
+        ASTRA_LOG;
+
+        std::shared_ptr<AstraDevice> queuedDevice;
+        {
+            std::lock_guard<std::mutex> lock(m_devicesMutex);
+            if (m_shutdown) {
+                return;
+            }
+
+            auto it = m_sessionsByPort.find(device->GetUSBPath());
+            // A device which already re-enumerated is no longer the session's device
+            if (it == m_sessionsByPort.end() || !it->second->DeviceRemoved(*device)) {
+                return;
+            }
+
+            auto queued = std::find_if(m_admissionQueue.begin(), m_admissionQueue.end(),
+                [&it](const QueuedSession &session) {
+                    return session.m_device == it->second;
+                });
+            if (queued == m_admissionQueue.end()) {
+                return;
+            }
+            log(ASTRA_LOG_LEVEL_INFO) << "Device on " << device->GetUSBPath() << " removed before its session started" << endLog;
+            queuedDevice = queued->m_device;
+            m_admissionQueue.erase(queued);
+        }
+
+        AstraDeviceStatus status = queuedDevice->GetDeviceStatus();
+        queuedDevice->Close();
+        RetireSession(queuedDevice, status);
+    }
+
+    void AddSession(std::unique_ptr<USBDevice> device, std::shared_ptr<const Job> job)
+    {
+        ASTRA_LOG;
+
+        uint16_t vendorId = device->GetVendorId();
+        uint16_t productId = device->GetProductId();
+        if (!job) {
+            log(ASTRA_LOG_LEVEL_WARNING) << "No job for device " << DeviceIdToString(vendorId, productId)
+                << " on " << device->GetUSBPath() << endLog;
+            return;
+        }
+        if (job->m_bootImage->GetVendorId() != vendorId || job->m_bootImage->GetProductId() != productId) {
+            log(ASTRA_LOG_LEVEL_WARNING) << "Job for " << device->GetUSBPath() << " expects device "
+                << DeviceIdToString(job->m_bootImage->GetVendorId(), job->m_bootImage->GetProductId()) << ", found "
+                << DeviceIdToString(vendorId, productId) << endLog;
+            return;
+        }
 
         std::lock_guard<std::mutex> lock(m_devicesMutex);
+        if (m_shutdown) {
+            return;
+        }
+
+        std::string usbPath = device->GetUSBPath();
+        std::shared_ptr<AstraDevice> astraDevice = std::make_shared<AstraDevice>(std::move(device), *m_reactor, m_topology,
+            m_tempDir, m_managerMode == ASTRA_DEVICE_MANAGER_MODE_BOOT, job->m_bootCommand);
+
+        astraDevice->SetStatusCallback(m_responseCallback);
+        astraDevice->SetTimeouts(m_deviceTimeouts);
+        // The completion runs on the session strand. Close it from the pool instead.
+        std::weak_ptr<AstraDevice> weakDevice = astraDevice;
+        astraDevice->SetCompletionCallback([this, weakDevice](AstraDeviceStatus status) {
+            m_reactor->Post([this, weakDevice, status] {
+                if (auto astraDevice = weakDevice.lock()) {
+                    DeviceComplete(astraDevice, status);
+                }
+            });
+        });
+
         m_deviceFound = true;
         m_devices.push_back(astraDevice);
-
-        std::thread(std::bind(&AstraDeviceManagerImpl::AstraDeviceThread, this, astraDevice)).detach();
+        m_sessionsByPort[usbPath] = astraDevice;
+        m_admissionQueue.push_back({astraDevice, job, USBTopology::GetParentHub(usbPath)});
+        AdmitSessions();
     }
 
 };
@@ -297,9 +997,50 @@ AstraDeviceManager::AstraDeviceManager(std::function<void(AstraDeviceManagerResp
 
 AstraDeviceManager::~AstraDeviceManager() = default;
 
+void AstraDeviceManager::SetDeviceTimeouts(const AstraDeviceTimeouts &timeouts)
+{
+    pImpl->SetDeviceTimeouts(timeouts);
+}
+
+void AstraDeviceManager::SetMaxActiveSessions(size_t maxActiveSessions)
+{
+    pImpl->SetMaxActiveSessions(maxActiveSessions);
+}
+
+void AstraDeviceManager::SetAdaptiveConcurrency(bool enable)
+{
+    pImpl->SetAdaptiveConcurrency(enable);
+}
+
+void AstraDeviceManager::SetHubBandwidth(uint64_t bytesPerSecond)
+{
+    pImpl->SetHubBandwidth(bytesPerSecond);
+}
+
+int AstraDeviceManager::SetSessionHistory(size_t capacity, const std::string &spillPath)
+{
+    return pImpl->SetSessionHistory(capacity, spillPath);
+}
+
+std::vector<AstraSessionSummary> AstraDeviceManager::GetSessionHistory()
+{
+    return pImpl->GetSessionHistory();
+}
+
 void AstraDeviceManager::Update(std::shared_ptr<FlashImage> flashImage, std::string bootImagePath)
 {
-    pImpl->Update(flashImage, bootImagePath);
+    pImpl->Update({flashImage}, bootImagePath);
+}
+
+void AstraDeviceManager::Update(std::vector<std::shared_ptr<FlashImage>> flashImages, std::string bootImagePath)
+{
+    pImpl->Update(flashImages, bootImagePath);
+}
+
+void AstraDeviceManager::UpdateStation(std::string stationPlanPath, std::string bootImagePath,
+    std::map<std::string, std::string> config)
+{
+    pImpl->UpdateStation(stationPlanPath, bootImagePath, config);
 }
 
 void AstraDeviceManager::Boot(std::string bootImagesPath, std::string bootCommand)
@@ -315,4 +1056,9 @@ bool AstraDeviceManager::Shutdown()
 std::string AstraDeviceManager::GetLogFile() const
 {
     return pImpl->GetLogFile();
+}
+
+std::vector<AstraDeviceProgress> AstraDeviceManager::GetProgressSnapshot()
+{
+    return pImpl->GetProgressSnapshot();
 }
\ No newline at end of file
@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#include <algorithm>
+
+#include "astra_device_state.hpp"
+#include "astra_log.hpp"
+
+namespace {
+
+constexpr uint32_t Bit(AstraDeviceStatus status)
+{
+    return 1u << status;
+}
+
+// Statuses from ASTRA_DEVICE_STATUS_IMAGE_SEND_START onwards are events reported
+// to the caller, not states, and never appear in this table.
+constexpr size_t stateCount = ASTRA_DEVICE_STATUS_UPDATE_FAIL + 1;
+
+constexpr std::array<uint32_t, stateCount> transitionTable = [] {
+    std::array<uint32_t, stateCount> table{};
+
+    table[ASTRA_DEVICE_STATUS_ADDED] = Bit(ASTRA_DEVICE_STATUS_OPENED) | Bit(ASTRA_DEVICE_STATUS_BOOT_FAIL);
+    table[ASTRA_DEVICE_STATUS_OPENED] = Bit(ASTRA_DEVICE_STATUS_BOOT_START) | Bit(ASTRA_DEVICE_STATUS_BOOT_FAIL);
+    table[ASTRA_DEVICE_STATUS_BOOT_START] = Bit(ASTRA_DEVICE_STATUS_BOOT_PROGRESS) | Bit(ASTRA_DEVICE_STATUS_BOOT_FAIL);
+    table[ASTRA_DEVICE_STATUS_BOOT_PROGRESS] = Bit(ASTRA_DEVICE_STATUS_BOOT_COMPLETE) | Bit(ASTRA_DEVICE_STATUS_BOOT_FAIL);
+    // Console and fastboot updates start without an image request
+    table[ASTRA_DEVICE_STATUS_BOOT_COMPLETE] = Bit(ASTRA_DEVICE_STATUS_UPDATE_START) | Bit(ASTRA_DEVICE_STATUS_UPDATE_PROGRESS) |
+        Bit(ASTRA_DEVICE_STATUS_UPDATE_FAIL);
+    table[ASTRA_DEVICE_STATUS_UPDATE_START] = Bit(ASTRA_DEVICE_STATUS_UPDATE_PROGRESS) | Bit(ASTRA_DEVICE_STATUS_UPDATE_FAIL);
+    table[ASTRA_DEVICE_STATUS_UPDATE_PROGRESS] = Bit(ASTRA_DEVICE_STATUS_UPDATE_COMPLETE) | Bit(ASTRA_DEVICE_STATUS_UPDATE_FAIL);
+
+    // Any state other than closed can be closed
+    for (size_t from = 0; from < stateCount; ++from) {
+        if (from != ASTRA_DEVICE_STATUS_CLOSED) {
+            table[from] |= Bit(ASTRA_DEVICE_STATUS_CLOSED);
+        }
+    }
+
+    return table;
+}();
+
+static_assert(stateCount <= 32, "each state keeps its allowed transitions in a 32 bit mask");
+static_assert(!(transitionTable[ASTRA_DEVICE_STATUS_BOOT_FAIL] & Bit(ASTRA_DEVICE_STATUS_BOOT_COMPLETE)),
+    "a failed boot is final");
+static_assert(!(transitionTable[ASTRA_DEVICE_STATUS_UPDATE_COMPLETE] & Bit(ASTRA_DEVICE_STATUS_UPDATE_FAIL)),
+    "a completed update is final");
+
+}
+
+bool AstraDeviceState::IsAllowed(AstraDeviceStatus from, AstraDeviceStatus to)
+{
+    if (static_cast<size_t>(from) >= stateCount || static_cast<size_t>(to) >= stateCount) {
+        return false;
+    }
+
+    return (transitionTable[from] & Bit(to)) != 0;
+}
+
+bool AstraDeviceState::Transition(AstraDeviceStatus status)
+{
+    ASTRA_LOG;
+
+    AstraDeviceStatus current = m_status.load(std::memory_order_acquire);
+    for (;;) {
+        if (current == status) {
+            return true;
+        }
+
+        if (!IsAllowed(current, status)) {
+            log(ASTRA_LOG_LEVEL_WARNING) << "Rejected transition " << AstraDevice::AstraDeviceStatusToString(current)
+                << " -> " << AstraDevice::AstraDeviceStatusToString(status) << endLog;
+            return false;
+        }
+
+        if (m_status.compare_exchange_weak(current, status, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            Record(current, status);
+            return true;
+        }
+    }
+}
+
+bool AstraDeviceState::Transition(AstraDeviceStatus from, AstraDeviceStatus status)
+{
+    if (!IsAllowed(from, status)) {
+        return false;
+    }
+
+    AstraDeviceStatus current = from;
+    if (!m_status.compare_exchange_strong(current, status, std::memory_order_acq_rel, std::memory_order_acquire)) {
+        return false;
+    }
+
+    Record(from, status);
+
+    return true;
+}
+
+void AstraDeviceState::Record(AstraDeviceStatus from, AstraDeviceStatus to)
+{
+    uint32_t index = m_traceCount.fetch_add(1, std::memory_order_relaxed);
+    TraceEntry &entry = m_trace[index % m_traceSize];
+
+    entry.m_time.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    entry.m_edge.store(static_cast<uint16_t>((from << 8) | to), std::memory_order_release);
+}
+
+std::vector<AstraDeviceTransition> AstraDeviceState::GetTrace() const
+{
+    std::vector<AstraDeviceTransition> trace;
+
+    uint32_t count = m_traceCount.load(std::memory_order_acquire);
+    uint32_t first = count > m_traceSize ? count - m_traceSize : 0;
+    for (uint32_t i = first; i < count; ++i) {
+        const TraceEntry &entry = m_trace[i % m_traceSize];
+        uint16_t edge = entry.m_edge.load(std::memory_order_acquire);
+        std::chrono::steady_clock::duration time(entry.m_time.load(std::memory_order_relaxed));
+
+        trace.push_back({static_cast<AstraDeviceStatus>(edge >> 8), static_cast<AstraDeviceStatus>(edge & 0xFF),
+            std::chrono::steady_clock::time_point(time)});
+    }
+
+    return trace;
+}
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "astra_device.hpp"
+
+// Device session state. Transitions are checked against a fixed table and
+// applied with a compare and swap, so the libusb event thread, the reactor and
+// the manager can all move the state without a lock. Every accepted
+// transition is recorded with a timestamp.
+class AstraDeviceState
+{
+public:
+    AstraDeviceStatus Get() const { return m_status.load(std::memory_order_acquire); }
+
+    // Move to status if the table allows it from the current state. Moving to the
+    // current state succeeds without being recorded.
+    bool Transition(AstraDeviceStatus status);
+    // Move to status only if the device is currently in from
+    bool Transition(AstraDeviceStatus from, AstraDeviceStatus status);
+
+    static bool IsAllowed(AstraDeviceStatus from, AstraDeviceStatus to);
+
+    // The most recent transitions, oldest first
+    std::vector<AstraDeviceTransition> GetTrace() const;
+
+private:
+    std::atomic<AstraDeviceStatus> m_status{ASTRA_DEVICE_STATUS_ADDED};
+
+    struct TraceEntry {
+        std::atomic<uint16_t> m_edge{0};
+        std::atomic<int64_t> m_time{0};
+    };
+    static constexpr uint32_t m_traceSize = 32;
+    std::array<TraceEntry, m_traceSize> m_trace;
+    std::atomic<uint32_t> m_traceCount{0};
+
+    void Record(AstraDeviceStatus from, AstraDeviceStatus to);
+};
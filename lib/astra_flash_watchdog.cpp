@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#include <utility>
+
+#include "astra_flash_watchdog.hpp"
+
+void AstraFlashWatchdog::Arm(AstraReactor::Clock::duration timeout, AstraReactor::Task task)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_strand->CancelTimer(m_timer);
+    m_timer = 0;
+    m_timeout = timeout;
+    m_task = timeout.count() == 0 ? nullptr : std::move(task);
+    if (m_flashPhase) {
+        Start();
+    }
+}
+
+void AstraFlashWatchdog::StartFlashPhase()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_flashPhase = true;
+    Start();
+}
+
+void AstraFlashWatchdog::Cancel()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_strand->CancelTimer(m_timer);
+    m_timer = 0;
+    m_task = nullptr;
+}
+
+void AstraFlashWatchdog::Start()
+{
+    if (m_task) {
+        m_timer = m_strand->PostAfter(m_timeout, std::move(m_task));
+        m_task = nullptr;
+    }
+}
@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+
+#include "astra_reactor.hpp"
+
+// Watchdog for the flash command of an update. The flash targets are loaded
+// when the update is requested, which is usually while the device is still
+// booting, but the command only runs once U-Boot is up. A watchdog armed
+// before StartFlashPhase() waits for it, so a long boot is covered by the boot
+// deadline alone and not counted against the flash command.
+class AstraFlashWatchdog
+{
+public:
+    AstraFlashWatchdog(std::shared_ptr<AstraStrand> strand) : m_strand{strand}
+    {}
+
+    // Replace the watchdog. task runs on the strand if timeout passes after the
+    // start of the flash phase. A zero timeout disables the watchdog.
+    void Arm(AstraReactor::Clock::duration timeout, AstraReactor::Task task);
+    // Called once the boot is complete. Starts the armed watchdog, and any armed later.
+    void StartFlashPhase();
+    void Cancel();
+
+private:
+    std::shared_ptr<AstraStrand> m_strand;
+    std::mutex m_mutex;
+    bool m_flashPhase = false;
+    AstraReactor::Clock::duration m_timeout{0};
+    // Set while armed and waiting for the flash phase
+    AstraReactor::Task m_task;
+    AstraReactor::TimerId m_timer = 0;
+
+    void Start();
+};
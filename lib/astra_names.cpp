@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "astra_names.hpp"
+
+namespace {
+
+struct NameTable {
+    std::shared_mutex m_mutex;
+    // A deque so references returned by Lookup() stay valid as names are added
+    std::deque<std::string> m_names{std::string()};
+    std::unordered_map<std::string, AstraNameId> m_ids;
+};
+
+NameTable &GetNameTable()
+{
+    static NameTable nameTable;
+    return nameTable;
+}
+
+}
+
+AstraNameId AstraNames::Intern(const std::string &name)
+{
+    if (name.empty()) {
+        return ASTRA_NAME_NONE;
+    }
+
+    NameTable &table = GetNameTable();
+
+    {
+        std::shared_lock<std::shared_mutex> lock(table.m_mutex);
+        auto it = table.m_ids.find(name);
+        if (it != table.m_ids.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(table.m_mutex);
+    auto it = table.m_ids.find(name);
+    if (it != table.m_ids.end()) {
+        return it->second;
+    }
+
+    AstraNameId id = static_cast<AstraNameId>(table.m_names.size());
+    table.m_names.push_back(name);
+    table.m_ids.emplace(name, id);
+
+    return id;
+}
+
+const std::string &AstraNames::Lookup(AstraNameId id)
+{
+    NameTable &table = GetNameTable();
+
+    std::shared_lock<std::shared_mutex> lock(table.m_mutex);
+    if (id >= table.m_names.size()) {
+        return table.m_names[ASTRA_NAME_NONE];
+    }
+
+    return table.m_names[id];
+}
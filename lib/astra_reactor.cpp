@@ -0,0 +1,282 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#include <algorithm>
+
+#include "astra_reactor.hpp"
+#include "astra_log.hpp"
+
+AstraReactor::AstraReactor(size_t threadCount, size_t blockingThreadCount)
+{
+    ASTRA_LOG;
+
+    if (threadCount == 0) {
+        threadCount = std::clamp<size_t>(std::thread::hardware_concurrency(), 2, 4);
+    }
+    if (blockingThreadCount == 0) {
+        blockingThreadCount = m_defaultBlockingThreads;
+    }
+
+    log(ASTRA_LOG_LEVEL_DEBUG) << "Starting reactor with " << threadCount << " threads and " << blockingThreadCount
+        << " blocking threads" << endLog;
+
+    for (size_t i = 0; i < threadCount; ++i) {
+        m_threads.emplace_back(&AstraReactor::WorkerThread, this);
+    }
+    std::lock_guard<std::mutex> lock(m_blockingMutex);
+    m_blockingCancels.resize(blockingThreadCount);
+    for (size_t i = 0; i < blockingThreadCount; ++i) {
+        m_blockingThreads.emplace_back(&AstraReactor::BlockingThread, this, i);
+    }
+}
+
+AstraReactor::~AstraReactor()
+{
+    Shutdown();
+}
+
+void AstraReactor::Post(Task task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_cv.notify_one();
+}
+
+AstraReactor::TimerId AstraReactor::PostAfter(Clock::duration delay, Task task)
+{
+    TimerId id;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        id = m_nextTimerId++;
+        m_timerWheel.Add(id, Clock::now() + delay, std::move(task));
+    }
+    // The new timer may be earlier than the one the idle threads are waiting for
+    m_cv.notify_all();
+
+    return id;
+}
+
+bool AstraReactor::CancelTimer(TimerId id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_timerWheel.Cancel(id);
+}
+
+size_t AstraReactor::GetTimerCount()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_timerWheel.Size();
+}
+
+void AstraReactor::PostBlocking(Task task, Task cancel)
+{
+    ASTRA_LOG;
+
+    {
+        std::lock_guard<std::mutex> lock(m_blockingMutex);
+        if (m_blockingShutdown) {
+            log(ASTRA_LOG_LEVEL_WARNING) << "Blocking job posted after shutdown" << endLog;
+            return;
+        }
+        m_blockingTasks.push_back({std::move(task), std::move(cancel)});
+    }
+    m_blockingCV.notify_one();
+}
+
+void AstraReactor::SetBlockingThreadCount(size_t threadCount)
+{
+    ASTRA_LOG;
+
+    std::lock_guard<std::mutex> lock(m_blockingMutex);
+    if (m_blockingShutdown || threadCount <= m_blockingThreads.size()) {
+        return;
+    }
+
+    log(ASTRA_LOG_LEVEL_DEBUG) << "Growing blocking pool to " << threadCount << " threads" << endLog;
+    m_blockingCancels.resize(threadCount);
+    while (m_blockingThreads.size() < threadCount) {
+        m_blockingThreads.emplace_back(&AstraReactor::BlockingThread, this, m_blockingThreads.size());
+    }
+}
+
+size_t AstraReactor::GetBlockingThreadCount()
+{
+    std::lock_guard<std::mutex> lock(m_blockingMutex);
+    return m_blockingThreads.size();
+}
+
+void AstraReactor::Shutdown()
+{
+    ASTRA_LOG;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_shutdown) {
+            return;
+        }
+        m_shutdown = true;
+    }
+
+    // Blocking jobs post their results back to the pool so stop them first
+    std::deque<BlockingJob> dropped;
+    std::vector<Task> cancels;
+    {
+        std::lock_guard<std::mutex> lock(m_blockingMutex);
+        m_blockingShutdown = true;
+        dropped.swap(m_blockingTasks);
+        for (auto &cancel : m_blockingCancels) {
+            if (cancel) {
+                cancels.push_back(cancel);
+            }
+        }
+    }
+    m_blockingCV.notify_all();
+
+    if (!dropped.empty()) {
+        log(ASTRA_LOG_LEVEL_WARNING) << "Dropping " << dropped.size() << " blocking jobs which did not start" << endLog;
+        dropped.clear();
+    }
+    if (!cancels.empty()) {
+        log(ASTRA_LOG_LEVEL_INFO) << "Cancelling " << cancels.size() << " running blocking jobs" << endLog;
+        for (auto &cancel : cancels) {
+            cancel();
+        }
+    }
+    for (auto &thread : m_blockingThreads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    m_cv.notify_all();
+
+    for (auto &thread : m_threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    m_timerWheel.Clear();
+}
+
+void AstraReactor::WorkerThread()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;) {
+        if (!m_shutdown) {
+            m_timerWheel.Advance(Clock::now(), m_tasks);
+        }
+
+        if (!m_tasks.empty()) {
+            Task task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+            if (!m_tasks.empty()) {
+                m_cv.notify_one();
+            }
+
+            lock.unlock();
+            task();
+            lock.lock();
+            continue;
+        }
+
+        if (m_shutdown) {
+            break;
+        }
+
+        if (m_timerWheel.Empty()) {
+            m_cv.wait(lock);
+        } else {
+            m_cv.wait_until(lock, m_timerWheel.GetNextWakeup());
+        }
+    }
+}
+
+void AstraReactor::BlockingThread(size_t index)
+{
+    std::unique_lock<std::mutex> lock(m_blockingMutex);
+
+    for (;;) {
+        if (!m_blockingTasks.empty()) {
+            BlockingJob job = std::move(m_blockingTasks.front());
+            m_blockingTasks.pop_front();
+            m_blockingCancels[index] = std::move(job.m_cancel);
+
+            lock.unlock();
+            job.m_task();
+            lock.lock();
+            m_blockingCancels[index] = nullptr;
+            continue;
+        }
+
+        if (m_blockingShutdown) {
+            break;
+        }
+
+        m_blockingCV.wait(lock);
+    }
+}
+
+void AstraStrand::Post(AstraReactor::Task task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_closed) {
+            return;
+        }
+        m_tasks.push_back(std::move(task));
+        if (m_scheduled) {
+            return;
+        }
+        m_scheduled = true;
+    }
+
+    m_reactor.Post([self = shared_from_this()] {
+        self->Run();
+    });
+}
+
+AstraReactor::TimerId AstraStrand::PostAfter(AstraReactor::Clock::duration delay, AstraReactor::Task task)
+{
+    return m_reactor.PostAfter(delay, [self = shared_from_this(), task = std::move(task)]() mutable {
+        self->Post(std::move(task));
+    });
+}
+
+void AstraStrand::Close()
+{
+    std::deque<AstraReactor::Task> tasks;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        tasks.swap(m_tasks);
+    }
+    // The dropped tasks are destroyed without the lock, they may return buffers
+    // which are handed to other strands
+}
+
+void AstraStrand::Run()
+{
+    // Run a bounded batch so one busy session can not starve the others
+    for (int i = 0; i < 16; ++i) {
+        AstraReactor::Task task;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_tasks.empty()) {
+                m_scheduled = false;
+                return;
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+
+        task();
+    }
+
+    m_reactor.Post([self = shared_from_this()] {
+        self->Run();
+    });
+}
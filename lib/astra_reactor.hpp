@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "astra_timer_wheel.hpp"
+
+// Small fixed pool of threads which run posted tasks and timers. Device sessions
+// are driven by USB events, console prompts and timers posted here instead of
+// each device owning threads which block waiting for those events. All session
+// watchdogs share one timer wheel.
+class AstraReactor
+{
+public:
+    using Task = AstraTimerWheel::Task;
+    using Clock = AstraTimerWheel::Clock;
+    using TimerId = AstraTimerWheel::TimerId;
+
+    // blockingThreadCount sizes the pool which runs PostBlocking() jobs
+    AstraReactor(size_t threadCount = 0, size_t blockingThreadCount = 0);
+    ~AstraReactor();
+
+    void Post(Task task);
+    TimerId PostAfter(Clock::duration delay, Task task);
+    // Returns false if the timer already fired or was cancelled
+    bool CancelTimer(TimerId id);
+
+    // Run a job which blocks for a long time, such as a console script or a
+    // fastboot download, on the blocking pool so it does not stall the reactor
+    // threads. Jobs wait in a queue while every blocking thread is busy. cancel
+    // is called by Shutdown() if the job is still running, to make it return.
+    void PostBlocking(Task task, Task cancel = nullptr);
+    // Grow the blocking pool, such as when the active session limit is raised.
+    // The pool never shrinks.
+    void SetBlockingThreadCount(size_t threadCount);
+    size_t GetBlockingThreadCount();
+
+    // Drops the blocking jobs which have not started, cancels the running ones, then
+    // runs the tasks which are already queued, drops pending timers and joins all threads
+    void Shutdown();
+
+    size_t GetThreadCount() const { return m_threads.size(); }
+    size_t GetTimerCount();
+
+private:
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<Task> m_tasks;
+    AstraTimerWheel m_timerWheel;
+    TimerId m_nextTimerId = 1;
+    bool m_shutdown = false;
+
+    struct BlockingJob {
+        Task m_task;
+        Task m_cancel;
+    };
+    std::vector<std::thread> m_blockingThreads;
+    std::mutex m_blockingMutex;
+    std::condition_variable m_blockingCV;
+    std::deque<BlockingJob> m_blockingTasks;
+    // Cancel of the job each blocking thread is running, if any
+    std::vector<Task> m_blockingCancels;
+    bool m_blockingShutdown = false;
+    static constexpr size_t m_defaultBlockingThreads = 16;
+
+    void WorkerThread();
+    void BlockingThread(size_t index);
+};
+
+// Runs tasks one at a time and in the order they were posted while still
+// sharing the reactor threads. Each device session owns one.
+class AstraStrand : public std::enable_shared_from_this<AstraStrand>
+{
+public:
+    AstraStrand(AstraReactor &reactor) : m_reactor{reactor}
+    {}
+
+    void Post(AstraReactor::Task task);
+    AstraReactor::TimerId PostAfter(AstraReactor::Clock::duration delay, AstraReactor::Task task);
+    bool CancelTimer(AstraReactor::TimerId id) { return m_reactor.CancelTimer(id); }
+    // Drop the queued tasks and every task posted later, including those of timers
+    // which already fired. Called from a task on this strand, so once it returns
+    // no task of the strand is running or will run.
+    void Close();
+
+    AstraReactor &GetReactor() { return m_reactor; }
+
+private:
+    AstraReactor &m_reactor;
+    std::mutex m_mutex;
+    std::deque<AstraReactor::Task> m_tasks;
+    bool m_scheduled = false;
+    bool m_closed = false;
+
+    void Run();
+};
@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#include <iomanip>
+
+#include "astra_session_history.hpp"
+#include "astra_log.hpp"
+
+AstraSessionHistory::AstraSessionHistory(size_t capacity) : m_capacity{capacity ? capacity : 1}
+{}
+
+int AstraSessionHistory::Configure(size_t capacity, const std::string &spillPath)
+{
+    ASTRA_LOG;
+
+    m_ring.clear();
+    m_ring.shrink_to_fit();
+    m_capacity = capacity ? capacity : 1;
+    m_next = 0;
+
+    if (m_spillFile.is_open()) {
+        m_spillFile.close();
+    }
+    if (!spillPath.empty()) {
+        m_spillFile.open(spillPath, std::ios::out | std::ios::app);
+        if (!m_spillFile.is_open()) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "Failed to open session history file: " << spillPath << endLog;
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+void AstraSessionHistory::Add(const AstraSessionSummary &summary)
+{
+    ++m_totalSessions;
+    if (summary.m_status == ASTRA_DEVICE_STATUS_BOOT_FAIL || summary.m_status == ASTRA_DEVICE_STATUS_UPDATE_FAIL ||
+        summary.m_status == ASTRA_DEVICE_STATUS_VERIFY_FAIL)
+    {
+        ++m_failedSessions;
+    }
+
+    if (m_ring.size() < m_capacity) {
+        m_ring.push_back(summary);
+        return;
+    }
+
+    Spill(m_ring[m_next]);
+    m_ring[m_next] = summary;
+    m_next = (m_next + 1) % m_capacity;
+}
+
+std::vector<AstraSessionSummary> AstraSessionHistory::Get() const
+{
+    std::vector<AstraSessionSummary> summaries;
+
+    summaries.reserve(m_ring.size());
+    for (size_t i = 0; i < m_ring.size(); ++i) {
+        summaries.push_back(m_ring[(m_next + i) % m_ring.size()]);
+    }
+
+    return summaries;
+}
+
+void AstraSessionHistory::Close()
+{
+    if (!m_spillFile.is_open()) {
+        return;
+    }
+
+    for (const auto &summary : Get()) {
+        Spill(summary);
+    }
+    m_ring.clear();
+    m_next = 0;
+    m_spillFile.close();
+}
+
+void AstraSessionHistory::Spill(const AstraSessionSummary &summary)
+{
+    if (!m_spillFile.is_open()) {
+        return;
+    }
+
+    auto t = std::chrono::system_clock::to_time_t(summary.m_finishTime);
+    auto tm = *std::localtime(&t);
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(summary.m_duration);
+
+    m_spillFile << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << " " << AstraNames::Lookup(summary.m_deviceId) << " "
+        << AstraDevice::AstraDeviceStatusToString(summary.m_status) << " bytes: " << summary.m_totalBytesSent
+        << " images: " << summary.m_imagesSent << " retries: " << summary.m_retries
+        << " duration: " << duration.count() / 1000.0 << "s" << std::endl;
+}
@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "astra_device.hpp"
+
+// Summaries of the most recent finished sessions in a fixed size ring, so a
+// station which runs for days keeps a bounded history however many boards it
+// has seen. Summaries pushed out of the ring are appended to an optional spill
+// file, which then holds every session once Close() writes the rest. Not thread
+// safe, the device manager calls it with its lock held.
+class AstraSessionHistory
+{
+public:
+    static constexpr size_t m_defaultCapacity = 256;
+
+    AstraSessionHistory(size_t capacity = m_defaultCapacity);
+
+    // Drops the summaries already recorded. An empty spillPath disables spilling.
+    // Returns -1 if the spill file can not be opened.
+    int Configure(size_t capacity, const std::string &spillPath);
+    void Add(const AstraSessionSummary &summary);
+    // Oldest first
+    std::vector<AstraSessionSummary> Get() const;
+    uint64_t GetTotalSessions() const { return m_totalSessions; }
+    uint64_t GetFailedSessions() const { return m_failedSessions; }
+    // Spill the summaries still in the ring and close the spill file
+    void Close();
+
+private:
+    std::vector<AstraSessionSummary> m_ring;
+    size_t m_capacity;
+    // Slot the next summary is written to once the ring is full
+    size_t m_next = 0;
+    uint64_t m_totalSessions = 0;
+    uint64_t m_failedSessions = 0;
+    std::ofstream m_spillFile;
+
+    void Spill(const AstraSessionSummary &summary);
+};
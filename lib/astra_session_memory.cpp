@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#include "astra_session_memory.hpp"
+#include "astra_log.hpp"
+
+AstraSessionMemory::AstraSessionMemory()
+{}
+
+AstraSessionMemory::~AstraSessionMemory()
+{
+    ASTRA_LOG;
+
+    if (m_bytesInUse.load() != 0) {
+        log(ASTRA_LOG_LEVEL_WARNING) << "Session memory destroyed with " << m_bytesInUse.load() << " bytes in use" << endLog;
+    }
+}
+
+AstraDeviceMemoryStats AstraSessionMemory::GetStats() const
+{
+    AstraDeviceMemoryStats stats;
+
+    stats.m_allocations = m_allocations.load(std::memory_order_relaxed);
+    stats.m_deallocations = m_deallocations.load(std::memory_order_relaxed);
+    stats.m_bytesInUse = m_bytesInUse.load(std::memory_order_relaxed);
+    stats.m_peakBytesInUse = m_peakBytesInUse.load(std::memory_order_relaxed);
+    stats.m_releases = m_releases.load(std::memory_order_relaxed);
+
+    return stats;
+}
+
+bool AstraSessionMemory::Release()
+{
+    ASTRA_LOG;
+
+    if (m_bytesInUse.load() != 0) {
+        log(ASTRA_LOG_LEVEL_DEBUG) << "Deferring session memory release, " << m_bytesInUse.load() << " bytes in use" << endLog;
+        return false;
+    }
+
+#ifdef __cpp_lib_memory_resource
+    m_pool.release();
+#endif
+    m_releases.fetch_add(1, std::memory_order_relaxed);
+
+    return true;
+}
+
+#ifdef __cpp_lib_memory_resource
+void *AstraSessionMemory::do_allocate(size_t bytes, size_t alignment)
+{
+    void *p = m_pool.allocate(bytes, alignment);
+
+    m_allocations.fetch_add(1, std::memory_order_relaxed);
+    uint64_t inUse = m_bytesInUse.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    uint64_t peak = m_peakBytesInUse.load(std::memory_order_relaxed);
+    while (inUse > peak && !m_peakBytesInUse.compare_exchange_weak(peak, inUse, std::memory_order_relaxed)) {
+    }
+
+    return p;
+}
+
+void AstraSessionMemory::do_deallocate(void *p, size_t bytes, size_t alignment)
+{
+    m_pool.deallocate(p, bytes, alignment);
+
+    m_deallocations.fetch_add(1, std::memory_order_relaxed);
+    m_bytesInUse.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+bool AstraSessionMemory::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+#endif
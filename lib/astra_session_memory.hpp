@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#endif
+
+#include "astra_device.hpp"
+
+// Pool owned by one device session for its image table and console text. The
+// table, the Image objects it holds and the console buffer are allocated from
+// it, so rebuilding the table or appending U-Boot output does not contend with
+// other sessions in the global allocator and the pool is returned in one step
+// when the session closes. The short names, paths and commands a session keeps
+// are passed to and from std::string interfaces and still come from the
+// default allocator. Toolchains without std::pmr fall back to the default
+// allocator and report no counters.
+class AstraSessionMemory
+#ifdef __cpp_lib_memory_resource
+    : public std::pmr::memory_resource
+#endif
+{
+public:
+#ifdef __cpp_lib_memory_resource
+    template <typename T>
+    using Allocator = std::pmr::polymorphic_allocator<T>;
+    template <typename T>
+    using Vector = std::pmr::vector<T>;
+    using String = std::pmr::string;
+#else
+    template <typename T>
+    using Allocator = std::allocator<T>;
+    template <typename T>
+    using Vector = std::vector<T>;
+    using String = std::string;
+#endif
+
+    AstraSessionMemory();
+    ~AstraSessionMemory();
+
+    template <typename T>
+    Allocator<T> GetAllocator()
+    {
+#ifdef __cpp_lib_memory_resource
+        return Allocator<T>(this);
+#else
+        return Allocator<T>();
+#endif
+    }
+
+    // Allocates the object and its control block from the session pool
+    template <typename T, typename... Args>
+    std::shared_ptr<T> MakeShared(Args &&...args)
+    {
+        return std::allocate_shared<T>(GetAllocator<T>(), std::forward<Args>(args)...);
+    }
+
+    AstraDeviceMemoryStats GetStats() const;
+
+    // Returns the pool to the system if nothing is still allocated from it.
+    // Returns false if allocations are outstanding, in which case the pool is
+    // released when the session is destroyed.
+    bool Release();
+
+#ifdef __cpp_lib_memory_resource
+private:
+    std::pmr::synchronized_pool_resource m_pool;
+
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+#endif
+
+private:
+    std::atomic<uint64_t> m_allocations{0};
+    std::atomic<uint64_t> m_deallocations{0};
+    std::atomic<uint64_t> m_bytesInUse{0};
+    std::atomic<uint64_t> m_peakBytesInUse{0};
+    std::atomic<uint64_t> m_releases{0};
+};
@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#include "astra_timer_wheel.hpp"
+
+AstraTimerWheel::AstraTimerWheel() : m_start{Clock::now()}
+{}
+
+uint64_t AstraTimerWheel::ToTick(Clock::time_point time) const
+{
+    if (time <= m_start) {
+        return 0;
+    }
+
+    return static_cast<uint64_t>((time - m_start) / m_tick);
+}
+
+void AstraTimerWheel::Add(TimerId id, Clock::time_point deadline, Task task)
+{
+    // Round up so a timer never fires early
+    uint64_t expiry = ToTick(deadline);
+    if (m_start + expiry * m_tick < deadline) {
+        ++expiry;
+    }
+    if (expiry <= m_currentTick) {
+        expiry = m_currentTick + 1;
+    }
+
+    Insert({id, expiry, std::move(task)}, nullptr);
+}
+
+void AstraTimerWheel::Insert(Timer timer, std::deque<Task> *expired)
+{
+    if (timer.m_expiry <= m_currentTick && expired) {
+        // Cascaded into the past, run it now
+        m_locations.erase(timer.m_id);
+        expired->push_back(std::move(timer.m_task));
+        return;
+    }
+
+    uint64_t delta = timer.m_expiry - m_currentTick;
+    int level = 0;
+    while (level < m_levels - 1 && delta >= (uint64_t(1) << (m_levelBits * (level + 1)))) {
+        ++level;
+    }
+
+    // Beyond the top level the timer waits in the furthest slot and is placed
+    // again when that slot is cascaded
+    uint64_t placement = timer.m_expiry;
+    uint64_t range = uint64_t(1) << (m_levelBits * m_levels);
+    if (delta >= range) {
+        placement = m_currentTick + range - 1;
+    }
+
+    uint64_t slot = (placement >> (m_levelBits * level)) & m_slotMask;
+    Slot &list = m_wheel[level][slot];
+    TimerId id = timer.m_id;
+    list.push_back(std::move(timer));
+    m_locations[id] = {level, slot, std::prev(list.end())};
+}
+
+bool AstraTimerWheel::Cancel(TimerId id)
+{
+    auto it = m_locations.find(id);
+    if (it == m_locations.end()) {
+        return false;
+    }
+
+    m_wheel[it->second.m_level][it->second.m_slot].erase(it->second.m_it);
+    m_locations.erase(it);
+
+    return true;
+}
+
+void AstraTimerWheel::Cascade(int level, std::deque<Task> &expired)
+{
+    uint64_t slot = (m_currentTick >> (m_levelBits * level)) & m_slotMask;
+    Slot list;
+    list.swap(m_wheel[level][slot]);
+
+    for (auto &timer : list) {
+        Insert(std::move(timer), &expired);
+    }
+}
+
+void AstraTimerWheel::Advance(Clock::time_point now, std::deque<Task> &expired)
+{
+    uint64_t target = ToTick(now);
+
+    if (m_locations.empty()) {
+        if (target > m_currentTick) {
+            m_currentTick = target;
+        }
+        return;
+    }
+
+    while (m_currentTick < target) {
+        ++m_currentTick;
+
+        // Each time a level wraps, move the next slot of the level above down
+        for (int level = 1; level < m_levels; ++level) {
+            if ((m_currentTick & ((uint64_t(1) << (m_levelBits * level)) - 1)) != 0) {
+                break;
+            }
+            Cascade(level, expired);
+        }
+
+        Slot &list = m_wheel[0][m_currentTick & m_slotMask];
+        for (auto it = list.begin(); it != list.end();) {
+            if (it->m_expiry <= m_currentTick) {
+                m_locations.erase(it->m_id);
+                expired.push_back(std::move(it->m_task));
+                it = list.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        if (m_locations.empty()) {
+            m_currentTick = target;
+        }
+    }
+}
+
+AstraTimerWheel::Clock::time_point AstraTimerWheel::GetNextWakeup() const
+{
+    // The nearest timer in the lowest level, or the next cascade if it is empty
+    uint64_t wrap = (m_currentTick | m_slotMask) + 1;
+    for (uint64_t tick = m_currentTick + 1; tick < wrap; ++tick) {
+        if (!m_wheel[0][tick & m_slotMask].empty()) {
+            return m_start + tick * m_tick;
+        }
+    }
+
+    return m_start + wrap * m_tick;
+}
+
+void AstraTimerWheel::Clear()
+{
+    for (auto &level : m_wheel) {
+        for (auto &slot : level) {
+            slot.clear();
+        }
+    }
+    m_locations.clear();
+}
@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <unordered_map>
+
+// Hierarchical timer wheel with a 10 ms tick. Adding and cancelling a timer is
+// O(1) however many sessions have watchdogs pending, and timers further out
+// are cascaded down a level at a time as the wheel turns. Not thread safe, the
+// reactor calls it with its lock held.
+class AstraTimerWheel
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using Task = std::function<void()>;
+    using TimerId = uint64_t;
+
+    static constexpr Clock::duration m_tick = std::chrono::milliseconds(10);
+
+    AstraTimerWheel();
+
+    void Add(TimerId id, Clock::time_point deadline, Task task);
+    // Returns false if the timer already fired or was cancelled
+    bool Cancel(TimerId id);
+    // Move the tasks of every timer which expired by now to expired
+    void Advance(Clock::time_point now, std::deque<Task> &expired);
+    // Time the reactor should wake up to call Advance() again. Only valid if not Empty().
+    Clock::time_point GetNextWakeup() const;
+
+    bool Empty() const { return m_locations.empty(); }
+    size_t Size() const { return m_locations.size(); }
+    void Clear();
+
+private:
+    static constexpr int m_levelBits = 6;
+    static constexpr uint64_t m_slotsPerLevel = 1 << m_levelBits;
+    static constexpr uint64_t m_slotMask = m_slotsPerLevel - 1;
+    static constexpr int m_levels = 4;
+
+    struct Timer {
+        TimerId m_id;
+        uint64_t m_expiry;
+        Task m_task;
+    };
+    using Slot = std::list<Timer>;
+
+    struct Location {
+        int m_level;
+        uint64_t m_slot;
+        Slot::iterator m_it;
+    };
+
+    Clock::time_point m_start;
+    uint64_t m_currentTick = 0;
+    std::array<std::array<Slot, m_slotsPerLevel>, m_levels> m_wheel;
+    std::unordered_map<TimerId, Location> m_locations;
+
+    uint64_t ToTick(Clock::time_point time) const;
+    void Insert(Timer timer, std::deque<Task> *expired);
+    void Cascade(int level, std::deque<Task> &expired);
+};
@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ASTRA_BLOCK_SCAN_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define ASTRA_BLOCK_SCAN_NEON
+#endif
+
+#include "block_scan.hpp"
+
+bool IsBlockFilledWith(const uint8_t *data, size_t size, uint32_t pattern)
+{
+    size_t i = 0;
+
+#if defined(ASTRA_BLOCK_SCAN_SSE2)
+    const __m128i fill = _mm_set1_epi32(static_cast<int>(pattern));
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 64 <= size; i += 64) {
+        __m128i a = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)), fill);
+        __m128i b = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + 16)), fill);
+        __m128i c = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + 32)), fill);
+        __m128i d = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + 48)), fill);
+        __m128i diff = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+        // Most data blocks differ within the first few bytes, so exit early
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(diff, zero)) != 0xFFFF) {
+            return false;
+        }
+    }
+#elif defined(ASTRA_BLOCK_SCAN_NEON)
+    const uint32x4_t fill = vdupq_n_u32(pattern);
+    for (; i + 64 <= size; i += 64) {
+        uint32x4_t a = veorq_u32(vreinterpretq_u32_u8(vld1q_u8(data + i)), fill);
+        uint32x4_t b = veorq_u32(vreinterpretq_u32_u8(vld1q_u8(data + i + 16)), fill);
+        uint32x4_t c = veorq_u32(vreinterpretq_u32_u8(vld1q_u8(data + i + 32)), fill);
+        uint32x4_t d = veorq_u32(vreinterpretq_u32_u8(vld1q_u8(data + i + 48)), fill);
+        uint64x2_t diff = vreinterpretq_u64_u32(vorrq_u32(vorrq_u32(a, b), vorrq_u32(c, d)));
+        if ((vgetq_lane_u64(diff, 0) | vgetq_lane_u64(diff, 1)) != 0) {
+            return false;
+        }
+    }
+#endif
+
+    for (; i + sizeof(uint32_t) <= size; i += sizeof(uint32_t)) {
+        uint32_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        if (word != pattern) {
+            return false;
+        }
+    }
+
+    // Trailing bytes of a block which is not a multiple of 4 bytes
+    uint8_t patternBytes[sizeof(uint32_t)];
+    std::memcpy(patternBytes, &pattern, sizeof(pattern));
+    for (size_t j = 0; i < size; ++i, ++j) {
+        if (data[i] != patternBytes[j]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool IsBlockFilled(const uint8_t *data, size_t size, uint32_t *pattern)
+{
+    if (size < sizeof(uint32_t)) {
+        return false;
+    }
+
+    std::memcpy(pattern, data, sizeof(*pattern));
+
+    return IsBlockFilledWith(data, size, *pattern);
+}
@@ -0,0 +1,14 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// Returns true if every 32 bit word in the block equals pattern.
+bool IsBlockFilledWith(const uint8_t *data, size_t size, uint32_t pattern);
+
+// Returns true if the block consists of a single repeated 32 bit value and
+// stores that value in pattern. Size must be a multiple of 4.
+bool IsBlockFilled(const uint8_t *data, size_t size, uint32_t *pattern);
@@ -0,0 +1,293 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#include <array>
+
+#include "crc32.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ASTRA_CRC32_PCLMUL 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define ASTRA_TARGET_PCLMUL
+#else
+#include <cpuid.h>
+#define ASTRA_TARGET_PCLMUL __attribute__((target("pclmul,sse4.1")))
+#endif
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+#define ASTRA_CRC32_ARMV8 1
+#include <arm_acle.h>
+#if defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#if defined(__clang__)
+#define ASTRA_TARGET_CRC __attribute__((target("crc")))
+#else
+#define ASTRA_TARGET_CRC __attribute__((target("+crc")))
+#endif
+#endif
+
+static constexpr uint32_t m_crc32Polynomial = 0xEDB88320;
+
+static std::array<uint32_t, 256> MakeCrc32Table()
+{
+    std::array<uint32_t, 256> table{};
+
+    for (uint32_t i = 0; i < table.size(); ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? (crc >> 1) ^ m_crc32Polynomial : crc >> 1;
+        }
+        table[i] = crc;
+    }
+
+    return table;
+}
+
+// Operates on the inverted CRC
+static uint32_t Crc32Table(uint32_t crc, const uint8_t *data, size_t size)
+{
+    static const std::array<uint32_t, 256> table = MakeCrc32Table();
+
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return crc;
+}
+
+#if ASTRA_CRC32_PCLMUL
+// Folds 64 bytes per iteration using carry-less multiplication, see Intel's
+// "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction".
+// Operates on the inverted CRC. size must be a multiple of 16 and at least 64.
+ASTRA_TARGET_PCLMUL
+static uint32_t Crc32Pclmul(uint32_t crc, const uint8_t *data, size_t size)
+{
+    alignas(16) static const uint64_t k1k2[2] = { 0x0154442bd4, 0x01c6e41596 };
+    alignas(16) static const uint64_t k3k4[2] = { 0x01751997d0, 0x00ccaa009e };
+    alignas(16) static const uint64_t k5k0[2] = { 0x0163cd6124, 0x0000000000 };
+    alignas(16) static const uint64_t poly[2] = { 0x01db710641, 0x01f7011641 };
+
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+    x1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x00));
+    x2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x10));
+    x3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x20));
+    x4 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x30));
+
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i *>(k1k2));
+
+    data += 64;
+    size -= 64;
+
+    while (size >= 64) {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+        y5 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x00));
+        y6 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x10));
+        y7 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x20));
+        y8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x30));
+
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+
+        data += 64;
+        size -= 64;
+    }
+
+    // Fold the four lanes into one
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i *>(k3k4));
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    while (size >= 16) {
+        x2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+        data += 16;
+        size -= 16;
+    }
+
+    // Fold 128 bits to 64 bits
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_srli_si128(x1, 8);
+    x1 = _mm_xor_si128(x1, x2);
+
+    x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(k5k0));
+
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, x3);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    // Barrett reduction to 32 bits
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i *>(poly));
+
+    x2 = _mm_and_si128(x1, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+}
+
+static bool HasPclmul()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    unsigned int ecx = static_cast<unsigned int>(info[2]);
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+#endif
+    // PCLMULQDQ and SSE4.1
+    return (ecx & (1u << 1)) && (ecx & (1u << 19));
+}
+#endif
+
+#if ASTRA_CRC32_ARMV8
+// Operates on the inverted CRC
+ASTRA_TARGET_CRC
+static uint32_t Crc32Armv8(uint32_t crc, const uint8_t *data, size_t size)
+{
+    while (size > 0 && (reinterpret_cast<uintptr_t>(data) & 7)) {
+        crc = __crc32b(crc, *data++);
+        --size;
+    }
+
+    while (size >= 32) {
+        crc = __crc32d(crc, *reinterpret_cast<const uint64_t *>(data));
+        crc = __crc32d(crc, *reinterpret_cast<const uint64_t *>(data + 8));
+        crc = __crc32d(crc, *reinterpret_cast<const uint64_t *>(data + 16));
+        crc = __crc32d(crc, *reinterpret_cast<const uint64_t *>(data + 24));
+        data += 32;
+        size -= 32;
+    }
+
+    while (size >= 8) {
+        crc = __crc32d(crc, *reinterpret_cast<const uint64_t *>(data));
+        data += 8;
+        size -= 8;
+    }
+
+    while (size > 0) {
+        crc = __crc32b(crc, *data++);
+        --size;
+    }
+
+    return crc;
+}
+
+static bool HasArmv8Crc()
+{
+#if defined(__APPLE__)
+    // All Apple silicon implements the CRC32 instructions
+    return true;
+#elif defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#else
+    return false;
+#endif
+}
+#endif
+
+uint32_t Crc32(uint32_t crc, const uint8_t *data, size_t size)
+{
+    crc = ~crc;
+
+#if ASTRA_CRC32_PCLMUL
+    static const bool hasPclmul = HasPclmul();
+    if (hasPclmul && size >= 64) {
+        size_t blockSize = size & ~static_cast<size_t>(15);
+        crc = Crc32Pclmul(crc, data, blockSize);
+        data += blockSize;
+        size -= blockSize;
+    }
+#elif ASTRA_CRC32_ARMV8
+    static const bool hasArmv8Crc = HasArmv8Crc();
+    if (hasArmv8Crc) {
+        return ~Crc32Armv8(crc, data, size);
+    }
+#endif
+
+    return ~Crc32Table(crc, data, size);
+}
+
+// Multiply a and b modulo the CRC polynomial, in the bit reflected representation
+static uint32_t MultModP(uint32_t a, uint32_t b)
+{
+    uint32_t m = 1u << 31;
+    uint32_t p = 0;
+
+    for (;;) {
+        if (a & m) {
+            p ^= b;
+            if ((a & (m - 1)) == 0) {
+                break;
+            }
+        }
+        m >>= 1;
+        b = (b & 1) ? (b >> 1) ^ m_crc32Polynomial : b >> 1;
+    }
+
+    return p;
+}
+
+uint32_t Crc32Combine(uint32_t crc1, uint32_t crc2, uint64_t size2)
+{
+    // x^(2^k) mod p for k = 0..63
+    static const std::array<uint32_t, 64> x2nTable = [] {
+        std::array<uint32_t, 64> table{};
+        uint32_t p = 1u << 30; // x^1
+        for (auto &entry : table) {
+            entry = p;
+            p = MultModP(p, p);
+        }
+        return table;
+    }();
+
+    // Shift crc1 by size2 bytes, i.e. multiply by x^(8 * size2)
+    uint32_t xn = 1u << 31; // x^0
+    uint64_t n = size2;
+    unsigned int k = 3;
+    while (n) {
+        if (n & 1) {
+            xn = MultModP(x2nTable[k & 63], xn);
+        }
+        n >>= 1;
+        ++k;
+    }
+
+    return MultModP(xn, crc1) ^ crc2;
+}
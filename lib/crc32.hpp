@@ -0,0 +1,15 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// CRC-32 (IEEE 802.3) as computed by zlib and the U-Boot crc32 command.
+// Pass the previous result as crc to continue a calculation, 0 to start one.
+// Uses PCLMULQDQ folding on x86 and the ARMv8 CRC32 instructions when the CPU supports them.
+uint32_t Crc32(uint32_t crc, const uint8_t *data, size_t size);
+
+// Returns the CRC of the concatenation of two blocks given their CRCs and the size of the second block.
+uint32_t Crc32Combine(uint32_t crc1, uint32_t crc2, uint64_t size2);
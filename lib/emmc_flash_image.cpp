@@ -2,13 +2,18 @@
 // Copyright 2025 Synaptics Incorporated
 
 #include <iostream>
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <vector>
+#include <memory>
+#include <iomanip>
 
 #include "image.hpp"
 #include "emmc_flash_image.hpp"
+#include "crc32.hpp"
 #include "astra_log.hpp"
 
 int EmmcFlashImage::Load()
@@ -17,13 +22,21 @@ int EmmcFlashImage::Load()
 
     int ret = 0;
 
+    auto transport = m_config.find("transport");
+    bool fastboot = transport != m_config.end() && transport->second == "fastboot";
+
     if (!m_imagePath.empty() && m_imagePath.back() == '/') {
         m_imagePath.erase(m_imagePath.size() - 1);
     }
 
     if (std::filesystem::exists(m_imagePath) && std::filesystem::is_directory(m_imagePath)) {
+        auto verify = m_config.find("verify");
+        if (verify != m_config.end() && !fastboot) {
+            m_verify = verify->second == "true";
+        }
         std::string directoryName = std::filesystem::path(m_imagePath).filename().string();
-        m_flashCommand = "l2emmc " + directoryName + m_resetCommand;
+        m_flashCommand = "l2emmc " + directoryName;
+        m_resetInFlashCommand = !m_verify;
         m_resetWhenComplete = true;
         for (const auto& entry : std::filesystem::directory_iterator(m_imagePath)) {
             log(ASTRA_LOG_LEVEL_DEBUG) << "Found file: " << entry.path() << endLog;
@@ -74,9 +87,89 @@ int EmmcFlashImage::Load()
 
     ParseEmmcImageList();
 
+    if (fastboot) {
+        return ParseFastbootPartitions();
+    }
+
+    if (m_verify) {
+        // Uses the original image list, before large images are split
+        ret = PrepareVerify();
+        if (ret < 0) {
+            return ret;
+        }
+    }
+
+    ret = SplitLargeImages();
+
     return ret;
 }
 
+int EmmcFlashImage::ParseFastbootPartitions()
+{
+    ASTRA_LOG;
+
+    auto imageListIt = std::find_if(m_images.begin(), m_images.end(), [](const Image &img) {
+        return img.GetName() == "emmc_image_list";
+    });
+    if (imageListIt == m_images.end()) {
+        log(ASTRA_LOG_LEVEL_ERROR) << "emmc_image_list not found" << endLog;
+        return -1;
+    }
+
+    std::ifstream file(imageListIt->GetPath());
+    std::string line;
+
+    while (std::getline(file, line)) {
+        std::istringstream iss(line);
+        std::string name;
+        std::string partition;
+        if (!std::getline(iss, name, ',') || !std::getline(iss, partition, ',')) {
+            continue;
+        }
+
+        auto it = std::find_if(m_images.begin(), m_images.end(), [&name](const Image &img) {
+            return img.GetName() == name;
+        });
+        if (it == m_images.end()) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "Image not found: " << name << endLog;
+            return -1;
+        }
+
+        std::string extension = std::filesystem::path(it->GetPath()).extension().string();
+        if (extension == ".gz" || extension == ".xz" || extension == ".bz2" || extension == ".zst" || extension == ".lz4") {
+            // Sparse images are generated from the raw partition contents
+            log(ASTRA_LOG_LEVEL_ERROR) << "Compressed image " << name << " cannot be sent with fastboot" << endLog;
+            return -1;
+        }
+
+        m_partitionImages.push_back({partition, it->GetPath()});
+    }
+
+    if (m_config.find("fastboot_vendor_id") != m_config.end()) {
+        m_fastbootVendorId = std::stoul(m_config["fastboot_vendor_id"], nullptr, 16);
+    }
+    if (m_config.find("fastboot_product_id") != m_config.end()) {
+        m_fastbootProductId = std::stoul(m_config["fastboot_product_id"], nullptr, 16);
+    }
+
+    std::string fastbootCommand = "fastboot usb 0";
+    if (m_config.find("fastboot_command") != m_config.end()) {
+        fastbootCommand = m_config["fastboot_command"];
+    }
+
+    // U-Boot only needs to start fastboot, the images are sent by the fastboot client
+    // and the host reboots the device once all of the partitions are flashed.
+    m_flashCommand = fastbootCommand;
+    m_resetInFlashCommand = false;
+    m_finalImage.clear();
+    m_useFastboot = true;
+    m_resetWhenComplete = true;
+
+    log(ASTRA_LOG_LEVEL_INFO) << "Flashing " << m_partitionImages.size() << " partitions using fastboot" << endLog;
+
+    return 0;
+}
+
 void EmmcFlashImage::ParseEmmcImageList()
 {
     ASTRA_LOG;
@@ -104,4 +197,279 @@ void EmmcFlashImage::ParseEmmcImageList()
 
     m_finalImage = lastEntryName;
     log(ASTRA_LOG_LEVEL_DEBUG) << "Final image: " << m_finalImage << endLog;
-}
\ No newline at end of file
+}
+
+int EmmcFlashImage::SplitLargeImages()
+{
+    ASTRA_LOG;
+
+    uint64_t maxChunkSize = m_defaultMaxChunkSize;
+    if (m_config.find("max_chunk_size") != m_config.end()) {
+        maxChunkSize = std::stoull(m_config["max_chunk_size"], nullptr, 0);
+        // Chunks are written at offsets within the partition, so keep them block aligned
+        maxChunkSize -= maxChunkSize % m_chunkAlignment;
+        if (maxChunkSize == 0 || maxChunkSize > UINT32_MAX) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "Invalid max_chunk_size: " << m_config["max_chunk_size"] << endLog;
+            return -1;
+        }
+    }
+
+    auto imageListIt = std::find_if(m_images.begin(), m_images.end(), [](const Image &img) {
+        return img.GetName() == "emmc_image_list";
+    });
+    if (imageListIt == m_images.end()) {
+        return 0;
+    }
+
+    std::ifstream file(imageListIt->GetPath());
+    std::string line;
+    std::ostringstream rewrittenList;
+    std::vector<Image> chunkImages;
+    bool split = false;
+
+    while (std::getline(file, line)) {
+        std::string name = line.substr(0, line.find(','));
+
+        auto it = std::find_if(m_images.begin(), m_images.end(), [&name](const Image &img) {
+            return img.GetName() == name;
+        });
+
+        if (it == m_images.end() || std::filesystem::file_size(it->GetPath()) <= maxChunkSize) {
+            rewrittenList << line << "\n";
+            continue;
+        }
+
+        std::string path = it->GetPath();
+        uint64_t imageSize = std::filesystem::file_size(path);
+        std::string extension = std::filesystem::path(path).extension().string();
+        if (extension == ".gz" || extension == ".xz" || extension == ".bz2" || extension == ".zst" || extension == ".lz4") {
+            // A compressed stream cannot be cut at arbitrary offsets
+            log(ASTRA_LOG_LEVEL_ERROR) << "Compressed image " << name << " is larger than the maximum chunk size ("
+                << maxChunkSize << " bytes). Build it uncompressed to allow it to be split." << endLog;
+            return -1;
+        }
+
+        // The chunk offset goes in a fixed column, so the entry must have exactly the
+        // columns before it
+        std::vector<std::string> fields;
+        std::istringstream iss(line.substr(0, line.find_last_not_of(" \r,") + 1));
+        std::string field;
+        while (std::getline(iss, field, ',')) {
+            fields.push_back(field);
+        }
+        if (fields.size() > m_chunkOffsetColumn) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "Entry for " << name << " already has column " << m_chunkOffsetColumn + 1
+                << ", it cannot be split into chunks" << endLog;
+            return -1;
+        } else if (fields.size() < m_chunkOffsetColumn) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "Entry for " << name << " has no partition, it cannot be split into chunks" << endLog;
+            return -1;
+        }
+
+        // Replace the entry with one entry per chunk: chunk name, partition and the
+        // byte offset of the chunk within the partition which l2emmc writes it to.
+        uint64_t chunkCount = (imageSize + maxChunkSize - 1) / maxChunkSize;
+        log(ASTRA_LOG_LEVEL_INFO) << "Splitting " << name << " (" << imageSize << " bytes) into " << chunkCount << " chunks" << endLog;
+        for (uint64_t i = 0; i < chunkCount; ++i) {
+            uint64_t offset = i * maxChunkSize;
+            uint64_t size = std::min(maxChunkSize, imageSize - offset);
+
+            std::ostringstream chunkName;
+            chunkName << name << "." << std::setw(3) << std::setfill('0') << i;
+            chunkImages.push_back(Image(path, chunkName.str(), it->GetImageType(), offset, size));
+
+            rewrittenList << chunkName.str() << "," << fields[1] << ",0x" << std::hex << offset << std::dec << "\n";
+            if (name == m_finalImage && i == chunkCount - 1) {
+                m_finalImage = chunkName.str();
+            }
+        }
+
+        m_images.erase(it);
+        split = true;
+    }
+
+    if (split) {
+        // Reacquire the iterator, erasing the split images invalidated it
+        imageListIt = std::find_if(m_images.begin(), m_images.end(), [](const Image &img) {
+            return img.GetName() == "emmc_image_list";
+        });
+        *imageListIt = Image("emmc_image_list", std::make_shared<const std::string>(rewrittenList.str()), ASTRA_IMAGE_TYPE_UPDATE_EMMC);
+        m_images.insert(m_images.end(), chunkImages.begin(), chunkImages.end());
+        log(ASTRA_LOG_LEVEL_DEBUG) << "Final image: " << m_finalImage << endLog;
+    }
+
+    return 0;
+}
+int EmmcFlashImage::PrepareVerify()
+{
+    ASTRA_LOG;
+
+    if (m_config.find("mmc_device") != m_config.end()) {
+        m_mmcDevice = m_config["mmc_device"];
+    }
+    if (m_config.find("verify_address") != m_config.end()) {
+        m_verifyAddress = m_config["verify_address"];
+    }
+    if (m_config.find("verify_window_size") != m_config.end()) {
+        m_verifyWindowSize = std::stoull(m_config["verify_window_size"], nullptr, 0);
+        m_verifyWindowSize -= m_verifyWindowSize % m_mmcBlockSize;
+        if (m_verifyWindowSize == 0) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "Invalid verify_window_size: " << m_config["verify_window_size"] << endLog;
+            return -1;
+        }
+    }
+
+    auto imageListIt = std::find_if(m_images.begin(), m_images.end(), [](const Image &img) {
+        return img.GetName() == "emmc_image_list";
+    });
+    if (imageListIt == m_images.end()) {
+        log(ASTRA_LOG_LEVEL_ERROR) << "emmc_image_list not found" << endLog;
+        return -1;
+    }
+
+    std::ifstream file(imageListIt->GetPath());
+    std::string line;
+
+    while (std::getline(file, line)) {
+        std::istringstream iss(line);
+        std::string name;
+        std::string partition;
+        if (!std::getline(iss, name, ',') || !std::getline(iss, partition, ',')) {
+            continue;
+        }
+
+        auto it = std::find_if(m_images.begin(), m_images.end(), [&name](const Image &img) {
+            return img.GetName() == name;
+        });
+        if (it == m_images.end()) {
+            continue;
+        }
+
+        VerifyRegion region{name, partition, it->GetPath(), std::filesystem::file_size(it->GetPath()), 0, false};
+        std::string extension = std::filesystem::path(region.m_imagePath).extension().string();
+        if (extension == ".gz") {
+            // The gzip trailer holds the CRC32 and size (mod 2^32) of the uncompressed data
+            std::ifstream gzFile(region.m_imagePath, std::ios::binary);
+            uint8_t trailer[8];
+            if (region.m_size < 18 || !gzFile.seekg(-8, std::ios::end) || !gzFile.read(reinterpret_cast<char *>(trailer), sizeof(trailer))) {
+                log(ASTRA_LOG_LEVEL_ERROR) << "Failed to read gzip trailer: " << name << endLog;
+                return -1;
+            }
+            region.m_crc = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) | (static_cast<uint32_t>(trailer[3]) << 24);
+            region.m_size = trailer[4] | (trailer[5] << 8) | (trailer[6] << 16) | (static_cast<uint32_t>(trailer[7]) << 24);
+            region.m_compressed = true;
+        } else if (extension == ".xz" || extension == ".bz2" || extension == ".zst" || extension == ".lz4") {
+            log(ASTRA_LOG_LEVEL_WARNING) << "Unable to verify compressed image: " << name << endLog;
+            continue;
+        }
+
+        m_verifyRegions.push_back(region);
+    }
+
+    m_hostCrcResult = std::async(std::launch::async, &EmmcFlashImage::ComputeHostCrcs, this).share();
+
+    return 0;
+}
+
+int EmmcFlashImage::ComputeHostCrcs()
+{
+    ASTRA_LOG;
+
+    std::vector<uint8_t> buffer(4 * 1024 * 1024);
+
+    for (auto &region : m_verifyRegions) {
+        if (region.m_compressed) {
+            continue;
+        }
+
+        FILE *fp = fopen(region.m_imagePath.c_str(), "rb");
+        if (fp == nullptr) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "Failed to open file: " << region.m_imagePath << endLog;
+            return -1;
+        }
+
+        uint32_t crc = 0;
+        size_t bytesRead;
+        while ((bytesRead = fread(buffer.data(), 1, buffer.size(), fp)) > 0) {
+            crc = Crc32(crc, buffer.data(), bytesRead);
+        }
+        fclose(fp);
+
+        region.m_crc = crc;
+        log(ASTRA_LOG_LEVEL_DEBUG) << "Host CRC " << region.m_imageName << ": " << std::hex << crc << std::dec << endLog;
+    }
+
+    return 0;
+}
+
+int EmmcFlashImage::Verify(std::function<int(const std::string &command, std::string &output)> runCommand,
+    std::vector<std::string> &mismatches)
+{
+    ASTRA_LOG;
+
+    if (!m_hostCrcResult.valid() || m_hostCrcResult.get() < 0) {
+        log(ASTRA_LOG_LEVEL_ERROR) << "Host CRCs are not available" << endLog;
+        return -1;
+    }
+
+    uint64_t verifyAddress = std::stoull(m_verifyAddress, nullptr, 0);
+
+    for (const auto &region : m_verifyRegions) {
+        std::string output;
+        uint64_t startBlock = 0;
+        int ret;
+
+        // boot1 and boot2 are hardware partitions, everything else is looked up in the partition table
+        if (region.m_partition == "boot1" || region.m_partition == "boot2") {
+            ret = runCommand("mmc dev " + m_mmcDevice + " " + region.m_partition.substr(4), output);
+        } else {
+            ret = runCommand("mmc dev " + m_mmcDevice + " 0; part start mmc " + m_mmcDevice + " "
+                + region.m_partition + " astra_start; printenv astra_start", output);
+            if (ret == 0) {
+                size_t pos = output.find("astra_start=");
+                if (pos == std::string::npos) {
+                    log(ASTRA_LOG_LEVEL_ERROR) << "Partition not found: " << region.m_partition << endLog;
+                    mismatches.push_back(region.m_partition);
+                    continue;
+                }
+                startBlock = std::strtoull(output.c_str() + pos + 12, nullptr, 16);
+            }
+        }
+        if (ret < 0) {
+            return ret;
+        }
+
+        // The device reads the partition in windows which fit in RAM and the host
+        // combines the window CRCs into the CRC of the whole image.
+        uint32_t crc = 0;
+        for (uint64_t offset = 0; offset < region.m_size; offset += m_verifyWindowSize) {
+            uint64_t length = std::min(m_verifyWindowSize, region.m_size - offset);
+            uint64_t blocks = (length + m_mmcBlockSize - 1) / m_mmcBlockSize;
+
+            std::ostringstream command;
+            command << std::hex << "mmc read 0x" << verifyAddress << " 0x" << startBlock + offset / m_mmcBlockSize
+                << " 0x" << blocks << "; crc32 0x" << verifyAddress << " 0x" << length;
+            ret = runCommand(command.str(), output);
+            if (ret < 0) {
+                return ret;
+            }
+
+            size_t pos = output.find("==> ");
+            if (output.find("read: OK") == std::string::npos || pos == std::string::npos) {
+                log(ASTRA_LOG_LEVEL_ERROR) << "Failed to read " << region.m_partition << ": " << output << endLog;
+                return -1;
+            }
+            crc = Crc32Combine(crc, std::strtoul(output.c_str() + pos + 4, nullptr, 16), length);
+        }
+
+        if (crc != region.m_crc) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "Partition " << region.m_partition << " CRC " << std::hex << crc
+                << " expected " << region.m_crc << std::dec << endLog;
+            mismatches.push_back(region.m_partition);
+        } else {
+            log(ASTRA_LOG_LEVEL_INFO) << "Partition " << region.m_partition << " verified" << endLog;
+        }
+    }
+
+    return 0;
+}
@@ -3,6 +3,10 @@
 
 #pragma once
 
+#include <cstdint>
+#include <future>
+#include <vector>
+
 #include "flash_image.hpp"
 
 class EmmcFlashImage : public FlashImage
@@ -18,6 +22,38 @@ public:
 
     int Load() override;
 
+    int Verify(std::function<int(const std::string &command, std::string &output)> runCommand,
+        std::vector<std::string> &mismatches) override;
+
 private:
+    struct VerifyRegion {
+        std::string m_imageName;
+        std::string m_partition;
+        std::string m_imagePath;
+        uint64_t m_size;
+        uint32_t m_crc;
+        bool m_compressed;
+    };
+
+    // Keep chunks well below 2 GiB so the 32 bit size in the image header
+    // is never treated as negative by the device.
+    static constexpr uint64_t m_defaultMaxChunkSize = 0x40000000;
+    static constexpr uint64_t m_chunkAlignment = 0x100000;
+    // Column of emmc_image_list which holds a chunk's byte offset within its partition,
+    // after the image name and partition name columns
+    static constexpr size_t m_chunkOffsetColumn = 2;
+
+    std::vector<VerifyRegion> m_verifyRegions;
+    // CRCs of the uncompressed images are computed in the background while the device is flashed
+    std::shared_future<int> m_hostCrcResult;
+    std::string m_mmcDevice = "0";
+    std::string m_verifyAddress = "0x10000000";
+    uint64_t m_verifyWindowSize = 0x4000000;
+    static constexpr uint64_t m_mmcBlockSize = 512;
+
     void ParseEmmcImageList();
+    int PrepareVerify();
+    int ComputeHostCrcs();
+    int SplitLargeImages();
+    int ParseFastbootPartitions();
 };
\ No newline at end of file
@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+
+#include "fastboot_client.hpp"
+#include "astra_log.hpp"
+
+int FastbootClient::ReadResponse(std::string &response, unsigned int timeout)
+{
+    ASTRA_LOG;
+
+    uint8_t buffer[m_maxResponseSize];
+
+    for (;;) {
+        int transferred = 0;
+        int ret = m_device->Read(buffer, sizeof(buffer), &transferred, timeout);
+        if (ret < 0) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "Failed to read fastboot response" << endLog;
+            return ret;
+        }
+
+        if (transferred < 4) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "Short fastboot response: " << transferred << endLog;
+            return -1;
+        }
+
+        std::string status(reinterpret_cast<char *>(buffer), 4);
+        std::string payload(reinterpret_cast<char *>(buffer) + 4, transferred - 4);
+
+        if (status == "INFO" || status == "TEXT") {
+            log(ASTRA_LOG_LEVEL_INFO) << "fastboot: " << payload << endLog;
+            continue;
+        } else if (status == "OKAY" || status == "DATA") {
+            response = payload;
+            return 0;
+        } else if (status == "FAIL") {
+            log(ASTRA_LOG_LEVEL_ERROR) << "fastboot command failed: " << payload << endLog;
+            response = payload;
+            return -1;
+        }
+
+        log(ASTRA_LOG_LEVEL_ERROR) << "Unknown fastboot response: " << status << endLog;
+        return -1;
+    }
+}
+
+int FastbootClient::SendCommand(const std::string &command, std::string &response, unsigned int timeout)
+{
+    ASTRA_LOG;
+
+    log(ASTRA_LOG_LEVEL_DEBUG) << "fastboot command: " << command << endLog;
+
+    std::vector<uint8_t> data(command.begin(), command.end());
+    int transferred = 0;
+    int ret = m_device->Write(data.data(), data.size(), &transferred);
+    if (ret < 0 || transferred != static_cast<int>(data.size())) {
+        log(ASTRA_LOG_LEVEL_ERROR) << "Failed to send fastboot command: " << command << endLog;
+        return -1;
+    }
+
+    return ReadResponse(response, timeout);
+}
+
+int FastbootClient::GetVar(const std::string &name, std::string &value)
+{
+    ASTRA_LOG;
+
+    return SendCommand("getvar:" + name, value);
+}
+
+int FastbootClient::Download(SparseImage &image, std::function<void(uint64_t)> progressCallback)
+{
+    ASTRA_LOG;
+
+    int ret = image.Open();
+    if (ret < 0) {
+        return ret;
+    }
+
+    std::ostringstream command;
+    command << "download:" << std::hex << std::setw(8) << std::setfill('0') << image.GetSize();
+
+    std::string response;
+    ret = SendCommand(command.str(), response);
+    if (ret < 0) {
+        return ret;
+    }
+
+    if (std::strtoull(response.c_str(), nullptr, 16) != image.GetSize()) {
+        log(ASTRA_LOG_LEVEL_ERROR) << "Device accepted " << response << " bytes, expected " << image.GetSize() << endLog;
+        return -1;
+    }
+
+    if (m_transferBuffer.empty()) {
+        m_transferBuffer.resize(m_transferSize);
+    }
+
+    uint64_t totalTransferred = 0;
+    while (totalTransferred < image.GetSize()) {
+        int dataBlockSize = image.GetDataBlock(m_transferBuffer.data(), m_transferBuffer.size());
+        if (dataBlockSize <= 0) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "Failed to get sparse data block" << endLog;
+            return -1;
+        }
+
+        int transferred = 0;
+        ret = m_device->Write(m_transferBuffer.data(), dataBlockSize, &transferred);
+        if (ret < 0 || transferred != dataBlockSize) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "Failed to write sparse data" << endLog;
+            return -1;
+        }
+
+        totalTransferred += transferred;
+        if (progressCallback) {
+            progressCallback(totalTransferred);
+        }
+    }
+
+    return ReadResponse(response, m_commandTimeout);
+}
+
+int FastbootClient::Flash(const std::string &partition)
+{
+    ASTRA_LOG;
+
+    std::string response;
+    return SendCommand("flash:" + partition, response, m_flashTimeout);
+}
+
+int FastbootClient::Reboot()
+{
+    ASTRA_LOG;
+
+    std::string response;
+    return SendCommand("reboot", response);
+}
@@ -0,0 +1,41 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "device.hpp"
+#include "sparse_image.hpp"
+
+// Host side of the fastboot protocol. Talks to any Device, so a software
+// fastboot implementation can stand in for the USB gadget.
+class FastbootClient
+{
+public:
+    FastbootClient(Device *device) : m_device{device}
+    {}
+    ~FastbootClient()
+    {}
+
+    int GetVar(const std::string &name, std::string &value);
+    int Download(SparseImage &image, std::function<void(uint64_t)> progressCallback);
+    int Flash(const std::string &partition);
+    int Reboot();
+
+private:
+    Device *m_device;
+    std::vector<uint8_t> m_transferBuffer;
+
+    static constexpr size_t m_transferSize = 8 * 1024 * 1024;
+    static constexpr size_t m_maxResponseSize = 64;
+    static constexpr unsigned int m_commandTimeout = 5000;
+    // Flashing a large sparse image can take a while before the device responds
+    static constexpr unsigned int m_flashTimeout = 120000;
+
+    int SendCommand(const std::string &command, std::string &response, unsigned int timeout = m_commandTimeout);
+    int ReadResponse(std::string &response, unsigned int timeout);
+};
@@ -9,6 +9,7 @@
 
 #include "emmc_flash_image.hpp"
 #include "spi_flash_image.hpp"
+#include "nand_flash_image.hpp"
 
 const std::string FlashImageTypeToString(FlashImageType type)
 {
@@ -128,7 +129,7 @@ std::shared_ptr<FlashImage> FlashImage::FlashImageFactory(std::string imagePath,
         case FLASH_IMAGE_TYPE_SPI:
             return std::make_unique<SpiFlashImage>(imagePath, bootImage, chipName, boardName, secureBootVersion, memoryLayout, config);
         case FLASH_IMAGE_TYPE_NAND:
-            throw std::invalid_argument("NAND FlashImage not supported");
+            return std::make_shared<NandFlashImage>(imagePath, bootImage, chipName, boardName, secureBootVersion, memoryLayout, config);
         case FLASH_IMAGE_TYPE_EMMC:
             return std::make_shared<EmmcFlashImage>(imagePath, bootImage, chipName, boardName, secureBootVersion, memoryLayout, config);
         default:
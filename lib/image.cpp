@@ -8,24 +8,45 @@
 
 #include "image.hpp"
 #include "astra_log.hpp"
+#include "utils.hpp"
 
 int Image::Load()
 {
     ASTRA_LOG;
 
+    m_position = 0;
+
+    if (m_data) {
+        log(ASTRA_LOG_LEVEL_DEBUG) << "Loading in memory image: " << m_imageName << endLog;
+        m_imageSize = m_data->size();
+        return 0;
+    }
+
     log(ASTRA_LOG_LEVEL_DEBUG) << "Loading image: " << m_imagePath << endLog;
-    m_imageName = std::filesystem::path(m_imagePath).filename().string();
+    if (!m_isWindow) {
+        m_imageName = std::filesystem::path(m_imagePath).filename().string();
+    }
 
     if (std::filesystem::exists(m_imagePath) == false) {
         log(ASTRA_LOG_LEVEL_ERROR) << "Image file does not exist: " << m_imagePath << endLog;
         return -1;
     }
 
-    uint32_t size = std::filesystem::file_size(m_imagePath);
+    uint64_t size = std::filesystem::file_size(m_imagePath);
     log(ASTRA_LOG_LEVEL_DEBUG) << "Image size: " << size << endLog;
 
+    if (m_isWindow) {
+        if (m_windowOffset + m_windowSize > size) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "Image window " << m_imageName << " exceeds file size: offset " << m_windowOffset
+                << " size " << m_windowSize << " file size " << size << endLog;
+            return -1;
+        }
+        size = m_windowSize;
+    }
+
     if (m_fp) {
         fclose(m_fp);
+        m_fp = nullptr;
     }
 
     FILE *fp = fopen(m_imagePath.c_str(), "rb");
@@ -35,6 +56,12 @@ int Image::Load()
         return -1;
     }
 
+    if (m_isWindow && SeekFile(fp, m_windowOffset) < 0) {
+        log(ASTRA_LOG_LEVEL_ERROR) << "Failed to seek to offset " << m_windowOffset << " in " << m_imagePath << endLog;
+        fclose(fp);
+        return -1;
+    }
+
     m_imageSize = size;
     m_fp = fp;
 
@@ -45,22 +72,24 @@ int Image::GetDataBlock(uint8_t *data, size_t size)
 {
     ASTRA_LOG;
 
-    int readSize = size;
-    if (m_imageSize < size) {
-        readSize = m_imageSize;
+    uint64_t remaining = m_imageSize - m_position;
+    size_t readSize = size;
+    if (remaining < size) {
+        readSize = static_cast<size_t>(remaining);
     }
 
-    long currentPos = ftell(m_fp);
-    if (currentPos + static_cast<long>(readSize) > m_imageSize) {
-        readSize = m_imageSize - currentPos;
+    if (m_data) {
+        std::memcpy(data, m_data->data() + m_position, readSize);
+    } else {
+        size_t bytesRead = fread(data, 1, readSize, m_fp);
+        if (bytesRead != readSize) {
+            return -1;
+        }
     }
 
-    size_t bytesRead = fread(data, 1, readSize, m_fp);
-    if (bytesRead != readSize) {
-        return -1;
-    }
+    m_position += readSize;
 
-    return readSize;
+    return static_cast<int>(readSize);
 }
 
 Image::~Image()
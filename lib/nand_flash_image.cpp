@@ -0,0 +1,203 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+#include "nand_flash_image.hpp"
+#include "block_scan.hpp"
+#include "astra_log.hpp"
+
+int NandFlashImage::Load()
+{
+    ASTRA_LOG;
+
+    if (m_config.find("read_address") != m_config.end()) {
+        m_readAddress = m_config["read_address"];
+    }
+    if (m_config.find("nand_offset") != m_config.end()) {
+        m_nandOffset = std::stoull(m_config["nand_offset"], nullptr, 0);
+    }
+    if (m_config.find("erase_block_size") != m_config.end()) {
+        m_eraseBlockSize = std::stoull(m_config["erase_block_size"], nullptr, 0);
+    }
+    if (m_config.find("page_size") != m_config.end()) {
+        m_pageSize = std::stoull(m_config["page_size"], nullptr, 0);
+    }
+    if (m_config.find("max_run_size") != m_config.end()) {
+        m_maxRunSize = std::stoull(m_config["max_run_size"], nullptr, 0);
+    }
+
+    if (m_eraseBlockSize == 0 || m_pageSize == 0 || m_eraseBlockSize % m_pageSize != 0 || m_eraseBlockSize % 4 != 0) {
+        log(ASTRA_LOG_LEVEL_ERROR) << "Invalid NAND geometry: erase block size: " << m_eraseBlockSize
+            << " page size: " << m_pageSize << endLog;
+        return -1;
+    }
+
+    // Runs are sent as single images with a 32 bit size and must start on an erase block
+    m_maxRunSize = std::min<uint64_t>(m_maxRunSize, UINT32_MAX);
+    m_maxRunSize -= m_maxRunSize % m_eraseBlockSize;
+    if (m_maxRunSize == 0) {
+        log(ASTRA_LOG_LEVEL_ERROR) << "Invalid max_run_size: " << m_config["max_run_size"] << endLog;
+        return -1;
+    }
+
+    std::string imagePath = m_imagePath;
+    if (m_config.find("image_file") != m_config.end()) {
+        imagePath = m_imagePath + "/" + m_config["image_file"];
+    }
+    if (!std::filesystem::exists(imagePath) || std::filesystem::is_directory(imagePath)) {
+        log(ASTRA_LOG_LEVEL_ERROR) << "NAND image not found: " << imagePath << endLog;
+        return -1;
+    }
+
+    uint64_t imageSize = std::filesystem::file_size(imagePath);
+    if (imageSize == 0 || imageSize % m_pageSize != 0) {
+        log(ASTRA_LOG_LEVEL_ERROR) << "NAND image size must be a multiple of the page size: " << imageSize << endLog;
+        return -1;
+    }
+
+    std::vector<DataRun> runs;
+    int ret = ScanImage(imagePath, imageSize, runs);
+    if (ret < 0) {
+        return ret;
+    }
+
+    if (runs.empty()) {
+        // Always send something so the update has an image to complete on
+        runs.push_back({0, std::min(imageSize, m_eraseBlockSize)});
+    }
+
+    MergeRuns(runs);
+
+    std::string imageFile = std::filesystem::path(imagePath).filename().string();
+    uint64_t eraseSize = (imageSize + m_eraseBlockSize - 1) / m_eraseBlockSize * m_eraseBlockSize;
+    uint64_t sendSize = 0;
+
+    std::ostringstream command;
+    command << std::hex << "nand erase 0x" << m_nandOffset << " 0x" << eraseSize;
+
+    for (const auto &run : runs) {
+        // Split runs which do not fit in the load buffer
+        for (uint64_t offset = run.m_offset; offset < run.m_offset + run.m_size; offset += m_maxRunSize) {
+            uint64_t size = std::min(m_maxRunSize, run.m_offset + run.m_size - offset);
+
+            std::ostringstream name;
+            name << imageFile << "." << std::hex << std::setw(8) << std::setfill('0') << offset;
+            m_images.push_back(Image(imagePath, name.str(), ASTRA_IMAGE_TYPE_UPDATE_NAND, offset, size));
+            m_finalImage = name.str();
+
+            command << "; usbload " << name.str() << " " << m_readAddress << "; nand write " << m_readAddress
+                << " 0x" << m_nandOffset + offset << " 0x" << size;
+            sendSize += size;
+        }
+    }
+
+    log(ASTRA_LOG_LEVEL_INFO) << "NAND image " << imageFile << ": sending " << sendSize << " of " << imageSize
+        << " bytes in " << m_images.size() << " images" << endLog;
+
+    m_flashCommand = command.str();
+    m_resetInFlashCommand = true;
+    m_resetWhenComplete = true;
+
+    return 0;
+}
+
+int NandFlashImage::ScanImage(const std::string &imagePath, uint64_t imageSize, std::vector<DataRun> &runs)
+{
+    ASTRA_LOG;
+
+    constexpr size_t scanBlocks = 64;
+
+    FILE *fp = fopen(imagePath.c_str(), "rb");
+    if (fp == nullptr) {
+        log(ASTRA_LOG_LEVEL_ERROR) << "Failed to open file: " << imagePath << endLog;
+        return -1;
+    }
+
+    std::vector<uint8_t> buffer(m_eraseBlockSize * scanBlocks);
+    uint64_t offset = 0;
+    size_t bytesRead;
+
+    while ((bytesRead = fread(buffer.data(), 1, buffer.size(), fp)) > 0) {
+        for (size_t position = 0; position < bytesRead; position += m_eraseBlockSize) {
+            size_t length = std::min<size_t>(m_eraseBlockSize, bytesRead - position);
+            uint64_t blockOffset = offset + position;
+
+            // Erased NAND reads back as 0xFF, there is no need to write those blocks.
+            // The image size is a multiple of the page size so the length is a multiple of 4.
+            if (IsBlockFilledWith(buffer.data() + position, length, 0xFFFFFFFF)) {
+                continue;
+            }
+
+            if (!runs.empty() && runs.back().m_offset + runs.back().m_size == blockOffset) {
+                runs.back().m_size += length;
+            } else {
+                runs.push_back({blockOffset, length});
+            }
+        }
+        offset += bytesRead;
+    }
+
+    fclose(fp);
+
+    if (offset != imageSize) {
+        log(ASTRA_LOG_LEVEL_ERROR) << "Failed to read NAND image: " << imagePath << endLog;
+        return -1;
+    }
+
+    return 0;
+}
+
+uint64_t NandFlashImage::GetRunImageCount(const DataRun &run) const
+{
+    return (run.m_size + m_maxRunSize - 1) / m_maxRunSize;
+}
+
+void NandFlashImage::MergeRuns(std::vector<DataRun> &runs)
+{
+    ASTRA_LOG;
+
+    // Runs larger than m_maxRunSize are split into several images when the
+    // command is built, so the limit applies to the images rather than the runs
+    uint64_t imageCount = 0;
+    for (const auto &run : runs) {
+        imageCount += GetRunImageCount(run);
+    }
+
+    // Sending a few erased blocks is cheaper than an extra round trip, so join
+    // the runs separated by the smallest gaps until the command is short enough.
+    // Only joins which leave fewer images count, joining across a gap larger than
+    // m_maxRunSize only sends more erased blocks.
+    while (imageCount > m_maxRuns) {
+        size_t smallest = runs.size();
+        uint64_t smallestGap = UINT64_MAX;
+        for (size_t i = 0; i + 1 < runs.size(); ++i) {
+            DataRun merged = {runs[i].m_offset, runs[i + 1].m_offset + runs[i + 1].m_size - runs[i].m_offset};
+            if (GetRunImageCount(merged) >= GetRunImageCount(runs[i]) + GetRunImageCount(runs[i + 1])) {
+                continue;
+            }
+
+            uint64_t gap = runs[i + 1].m_offset - (runs[i].m_offset + runs[i].m_size);
+            if (gap < smallestGap) {
+                smallestGap = gap;
+                smallest = i;
+            }
+        }
+
+        if (smallest == runs.size()) {
+            log(ASTRA_LOG_LEVEL_WARNING) << "NAND image needs " << imageCount << " images of at most " << m_maxRunSize
+                << " bytes, more than " << m_maxRuns << endLog;
+            return;
+        }
+
+        imageCount -= GetRunImageCount(runs[smallest]) + GetRunImageCount(runs[smallest + 1]);
+        runs[smallest].m_size = runs[smallest + 1].m_offset + runs[smallest + 1].m_size - runs[smallest].m_offset;
+        runs.erase(runs.begin() + smallest + 1);
+        imageCount += GetRunImageCount(runs[smallest]);
+    }
+}
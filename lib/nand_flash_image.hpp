@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "flash_image.hpp"
+
+class NandFlashImage : public FlashImage
+{
+public:
+    NandFlashImage(std::string imagePath, std::string bootImage, std::string chipName,
+            std::string boardName, AstraSecureBootVersion secureBootVersion, AstraMemoryLayout memoryLayout,
+            std::map<std::string, std::string> config) : FlashImage(FLASH_IMAGE_TYPE_NAND, imagePath,
+            bootImage, chipName, boardName, secureBootVersion, memoryLayout, config)
+    {}
+    virtual ~NandFlashImage()
+    {}
+
+    int Load() override;
+
+private:
+    struct DataRun {
+        uint64_t m_offset;
+        uint64_t m_size;
+    };
+
+    std::string m_readAddress = "0x10000000";
+    uint64_t m_nandOffset = 0;
+    uint64_t m_eraseBlockSize = 0x20000;
+    uint64_t m_pageSize = 0x800;
+    // Runs are loaded into RAM at m_readAddress before being written
+    uint64_t m_maxRunSize = 0x4000000;
+    // Each run adds a usbload and nand write to the command, which U-Boot limits in length
+    size_t m_maxRuns = 16;
+
+    int ScanImage(const std::string &imagePath, uint64_t imageSize, std::vector<DataRun> &runs);
+    // Number of images a run is sent as, each at most m_maxRunSize
+    uint64_t GetRunImageCount(const DataRun &run) const;
+    void MergeRuns(std::vector<DataRun> &runs);
+};
@@ -0,0 +1,300 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+#include "sparse_image.hpp"
+#include "block_scan.hpp"
+#include "astra_log.hpp"
+#include "utils.hpp"
+
+static void PutLE16(uint8_t *buf, uint16_t val)
+{
+    buf[0] = val & 0xFF;
+    buf[1] = (val >> 8) & 0xFF;
+}
+
+static void PutLE32(uint8_t *buf, uint32_t val)
+{
+    buf[0] = val & 0xFF;
+    buf[1] = (val >> 8) & 0xFF;
+    buf[2] = (val >> 16) & 0xFF;
+    buf[3] = (val >> 24) & 0xFF;
+}
+
+SparseImage::SparseImage(std::string imagePath, uint32_t blockSize, uint32_t totalBlocks, std::vector<SparseChunk> chunks)
+    : m_imagePath{imagePath}, m_blockSize{blockSize}, m_totalBlocks{totalBlocks}, m_chunks{std::move(chunks)}
+{
+    m_size = m_fileHeaderSize;
+    for (const auto &chunk : m_chunks) {
+        m_size += ChunkSize(chunk);
+        if (chunk.m_type == SPARSE_CHUNK_TYPE_RAW) {
+            m_rawDataSize += static_cast<uint64_t>(chunk.m_blocks) * m_blockSize;
+        }
+    }
+}
+
+SparseImage::~SparseImage()
+{
+    if (m_fp) {
+        fclose(m_fp);
+    }
+}
+
+uint64_t SparseImage::ChunkSize(const SparseChunk &chunk) const
+{
+    switch (chunk.m_type) {
+        case SPARSE_CHUNK_TYPE_RAW:
+            return m_chunkHeaderSize + static_cast<uint64_t>(chunk.m_blocks) * m_blockSize;
+        case SPARSE_CHUNK_TYPE_FILL:
+            return m_chunkHeaderSize + sizeof(uint32_t);
+        default:
+            return m_chunkHeaderSize;
+    }
+}
+
+int SparseImage::Open()
+{
+    ASTRA_LOG;
+
+    if (m_fp) {
+        fclose(m_fp);
+    }
+
+    m_fp = fopen(m_imagePath.c_str(), "rb");
+    if (m_fp == nullptr) {
+        log(ASTRA_LOG_LEVEL_ERROR) << "Failed to open file: " << m_imagePath << endLog;
+        return -1;
+    }
+    m_fileSize = std::filesystem::file_size(m_imagePath);
+
+    m_chunkIndex = 0;
+    m_payloadRemaining = 0;
+    FillFileHeader();
+
+    return 0;
+}
+
+void SparseImage::FillFileHeader()
+{
+    PutLE32(m_header, m_sparseMagic);
+    PutLE16(m_header + 4, 1);   // major version
+    PutLE16(m_header + 6, 0);   // minor version
+    PutLE16(m_header + 8, m_fileHeaderSize);
+    PutLE16(m_header + 10, m_chunkHeaderSize);
+    PutLE32(m_header + 12, m_blockSize);
+    PutLE32(m_header + 16, m_totalBlocks);
+    PutLE32(m_header + 20, static_cast<uint32_t>(m_chunks.size()));
+    PutLE32(m_header + 24, 0);  // checksum is optional
+    m_headerSize = m_fileHeaderSize;
+    m_headerPosition = 0;
+}
+
+void SparseImage::FillChunkHeader(const SparseChunk &chunk)
+{
+    PutLE16(m_header, chunk.m_type);
+    PutLE16(m_header + 2, 0);
+    PutLE32(m_header + 4, chunk.m_blocks);
+    PutLE32(m_header + 8, static_cast<uint32_t>(ChunkSize(chunk)));
+    m_headerSize = m_chunkHeaderSize;
+    m_headerPosition = 0;
+
+    if (chunk.m_type == SPARSE_CHUNK_TYPE_FILL) {
+        // The fill value is the only payload, send it with the header
+        PutLE32(m_header + m_chunkHeaderSize, chunk.m_fillValue);
+        m_headerSize += sizeof(uint32_t);
+    } else if (chunk.m_type == SPARSE_CHUNK_TYPE_RAW) {
+        m_payloadRemaining = static_cast<uint64_t>(chunk.m_blocks) * m_blockSize;
+        m_payloadOffset = chunk.m_fileOffset;
+    }
+}
+
+int SparseImage::ReadPayload(uint8_t *data, size_t size)
+{
+    size_t fromFile = 0;
+    if (m_payloadOffset < m_fileSize) {
+        fromFile = static_cast<size_t>(std::min<uint64_t>(size, m_fileSize - m_payloadOffset));
+        if (fread(data, 1, fromFile, m_fp) != fromFile) {
+            return -1;
+        }
+    }
+
+    // The last block of an image which is not block aligned is padded with zeros
+    std::memset(data + fromFile, 0, size - fromFile);
+
+    m_payloadOffset += size;
+    m_payloadRemaining -= size;
+
+    return static_cast<int>(size);
+}
+
+int SparseImage::GetDataBlock(uint8_t *data, size_t size)
+{
+    ASTRA_LOG;
+
+    size_t written = 0;
+
+    while (written < size) {
+        if (m_headerPosition < m_headerSize) {
+            size_t count = std::min(size - written, m_headerSize - m_headerPosition);
+            std::memcpy(data + written, m_header + m_headerPosition, count);
+            m_headerPosition += count;
+            written += count;
+        } else if (m_payloadRemaining > 0) {
+            size_t count = static_cast<size_t>(std::min<uint64_t>(size - written, m_payloadRemaining));
+            if (ReadPayload(data + written, count) < 0) {
+                log(ASTRA_LOG_LEVEL_ERROR) << "Failed to read " << m_imagePath << endLog;
+                return -1;
+            }
+            written += count;
+        } else if (m_chunkIndex < m_chunks.size()) {
+            const SparseChunk &chunk = m_chunks[m_chunkIndex++];
+            if (chunk.m_type == SPARSE_CHUNK_TYPE_RAW && SeekFile(m_fp, chunk.m_fileOffset) < 0) {
+                log(ASTRA_LOG_LEVEL_ERROR) << "Failed to seek in " << m_imagePath << endLog;
+                return -1;
+            }
+            FillChunkHeader(chunk);
+        } else {
+            break;
+        }
+    }
+
+    return static_cast<int>(written);
+}
+
+int SparseImage::ScanImage(const std::string &imagePath, uint32_t blockSize, uint32_t &totalBlocks,
+    std::vector<SparseChunk> &chunks)
+{
+    ASTRA_LOG;
+
+    constexpr size_t scanBlocks = 2048;
+    // Keep the total size of a RAW chunk within its 32 bit size field
+    const uint32_t maxChunkBlocks = (UINT32_MAX - m_chunkHeaderSize) / blockSize;
+
+    uint64_t fileSize = std::filesystem::file_size(imagePath);
+    uint64_t blocks = (fileSize + blockSize - 1) / blockSize;
+    if (blocks > UINT32_MAX) {
+        log(ASTRA_LOG_LEVEL_ERROR) << "Image too large for a sparse image: " << imagePath << endLog;
+        return -1;
+    }
+    totalBlocks = static_cast<uint32_t>(blocks);
+
+    FILE *fp = fopen(imagePath.c_str(), "rb");
+    if (fp == nullptr) {
+        log(ASTRA_LOG_LEVEL_ERROR) << "Failed to open file: " << imagePath << endLog;
+        return -1;
+    }
+
+    std::vector<uint8_t> buffer(static_cast<size_t>(blockSize) * scanBlocks);
+    uint64_t block = 0;
+    size_t bytesRead;
+
+    while ((bytesRead = fread(buffer.data(), 1, buffer.size(), fp)) > 0) {
+        for (size_t offset = 0; offset < bytesRead; offset += blockSize, ++block) {
+            size_t length = std::min<size_t>(blockSize, bytesRead - offset);
+            uint32_t fillValue = 0;
+            SparseChunkType type = SPARSE_CHUNK_TYPE_RAW;
+            if (length == blockSize && IsBlockFilled(buffer.data() + offset, length, &fillValue)) {
+                type = SPARSE_CHUNK_TYPE_FILL;
+            }
+
+            if (!chunks.empty()) {
+                SparseChunk &last = chunks.back();
+                if (last.m_type == type && last.m_blocks < maxChunkBlocks
+                    && (type == SPARSE_CHUNK_TYPE_RAW || last.m_fillValue == fillValue))
+                {
+                    ++last.m_blocks;
+                    continue;
+                }
+            }
+
+            chunks.push_back(SparseChunk{type, block, 1, block * blockSize, fillValue});
+        }
+    }
+
+    fclose(fp);
+
+    return 0;
+}
+
+int SparseImage::Create(const std::string &imagePath, uint32_t blockSize, uint64_t maxSize,
+    std::vector<std::unique_ptr<SparseImage>> &sparseImages)
+{
+    ASTRA_LOG;
+
+    uint32_t totalBlocks;
+    std::vector<SparseChunk> chunks;
+
+    int ret = ScanImage(imagePath, blockSize, totalBlocks, chunks);
+    if (ret < 0) {
+        return ret;
+    }
+
+    // The download command sends the size as 32 bits
+    maxSize = std::min<uint64_t>(maxSize, UINT32_MAX);
+
+    // Each image has a file header and may need a leading and a trailing DONT_CARE chunk
+    const uint64_t overhead = m_fileHeaderSize + 2 * m_chunkHeaderSize;
+    if (maxSize < overhead + m_chunkHeaderSize + blockSize) {
+        log(ASTRA_LOG_LEVEL_ERROR) << "Maximum sparse image size too small: " << maxSize << endLog;
+        return -1;
+    }
+
+    std::vector<SparseChunk> current;
+    uint64_t currentSize = overhead;
+
+    auto flush = [&]() {
+        std::vector<SparseChunk> imageChunks;
+        uint64_t firstBlock = current.front().m_startBlock;
+        uint64_t endBlock = current.back().m_startBlock + current.back().m_blocks;
+        if (firstBlock > 0) {
+            imageChunks.push_back(SparseChunk{SPARSE_CHUNK_TYPE_DONT_CARE, 0, static_cast<uint32_t>(firstBlock), 0, 0});
+        }
+        imageChunks.insert(imageChunks.end(), current.begin(), current.end());
+        if (endBlock < totalBlocks) {
+            imageChunks.push_back(SparseChunk{SPARSE_CHUNK_TYPE_DONT_CARE, endBlock, static_cast<uint32_t>(totalBlocks - endBlock), 0, 0});
+        }
+        sparseImages.push_back(std::make_unique<SparseImage>(imagePath, blockSize, totalBlocks, std::move(imageChunks)));
+        current.clear();
+        currentSize = overhead;
+    };
+
+    for (SparseChunk chunk : chunks) {
+        while (chunk.m_blocks > 0) {
+            uint64_t chunkSize = m_chunkHeaderSize;
+            if (chunk.m_type == SPARSE_CHUNK_TYPE_RAW) {
+                chunkSize += static_cast<uint64_t>(chunk.m_blocks) * blockSize;
+            } else if (chunk.m_type == SPARSE_CHUNK_TYPE_FILL) {
+                chunkSize += sizeof(uint32_t);
+            }
+
+            if (currentSize + chunkSize <= maxSize) {
+                current.push_back(chunk);
+                currentSize += chunkSize;
+                break;
+            }
+
+            if (chunk.m_type == SPARSE_CHUNK_TYPE_RAW && currentSize + m_chunkHeaderSize + blockSize <= maxSize) {
+                // Send as much of the RAW chunk as fits and carry the rest over to the next image
+                uint32_t fitBlocks = static_cast<uint32_t>((maxSize - currentSize - m_chunkHeaderSize) / blockSize);
+                current.push_back(SparseChunk{SPARSE_CHUNK_TYPE_RAW, chunk.m_startBlock, fitBlocks, chunk.m_fileOffset, 0});
+                chunk.m_startBlock += fitBlocks;
+                chunk.m_fileOffset += static_cast<uint64_t>(fitBlocks) * blockSize;
+                chunk.m_blocks -= fitBlocks;
+            }
+
+            flush();
+        }
+    }
+
+    if (!current.empty()) {
+        flush();
+    }
+
+    log(ASTRA_LOG_LEVEL_DEBUG) << "Created " << sparseImages.size() << " sparse images for " << imagePath
+        << " from " << chunks.size() << " chunks" << endLog;
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum SparseChunkType : uint16_t {
+    SPARSE_CHUNK_TYPE_RAW = 0xCAC1,
+    SPARSE_CHUNK_TYPE_FILL = 0xCAC2,
+    SPARSE_CHUNK_TYPE_DONT_CARE = 0xCAC3,
+};
+
+struct SparseChunk {
+    SparseChunkType m_type;
+    uint64_t m_startBlock;
+    uint32_t m_blocks;
+    uint64_t m_fileOffset;  // RAW chunks: offset of the data in the source file
+    uint32_t m_fillValue;   // FILL chunks: 32 bit value repeated over the chunk
+};
+
+// An Android sparse image which is generated on the fly from a raw image
+// file. Only the chunk list is kept in memory, RAW data is streamed from the
+// source file when the image is sent.
+class SparseImage
+{
+public:
+    SparseImage(std::string imagePath, uint32_t blockSize, uint32_t totalBlocks, std::vector<SparseChunk> chunks);
+    ~SparseImage();
+
+    SparseImage(const SparseImage &) = delete;
+    SparseImage &operator=(const SparseImage &) = delete;
+
+    int Open();
+    int GetDataBlock(uint8_t *data, size_t size);
+    uint64_t GetSize() const { return m_size; }
+    uint64_t GetRawDataSize() const { return m_rawDataSize; }
+
+    // Scan the image and create one or more sparse images which each fit in maxSize bytes.
+    // Blocks which are not covered by a sparse image are marked as DONT_CARE so each one
+    // can be flashed to the full partition independently.
+    static int Create(const std::string &imagePath, uint32_t blockSize, uint64_t maxSize,
+        std::vector<std::unique_ptr<SparseImage>> &sparseImages);
+
+private:
+    static constexpr uint16_t m_fileHeaderSize = 28;
+    static constexpr uint16_t m_chunkHeaderSize = 12;
+    static constexpr uint32_t m_sparseMagic = 0xED26FF3A;
+
+    std::string m_imagePath;
+    uint32_t m_blockSize;
+    uint32_t m_totalBlocks;
+    std::vector<SparseChunk> m_chunks;
+    uint64_t m_size;
+    uint64_t m_rawDataSize = 0;
+    uint64_t m_fileSize = 0;
+
+    FILE *m_fp = nullptr;
+    uint8_t m_header[m_fileHeaderSize];
+    size_t m_headerSize = 0;
+    size_t m_headerPosition = 0;
+    size_t m_chunkIndex = 0;
+    uint64_t m_payloadRemaining = 0;
+    uint64_t m_payloadOffset = 0;
+
+    void FillFileHeader();
+    void FillChunkHeader(const SparseChunk &chunk);
+    int ReadPayload(uint8_t *data, size_t size);
+    uint64_t ChunkSize(const SparseChunk &chunk) const;
+
+    static int ScanImage(const std::string &imagePath, uint32_t blockSize, uint32_t &totalBlocks,
+        std::vector<SparseChunk> &chunks);
+};
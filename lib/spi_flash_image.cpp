@@ -1,12 +1,24 @@
 // SPDX-License-Identifier: Apache-2.0
 // Copyright 2025 Synaptics Incorporated
 
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 #include <filesystem>
+#include <sstream>
 #include <string>
 
 #include "spi_flash_image.hpp"
+#include "crc32.hpp"
 #include "astra_log.hpp"
 
+static std::string ToHex(uint64_t value)
+{
+    std::ostringstream os;
+    os << "0x" << std::hex << value;
+    return os.str();
+}
+
 int SpiFlashImage::Load()
 {
     ASTRA_LOG;
@@ -23,6 +35,53 @@ int SpiFlashImage::Load()
     if (m_config.find("write_second_copy_address") != m_config.end()) {
         m_writeSecondCopyAddress = m_config["write_second_copy_address"];
     }
+    if (m_config.find("sector_size") != m_config.end()) {
+        m_sectorSize = std::stoull(m_config["sector_size"], nullptr, 0);
+        if (m_sectorSize == 0) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "Invalid sector_size: " << m_config["sector_size"] << endLog;
+            return -1;
+        }
+    }
+    if (m_config.find("spi_compare") != m_config.end()) {
+        m_compare = m_config["spi_compare"] == "true";
+    }
+    if (m_config.find("verify") != m_config.end()) {
+        m_verify = m_config["verify"] == "true";
+    }
+
+    std::string imageFile;
+    std::string imagePath;
+    if (m_config.find("image_file") != m_config.end()) {
+        imageFile = m_config["image_file"];
+        imagePath = m_imagePath + "/" + imageFile;
+    } else {
+        imageFile = std::filesystem::path(m_imagePath).filename().string();
+        imagePath = m_imagePath;
+    }
+
+    if (!std::filesystem::exists(imagePath)) {
+        return -1;
+    }
+    m_images.push_back(Image(imagePath, ASTRA_IMAGE_TYPE_UPDATE_SPI));
+    m_finalImage = imageFile;
+    m_imageSize = std::filesystem::file_size(imagePath);
+
+    uint64_t firstCopyAddress = std::stoull(m_writeFirstCopyAddress, nullptr, 0);
+    uint64_t secondCopyAddress = std::stoull(m_writeSecondCopyAddress, nullptr, 0);
+    if (secondCopyAddress > firstCopyAddress && m_imageSize > secondCopyAddress - firstCopyAddress) {
+        log(ASTRA_LOG_LEVEL_ERROR) << "SPI image is larger than the space between the copies: " << m_imageSize << endLog;
+        return -1;
+    }
+
+    // Only erase the sectors which the image covers
+    uint64_t eraseSize = (m_imageSize + m_sectorSize - 1) / m_sectorSize * m_sectorSize;
+    m_writeLength = ToHex(m_imageSize);
+    m_eraseFirstStartAddress = ToHex(firstCopyAddress);
+    m_eraseFirstEndAddress = ToHex(firstCopyAddress + eraseSize - 1);
+    m_eraseSecondStartAddress = ToHex(secondCopyAddress);
+    m_eraseSecondEndAddress = ToHex(secondCopyAddress + eraseSize - 1);
+
+    // Explicit values in the config still take precedence
     if (m_config.find("write_length") != m_config.end()) {
         m_writeLength = m_config["write_length"];
     }
@@ -39,32 +98,162 @@ int SpiFlashImage::Load()
         m_eraseSecondEndAddress = m_config["erase_second_end_address"];
     }
 
-    std::string imageFile;
-    if (m_config.find("image_file") != m_config.end()) {
-        imageFile = m_config["image_file"];
-        std::string fullImagePath = m_imagePath + "/" + imageFile;
-        if (std::filesystem::exists(fullImagePath)) {
-            m_images.push_back(Image(fullImagePath, ASTRA_IMAGE_TYPE_UPDATE_SPI));
-            m_finalImage = imageFile;
-        } else {
-            return -1;
-        }
-    } else {
-        imageFile = std::filesystem::path(m_imagePath).filename().string();
-        if (std::filesystem::exists(m_imagePath)) {
-            m_images.push_back(Image(m_imagePath, ASTRA_IMAGE_TYPE_UPDATE_SPI));
-            m_finalImage = imageFile;
-        } else {
-            return -1;
+    if (m_compare || m_verify) {
+        ret = ComputeSectorCrcs(imagePath);
+        if (ret < 0) {
+            return ret;
         }
     }
 
+    if (m_compare) {
+        // Load the image and leave the rest to RunConsoleUpdate. The update is
+        // only complete once the differing sectors have been written.
+        m_flashCommand = "usbload " + imageFile + " " + m_readAddress + "; spinit";
+        m_finalImage.clear();
+        m_resetWhenComplete = true;
+        return ret;
+    }
+
     // Flash primary and secondary copies of the SPI U-Boot image
     m_flashCommand = "usbload " + imageFile + " " + m_readAddress + "; spinit; erase " 
         + m_eraseFirstStartAddress + " " + m_eraseFirstEndAddress + "; cp.b " + m_readAddress + " " + m_writeFirstCopyAddress
         + " " + m_writeLength + "; erase " + m_eraseSecondStartAddress + " " + m_eraseSecondEndAddress
-        + "; cp.b " + m_readAddress + " " + m_writeSecondCopyAddress + " " + m_writeLength + ";" + m_resetCommand;
+        + "; cp.b " + m_readAddress + " " + m_writeSecondCopyAddress + " " + m_writeLength + ";";
+    m_resetInFlashCommand = !m_verify;
     m_resetWhenComplete = true;
 
     return ret;
-}
\ No newline at end of file
+}
+
+int SpiFlashImage::ComputeSectorCrcs(const std::string &imagePath)
+{
+    ASTRA_LOG;
+
+    FILE *fp = fopen(imagePath.c_str(), "rb");
+    if (fp == nullptr) {
+        log(ASTRA_LOG_LEVEL_ERROR) << "Failed to open file: " << imagePath << endLog;
+        return -1;
+    }
+
+    std::vector<uint8_t> sector(m_sectorSize);
+    size_t bytesRead;
+    while ((bytesRead = fread(sector.data(), 1, sector.size(), fp)) > 0) {
+        uint32_t crc = Crc32(0, sector.data(), bytesRead);
+        m_sectorCrcs.push_back(crc);
+        m_imageCrc = Crc32Combine(m_imageCrc, crc, bytesRead);
+    }
+
+    fclose(fp);
+
+    return 0;
+}
+
+int SpiFlashImage::ReadCrc(std::function<int(const std::string &command, std::string &output)> &runCommand,
+    uint64_t address, uint64_t length, uint32_t &crc)
+{
+    ASTRA_LOG;
+
+    std::string output;
+    int ret = runCommand("crc32 " + ToHex(address) + " " + ToHex(length), output);
+    if (ret < 0) {
+        return ret;
+    }
+
+    // U-Boot prints "crc32 for <start> ... <end> ==> <crc>"
+    size_t pos = output.find("==> ");
+    if (pos == std::string::npos) {
+        log(ASTRA_LOG_LEVEL_ERROR) << "Unexpected crc32 output: " << output << endLog;
+        return -1;
+    }
+    crc = std::strtoul(output.c_str() + pos + 4, nullptr, 16);
+
+    return 0;
+}
+
+int SpiFlashImage::UpdateCopy(uint64_t copyAddress, std::function<int(const std::string &command, std::string &output)> &runCommand,
+    bool &updated)
+{
+    ASTRA_LOG;
+
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+
+    for (size_t i = 0; i < m_sectorCrcs.size(); ++i) {
+        uint64_t offset = i * m_sectorSize;
+        uint64_t length = std::min(m_sectorSize, m_imageSize - offset);
+
+        uint32_t crc;
+        int ret = ReadCrc(runCommand, copyAddress + offset, length, crc);
+        if (ret < 0) {
+            return ret;
+        }
+
+        if (crc != m_sectorCrcs[i]) {
+            if (!ranges.empty() && ranges.back().first + ranges.back().second == offset) {
+                ranges.back().second += length;
+            } else {
+                ranges.push_back({offset, length});
+            }
+        }
+    }
+
+    for (const auto &[offset, length] : ranges) {
+        uint64_t eraseLength = (length + m_sectorSize - 1) / m_sectorSize * m_sectorSize;
+        uint64_t readAddress = std::stoull(m_readAddress, nullptr, 0);
+        log(ASTRA_LOG_LEVEL_INFO) << "Rewriting SPI " << ToHex(copyAddress + offset) << " length " << ToHex(length) << endLog;
+
+        std::string output;
+        int ret = runCommand("erase " + ToHex(copyAddress + offset) + " " + ToHex(copyAddress + offset + eraseLength - 1), output);
+        if (ret < 0) {
+            return ret;
+        }
+        ret = runCommand("cp.b " + ToHex(readAddress + offset) + " " + ToHex(copyAddress + offset) + " " + ToHex(length), output);
+        if (ret < 0) {
+            return ret;
+        }
+        updated = true;
+    }
+
+    return 0;
+}
+
+int SpiFlashImage::RunConsoleUpdate(std::function<int(const std::string &command, std::string &output)> runCommand)
+{
+    ASTRA_LOG;
+
+    bool updated = false;
+
+    for (const std::string &copyAddress : { m_writeFirstCopyAddress, m_writeSecondCopyAddress }) {
+        int ret = UpdateCopy(std::stoull(copyAddress, nullptr, 0), runCommand, updated);
+        if (ret < 0) {
+            return ret;
+        }
+    }
+
+    if (!updated) {
+        log(ASTRA_LOG_LEVEL_INFO) << "SPI contents already match the image" << endLog;
+    }
+
+    return 0;
+}
+
+int SpiFlashImage::Verify(std::function<int(const std::string &command, std::string &output)> runCommand,
+    std::vector<std::string> &mismatches)
+{
+    ASTRA_LOG;
+
+    for (const std::string &copyAddress : { m_writeFirstCopyAddress, m_writeSecondCopyAddress }) {
+        uint32_t crc;
+        int ret = ReadCrc(runCommand, std::stoull(copyAddress, nullptr, 0), m_imageSize, crc);
+        if (ret < 0) {
+            return ret;
+        }
+
+        if (crc != m_imageCrc) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "SPI copy at " << copyAddress << " CRC " << std::hex << crc
+                << " expected " << m_imageCrc << std::dec << endLog;
+            mismatches.push_back("spi@" + copyAddress);
+        }
+    }
+
+    return 0;
+}
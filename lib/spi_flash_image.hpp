@@ -3,6 +3,9 @@
 
 #pragma once
 
+#include <cstdint>
+#include <vector>
+
 #include "flash_image.hpp"
 
 class SpiFlashImage : public FlashImage
@@ -18,13 +21,31 @@ public:
 
     int Load() override;
 
+    bool GetRequiresConsole() const override { return m_compare || m_verify; }
+    int RunConsoleUpdate(std::function<int(const std::string &command, std::string &output)> runCommand) override;
+    int Verify(std::function<int(const std::string &command, std::string &output)> runCommand,
+        std::vector<std::string> &mismatches) override;
+
 private:
     std::string m_readAddress = "0x10000000";
     std::string m_writeFirstCopyAddress = "0xf0000000";
     std::string m_writeSecondCopyAddress = "0xf0200000";
-    std::string m_writeLength = "0x200000";
-    std::string m_eraseFirstStartAddress = "0xf0000000";
-    std::string m_eraseFirstEndAddress = "0xf01fffff";
-    std::string m_eraseSecondStartAddress = "0xf0200000";
-    std::string m_eraseSecondEndAddress = "0xf03fffff";
-};
\ No newline at end of file
+    std::string m_writeLength;
+    std::string m_eraseFirstStartAddress;
+    std::string m_eraseFirstEndAddress;
+    std::string m_eraseSecondStartAddress;
+    std::string m_eraseSecondEndAddress;
+    uint64_t m_sectorSize = 0x10000;
+    uint64_t m_imageSize = 0;
+
+    // Only rewrite the sectors whose CRC differs from the image
+    bool m_compare = false;
+    std::vector<uint32_t> m_sectorCrcs;
+    uint32_t m_imageCrc = 0;
+
+    int ComputeSectorCrcs(const std::string &imagePath);
+    int ReadCrc(std::function<int(const std::string &command, std::string &output)> &runCommand,
+        uint64_t address, uint64_t length, uint32_t &crc);
+    int UpdateCopy(uint64_t copyAddress, std::function<int(const std::string &command, std::string &output)> &runCommand,
+        bool &updated);
+};
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <yaml-cpp/yaml.h>
+
+#include "station_plan.hpp"
+#include "astra_log.hpp"
+
+void StationPlan::Load()
+{
+    ASTRA_LOG;
+
+    YAML::Node plan;
+    try {
+        plan = YAML::LoadFile(m_path);
+    } catch (const std::exception& e) {
+        throw std::invalid_argument("Unable to load station plan " + m_path + ": " + e.what());
+    }
+
+    std::filesystem::path planDir = std::filesystem::path(m_path).parent_path();
+
+    try {
+        for (YAML::const_iterator it = plan["jobs"].begin(); it != plan["jobs"].end(); ++it) {
+            StationJob job;
+            job.m_name = it->first.as<std::string>();
+
+            const YAML::Node &jobNode = it->second;
+            if (!jobNode["flash"]) {
+                throw std::invalid_argument("Job " + job.m_name + " has no flash image");
+            }
+
+            std::filesystem::path flashImagePath = jobNode["flash"].as<std::string>();
+            if (flashImagePath.is_relative()) {
+                flashImagePath = planDir / flashImagePath;
+            }
+            job.m_flashImagePath = flashImagePath.string();
+
+            if (jobNode["manifest"]) {
+                std::filesystem::path manifest = jobNode["manifest"].as<std::string>();
+                if (manifest.is_relative()) {
+                    manifest = planDir / manifest;
+                }
+                job.m_manifest = manifest.string();
+            }
+
+            for (YAML::const_iterator configIt = jobNode["config"].begin(); configIt != jobNode["config"].end(); ++configIt) {
+                job.m_config[configIt->first.as<std::string>()] = configIt->second.as<std::string>();
+            }
+
+            log(ASTRA_LOG_LEVEL_DEBUG) << "Station job " << job.m_name << ": " << job.m_flashImagePath << endLog;
+            m_jobs.push_back(job);
+        }
+
+        auto loadMap = [this](const YAML::Node &node, std::unordered_map<std::string, std::string> &map) {
+            for (YAML::const_iterator it = node.begin(); it != node.end(); ++it) {
+                std::string key = it->first.as<std::string>();
+                std::string jobName = it->second.as<std::string>();
+                if (std::none_of(m_jobs.begin(), m_jobs.end(), [&jobName](const StationJob &job) {
+                        return job.m_name == jobName;
+                    }))
+                {
+                    throw std::invalid_argument("Unknown job " + jobName + " for " + key);
+                }
+                map[key] = jobName;
+            }
+        };
+        loadMap(plan["ports"], m_ports);
+        loadMap(plan["serials"], m_serials);
+    } catch (const YAML::Exception& e) {
+        throw std::invalid_argument("Invalid station plan: " + std::string(e.what()));
+    }
+
+    if (m_jobs.empty()) {
+        throw std::invalid_argument("Station plan has no jobs");
+    }
+
+    log(ASTRA_LOG_LEVEL_INFO) << "Station plan: " << m_jobs.size() << " jobs, " << m_ports.size() << " ports, "
+        << m_serials.size() << " serial numbers" << endLog;
+}
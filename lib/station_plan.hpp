@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Flash job named in a station plan
+struct StationJob {
+    std::string m_name;
+    // Update image directory, relative paths are relative to the plan file
+    std::string m_flashImagePath;
+    std::string m_manifest;
+    // Same keys as manifest.yaml, they take precedence over the image's manifest
+    std::map<std::string, std::string> m_config;
+};
+
+// Station plan file which maps the USB port paths or serial numbers of the
+// boards on a station to flash jobs:
+//
+//   jobs:
+//     sl1680:
+//       flash: sl1680-emmc
+//       config:
+//         verify: true
+//   ports:
+//     1-2.1: sl1680
+//   serials:
+//     A1B2C3D4: sl1680
+class StationPlan
+{
+public:
+    StationPlan(std::string path) : m_path{path}
+    {}
+
+    // Throws std::invalid_argument if the plan cannot be parsed
+    void Load();
+
+    const std::vector<StationJob> &GetJobs() const { return m_jobs; }
+    // Port path or serial number to job name
+    const std::unordered_map<std::string, std::string> &GetPorts() const { return m_ports; }
+    const std::unordered_map<std::string, std::string> &GetSerials() const { return m_serials; }
+
+private:
+    std::string m_path;
+    std::vector<StationJob> m_jobs;
+    std::unordered_map<std::string, std::string> m_ports;
+    std::unordered_map<std::string, std::string> m_serials;
+};
@@ -0,0 +1,161 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#include <algorithm>
+#include <new>
+
+#if defined(PLATFORM_LINUX)
+#include <sys/mman.h>
+#endif
+
+#include "transfer_buffer_pool.hpp"
+#include "astra_log.hpp"
+
+TransferBufferPool &TransferBufferPool::GetInstance()
+{
+    static TransferBufferPool pool;
+    return pool;
+}
+
+TransferBufferPool::~TransferBufferPool()
+{
+    for (uint8_t *buffer : m_idle) {
+        Free(buffer);
+    }
+}
+
+void TransferBufferPool::SetLimit(size_t maxLeased)
+{
+    ASTRA_LOG;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_limit = maxLeased;
+    log(ASTRA_LOG_LEVEL_DEBUG) << "Transfer buffer limit: " << m_limit << endLog;
+}
+
+size_t TransferBufferPool::GetLimit()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_limit;
+}
+
+void TransferBufferPool::SetUseHugePages(bool useHugePages)
+{
+    ASTRA_LOG;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_allocations != 0) {
+        log(ASTRA_LOG_LEVEL_WARNING) << "Transfer buffers already allocated, huge page setting ignored" << endLog;
+        return;
+    }
+
+    m_useHugePages = useHugePages;
+    m_allocationAlignment = useHugePages ? m_hugePageSize : m_pageSize;
+}
+
+int TransferBufferPool::Acquire(Buffer &buffer, const void *owner, std::function<void(Buffer)> waiter)
+{
+    ASTRA_LOG;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_limit != 0 && m_leased >= m_limit) {
+        log(ASTRA_LOG_LEVEL_DEBUG) << "All " << m_leased << " transfer buffers are leased, queueing request" << endLog;
+        m_waiters.push_back({owner, std::move(waiter)});
+        return 1;
+    }
+
+    uint8_t *data;
+    if (!m_idle.empty()) {
+        data = m_idle.back();
+        m_idle.pop_back();
+    } else {
+        data = Allocate();
+        if (data == nullptr) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "Failed to allocate transfer buffer" << endLog;
+            return -1;
+        }
+    }
+
+    ++m_leased;
+    m_peakLeased = std::max(m_peakLeased, m_leased);
+    buffer = Wrap(data);
+
+    return 0;
+}
+
+void TransferBufferPool::CancelWaiters(const void *owner)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_waiters.erase(std::remove_if(m_waiters.begin(), m_waiters.end(), [owner](const Waiter &waiter) {
+        return waiter.m_owner == owner;
+    }), m_waiters.end());
+}
+
+TransferBufferPoolStats TransferBufferPool::GetStats()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return {m_leased, m_idle.size(), m_waiters.size(), m_peakLeased, m_allocations};
+}
+
+size_t TransferBufferPool::GetAllocationSize() const
+{
+    return (m_bufferSize + m_allocationAlignment - 1) & ~(m_allocationAlignment - 1);
+}
+
+uint8_t *TransferBufferPool::Allocate()
+{
+    ASTRA_LOG;
+
+    size_t size = GetAllocationSize();
+    uint8_t *buffer = static_cast<uint8_t *>(::operator new(size, std::align_val_t(m_allocationAlignment), std::nothrow));
+    if (buffer == nullptr) {
+        return nullptr;
+    }
+
+#if defined(PLATFORM_LINUX) && defined(MADV_HUGEPAGE)
+    if (m_useHugePages && madvise(buffer, size, MADV_HUGEPAGE) < 0) {
+        log(ASTRA_LOG_LEVEL_DEBUG) << "Huge pages not available for transfer buffer" << endLog;
+    }
+#endif
+
+    ++m_allocations;
+    log(ASTRA_LOG_LEVEL_DEBUG) << "Allocated transfer buffer " << m_allocations << " size: " << size << endLog;
+
+    return buffer;
+}
+
+void TransferBufferPool::Free(uint8_t *buffer)
+{
+    ::operator delete(buffer, std::align_val_t(m_allocationAlignment));
+}
+
+TransferBufferPool::Buffer TransferBufferPool::Wrap(uint8_t *buffer)
+{
+    return Buffer(buffer, [this](uint8_t *data) {
+        Return(data);
+    });
+}
+
+void TransferBufferPool::Return(uint8_t *buffer)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    // Hand the buffer straight to the next waiter, it stays leased. The callback runs
+    // without the lock as dropping the buffer, for example when the waiter's strand
+    // is already closed, calls Return again.
+    if (!m_waiters.empty() && (m_limit == 0 || m_leased <= m_limit)) {
+        Waiter waiter = std::move(m_waiters.front());
+        m_waiters.pop_front();
+        lock.unlock();
+        waiter.m_callback(Wrap(buffer));
+        return;
+    }
+
+    --m_leased;
+    if (m_idle.size() < m_maxIdle) {
+        m_idle.push_back(buffer);
+    } else {
+        Free(buffer);
+    }
+}
@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct TransferBufferPoolStats {
+    size_t m_leased;
+    size_t m_idle;
+    size_t m_waiters;
+    size_t m_peakLeased;
+    uint64_t m_allocations;
+};
+
+// Process wide pool of page aligned image transfer buffers. Sessions lease a
+// buffer only while an image is being sent, so memory follows the number of
+// active transfers rather than the number of devices which have been seen.
+// The number of leased buffers can be capped, sessions then queue for a buffer
+// when the cap is reached.
+class TransferBufferPool
+{
+public:
+    // One bulk block plus room for the image header
+    static constexpr size_t m_bufferSize = (1 * 1024 * 1024) + 4;
+
+    // Returned to the pool when the last copy is released
+    using Buffer = std::shared_ptr<uint8_t>;
+
+    static TransferBufferPool &GetInstance();
+
+    ~TransferBufferPool();
+
+    // 0, the default, removes the cap
+    void SetLimit(size_t maxLeased);
+    size_t GetLimit();
+    // Back the buffers with transparent huge pages where the platform supports
+    // it. Ignored once the first buffer has been allocated.
+    void SetUseHugePages(bool useHugePages);
+
+    // Returns 0 and sets buffer if one is available now. Otherwise returns 1 and
+    // calls waiter with a buffer when one is returned. The waiter is called
+    // without the pool locked from the thread returning the buffer, and may
+    // still be called after CancelWaiters() if it was already dequeued, so it
+    // must not use state its owner frees on close. Returns < 0 if a buffer
+    // could not be allocated.
+    int Acquire(Buffer &buffer, const void *owner, std::function<void(Buffer)> waiter);
+    // Drop the queued waiters of owner, for example when its session closes
+    void CancelWaiters(const void *owner);
+
+    TransferBufferPoolStats GetStats();
+
+private:
+    TransferBufferPool() = default;
+
+    struct Waiter {
+        const void *m_owner;
+        std::function<void(Buffer)> m_callback;
+    };
+
+    std::mutex m_mutex;
+    std::vector<uint8_t *> m_idle;
+    std::deque<Waiter> m_waiters;
+    size_t m_limit = 0;
+    size_t m_leased = 0;
+    size_t m_peakLeased = 0;
+    uint64_t m_allocations = 0;
+    bool m_useHugePages = false;
+    size_t m_allocationAlignment = m_pageSize;
+
+    static constexpr size_t m_pageSize = 4096;
+    static constexpr size_t m_hugePageSize = 2 * 1024 * 1024;
+    // Idle buffers kept for reuse, the rest are freed when returned
+    static constexpr size_t m_maxIdle = 2;
+
+    size_t GetAllocationSize() const;
+    uint8_t *Allocate();
+    void Free(uint8_t *buffer);
+    Buffer Wrap(uint8_t *buffer);
+    void Return(uint8_t *buffer);
+};
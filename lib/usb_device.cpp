@@ -5,6 +5,8 @@
 #include <cstddef>
 #include <iomanip>
 #include <cstring>
+#include <sstream>
+#include <algorithm>
 
 #include "usb_device.hpp"
 #include "astra_log.hpp"
@@ -28,11 +30,37 @@ USBDevice::USBDevice(libusb_device *device, libusb_context *ctx)
     m_inputInterruptXfer = nullptr;
     m_outputInterruptXfer = nullptr;
     m_bulkWriteXfer = nullptr;
+    m_bulkReadXfer = nullptr;
     m_bulkInEndpoint = 0;
     m_bulkOutEndpoint = 0;
     m_bulkInSize = 0;
     m_bulkOutSize = 0;
     m_bulkTransferTimeout = 1000;
+    m_vendorId = 0;
+    m_productId = 0;
+
+    libusb_device_descriptor desc;
+    if (libusb_get_device_descriptor(m_device, &desc) == 0) {
+        m_vendorId = desc.idVendor;
+        m_productId = desc.idProduct;
+    }
+
+    // The port path is known before the device is opened, so devices can be
+    // matched to sessions without opening them.
+    uint8_t portNumbers[8];
+    uint8_t bus = libusb_get_bus_number(m_device);
+    int numElementsInPath = libusb_get_port_numbers(m_device, portNumbers, 8);
+    std::stringstream usbPathStream;
+    usbPathStream << static_cast<int>(bus) << "-";
+    log(ASTRA_LOG_LEVEL_DEBUG) << "Number of Elements in Path: " << numElementsInPath << endLog;
+    if (numElementsInPath > 0) {
+        usbPathStream << static_cast<int>(portNumbers[0]);
+        for (int i = 1; i < numElementsInPath; ++i) {
+            usbPathStream << "." << static_cast<int>(portNumbers[i]);
+        }
+    }
+    m_usbPath = usbPathStream.str();
+    log(ASTRA_LOG_LEVEL_DEBUG) << "USB Path: " << m_usbPath << endLog;
 }
 
 USBDevice::~USBDevice()
@@ -40,6 +68,21 @@ USBDevice::~USBDevice()
     ASTRA_LOG;
 
     Close();
+
+    // Transfers which Close() left in flight are freed once their callbacks have
+    // run, as the callbacks use both the transfers and this device
+    std::lock_guard<std::mutex> lock(m_closeMutex);
+    if (m_released) {
+        return;
+    }
+    while (m_transfersInFlight.load() > 0) {
+        if (WaitForTransfers() == LIBUSB_ERROR_BUSY) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "Destroying device from a libusb callback with "
+                << m_transfersInFlight.load() << " transfers in flight" << endLog;
+            return;
+        }
+    }
+    ReleaseTransfers();
 }
 
 int USBDevice::Open(std::function<void(USBEvent event, uint8_t *buf, size_t size)> usbEventCallback)
@@ -101,23 +144,6 @@ int USBDevice::Open(std::function<void(USBEvent event, uint8_t *buf, size_t size
         }
     }
 
-    uint8_t *portNumbers = new uint8_t[8];
-    uint8_t bus = libusb_get_bus_number(libusb_get_device(m_handle));
-    uint8_t port = libusb_get_port_number(libusb_get_device(m_handle));
-    int numElementsInPath = libusb_get_port_numbers(libusb_get_device(m_handle), portNumbers, 8);
-    std::stringstream usbPathStream;
-    usbPathStream << static_cast<int>(bus) << "-";
-    log(ASTRA_LOG_LEVEL_DEBUG) << "Number of Elements in Path: " << numElementsInPath << endLog;
-    if (numElementsInPath > 0) {
-        usbPathStream << static_cast<int>(portNumbers[0]);
-        for (int i = 1; i < numElementsInPath; ++i) {
-            usbPathStream << "." << static_cast<int>(portNumbers[i]);
-        }
-    }
-    delete[] portNumbers;
-    m_usbPath = usbPathStream.str();
-    log(ASTRA_LOG_LEVEL_DEBUG) << "USB Path: " << usbPathStream.str() << endLog;
-
     ret = libusb_detach_kernel_driver(m_handle, 0);
     if (ret < 0) {
         if (ret == LIBUSB_ERROR_NOT_FOUND || ret == LIBUSB_ERROR_NOT_SUPPORTED) {
@@ -208,6 +234,12 @@ int USBDevice::Open(std::function<void(USBEvent event, uint8_t *buf, size_t size
         return -1;
     }
 
+    m_bulkReadXfer = libusb_alloc_transfer(0);
+    if (!m_bulkReadXfer) {
+        log(ASTRA_LOG_LEVEL_ERROR) << "Failed to allocate bulk in transfer" << endLog;
+        return -1;
+    }
+
     libusb_fill_interrupt_transfer(m_inputInterruptXfer, m_handle, m_interruptInEndpoint,
         m_interruptInBuffer, m_interruptInSize, HandleTransfer, this, 0);
 
@@ -218,9 +250,16 @@ int USBDevice::EnableInterrupts()
 {
     ASTRA_LOG;
 
-    int ret = libusb_submit_transfer(m_inputInterruptXfer);
-    if (ret < 0) {
-        log(ASTRA_LOG_LEVEL_ERROR) << "Failed to submit input interrupt transfer: " << libusb_error_name(ret) << endLog;
+    int ret = 0;
+
+    // Devices such as the fastboot gadget only have bulk endpoints
+    if (m_interruptInEndpoint != 0) {
+        ret = libusb_submit_transfer(m_inputInterruptXfer);
+        if (ret < 0) {
+            log(ASTRA_LOG_LEVEL_ERROR) << "Failed to submit input interrupt transfer: " << libusb_error_name(ret) << endLog;
+        } else {
+            SubmitTransfer();
+        }
     }
 
     m_running.store(true);
@@ -228,6 +267,39 @@ int USBDevice::EnableInterrupts()
     return ret;
 }
 
+const std::string &USBDevice::ReadSerialNumber()
+{
+    ASTRA_LOG;
+
+    if (!m_serialNumber.empty() || m_handle) {
+        return m_serialNumber;
+    }
+
+    libusb_device_descriptor desc;
+    int ret = libusb_get_device_descriptor(m_device, &desc);
+    if (ret < 0 || desc.iSerialNumber == 0) {
+        return m_serialNumber;
+    }
+
+    libusb_device_handle *handle;
+    ret = libusb_open(m_device, &handle);
+    if (ret < 0) {
+        log(ASTRA_LOG_LEVEL_ERROR) << "Failed to open USB device: " << libusb_error_name(ret) << endLog;
+        return m_serialNumber;
+    }
+
+    unsigned char serialNumber[256];
+    ret = libusb_get_string_descriptor_ascii(handle, desc.iSerialNumber, serialNumber, sizeof(serialNumber));
+    if (ret < 0) {
+        log(ASTRA_LOG_LEVEL_ERROR) << "Failed to get serial number: " << libusb_error_name(ret) << endLog;
+    } else {
+        m_serialNumber = std::string(serialNumber, serialNumber + ret);
+    }
+    libusb_close(handle);
+
+    return m_serialNumber;
+}
+
 void USBDevice::Close()
 {
     ASTRA_LOG;
@@ -236,47 +308,98 @@ void USBDevice::Close()
     if (!m_shutdown.exchange(true))
     {
         m_running.store(false);
-        if (m_inputInterruptXfer) {
-            struct timeval tv = { 1, 0 };
-            libusb_cancel_transfer(m_inputInterruptXfer);
-            libusb_handle_events_timeout_completed(m_ctx, &tv, nullptr);
-            libusb_free_transfer(m_inputInterruptXfer);
-            m_inputInterruptXfer = nullptr;
-        }
 
-        if (m_outputInterruptXfer) {
-            struct timeval tv = { 1, 0 };
-            libusb_cancel_transfer(m_outputInterruptXfer);
-            libusb_handle_events_timeout_completed(m_ctx, &tv, nullptr);
-            libusb_free_transfer(m_outputInterruptXfer);
-            m_outputInterruptXfer = nullptr;
+        // Cancel everything at once and wait for the cancellations to be
+        // acknowledged, rather than waiting for each transfer in turn
+        for (struct libusb_transfer *transfer : {m_inputInterruptXfer, m_outputInterruptXfer, m_bulkWriteXfer, m_bulkReadXfer}) {
+            if (transfer) {
+                libusb_cancel_transfer(transfer);
+            }
+        }
+        if (WaitForTransfers() < 0) {
+            log(ASTRA_LOG_LEVEL_DEBUG) << "Transfers are freed when the device is destroyed" << endLog;
+            return;
         }
 
-        if (m_bulkWriteXfer) {
-            struct timeval tv = { 1, 0 };
-            libusb_cancel_transfer(m_bulkWriteXfer);
-            libusb_handle_events_timeout_completed(m_ctx, &tv, nullptr);
-            libusb_free_transfer(m_bulkWriteXfer);
-            m_bulkWriteXfer = nullptr;
+        ReleaseTransfers();
+    }
+}
+
+// Only called once no transfer is in flight
+void USBDevice::ReleaseTransfers()
+{
+    for (struct libusb_transfer **transfer : {&m_inputInterruptXfer, &m_outputInterruptXfer, &m_bulkWriteXfer, &m_bulkReadXfer}) {
+        if (*transfer) {
+            libusb_free_transfer(*transfer);
+            *transfer = nullptr;
         }
+    }
+
+    delete[] m_interruptInBuffer;
+    m_interruptInBuffer = nullptr;
 
-        delete[] m_interruptInBuffer;
-        m_interruptInBuffer = nullptr;
+    delete[] m_interruptOutBuffer;
+    m_interruptOutBuffer = nullptr;
 
-        delete[] m_interruptOutBuffer;
-        m_interruptOutBuffer = nullptr;
+    if (m_handle) {
+        libusb_release_interface(m_handle, m_interfaceNumber);
+        libusb_close(m_handle);
+        m_handle = nullptr;
+    }
+
+    libusb_unref_device(m_device);
+    m_released = true;
+}
+
+// Returns 0 once no transfer is in flight, -1 if transfers are still in flight after
+// m_cancelTimeout, or LIBUSB_ERROR_BUSY if called from a libusb callback
+int USBDevice::WaitForTransfers()
+{
+    ASTRA_LOG;
 
-        if (m_handle) {
-            libusb_release_interface(m_handle, m_interfaceNumber);
-            libusb_close(m_handle);
-            m_handle = nullptr;
+    auto deadline = std::chrono::steady_clock::now() + m_cancelTimeout;
+    while (m_transfersInFlight.load() > 0) {
+        auto remaining = deadline - std::chrono::steady_clock::now();
+        if (remaining <= std::chrono::steady_clock::duration::zero()) {
+            log(ASTRA_LOG_LEVEL_WARNING) << m_transfersInFlight.load() << " transfers not cancelled after "
+                << m_cancelTimeout.count() << " ms" << endLog;
+            return -1;
         }
 
-        libusb_unref_device(m_device);
+        // Returns as soon as the last transfer callback sets m_transfersIdle, whether
+        // this thread or the transport's monitor thread is handling events
+        auto wait = std::chrono::duration_cast<std::chrono::microseconds>(remaining);
+        struct timeval tv = { static_cast<long>(wait.count() / 1000000), static_cast<long>(wait.count() % 1000000) };
+        m_transfersIdle = 0;
+        if (m_transfersInFlight.load() == 0) {
+            return 0;
+        }
+        if (libusb_handle_events_timeout_completed(m_ctx, &tv, &m_transfersIdle) == LIBUSB_ERROR_BUSY) {
+            // Called from a libusb callback, the cancellations complete after it returns
+            log(ASTRA_LOG_LEVEL_WARNING) << "Closing device from a libusb callback" << endLog;
+            return LIBUSB_ERROR_BUSY;
+        }
     }
+
+    return 0;
 }
 
-int USBDevice::Write(uint8_t *data, size_t size, int *transferred)
+void USBDevice::SubmitTransfer()
+{
+    m_transfersInFlight.fetch_add(1);
+}
+
+// Must be the last access to the device from a transfer callback, the device may
+// be destroyed as soon as no transfer is in flight
+void USBDevice::TransferDone()
+{
+    if (m_transfersInFlight.load() == 1) {
+        m_transfersIdle = 1;
+    }
+    m_transfersInFlight.fetch_sub(1);
+}
+
+int USBDevice::SubmitBulkWrite(uint8_t *data, size_t size)
 {
     ASTRA_LOG;
 
@@ -295,7 +418,8 @@ int USBDevice::Write(uint8_t *data, size_t size, int *transferred)
     }
     log << std::dec << endLog;
 
-    libusb_fill_bulk_transfer(m_bulkWriteXfer, m_handle, m_bulkOutEndpoint, data, size, HandleTransfer, this, m_bulkTransferTimeout);
+    unsigned int timeout = static_cast<unsigned int>(std::max<size_t>(m_bulkTransferTimeout, size / m_minBulkBytesPerMs));
+    libusb_fill_bulk_transfer(m_bulkWriteXfer, m_handle, m_bulkOutEndpoint, data, size, HandleTransfer, this, timeout);
 
     for (;;) {
         int ret = libusb_submit_transfer(m_bulkWriteXfer);
@@ -319,9 +443,22 @@ int USBDevice::Write(uint8_t *data, size_t size, int *transferred)
             }
             return -1;
         }
+        SubmitTransfer();
         break;
     }
 
+    return 0;
+}
+
+int USBDevice::Write(uint8_t *data, size_t size, int *transferred)
+{
+    ASTRA_LOG;
+
+    int ret = SubmitBulkWrite(data, size);
+    if (ret < 0) {
+        return ret;
+    }
+
     std::unique_lock<std::mutex> lock(m_writeCompleteMutex);
     m_writeCompleteCV.wait(lock, [this] {
         if (m_writeComplete.load()) {
@@ -333,11 +470,78 @@ int USBDevice::Write(uint8_t *data, size_t size, int *transferred)
 
     *transferred = m_actualBytesWritten;
 
+    if (m_writeStatus != LIBUSB_TRANSFER_COMPLETED) {
+        log(ASTRA_LOG_LEVEL_ERROR) << "Write failed: status: " << static_cast<int>(m_writeStatus) << " bytes written: " << m_actualBytesWritten << endLog;
+        return -1;
+    }
+
     log(ASTRA_LOG_LEVEL_DEBUG) << "Write Complete: bytes written: " << m_actualBytesWritten << endLog;
 
     return 0;
 }
 
+int USBDevice::WriteAsync(uint8_t *data, size_t size, std::function<void(int ret, int transferred)> completion)
+{
+    ASTRA_LOG;
+
+    {
+        std::lock_guard<std::mutex> lock(m_writeCompleteMutex);
+        m_writeCompletion = completion;
+    }
+
+    int ret = SubmitBulkWrite(data, size);
+    if (ret < 0) {
+        std::lock_guard<std::mutex> lock(m_writeCompleteMutex);
+        m_writeCompletion = nullptr;
+        return ret;
+    }
+
+    return 0;
+}
+
+int USBDevice::Read(uint8_t *data, size_t size, int *transferred, unsigned int timeout)
+{
+    ASTRA_LOG;
+
+    if (!m_running.load()) {
+        return -1;
+    }
+
+    m_actualBytesRead = 0;
+
+    libusb_fill_bulk_transfer(m_bulkReadXfer, m_handle, m_bulkInEndpoint, data, size, HandleTransfer, this, timeout);
+
+    int ret = libusb_submit_transfer(m_bulkReadXfer);
+    if (ret < 0) {
+        log(ASTRA_LOG_LEVEL_ERROR) << "Failed to read from USB device: " << libusb_error_name(ret) << endLog;
+        if (ret == LIBUSB_ERROR_NO_DEVICE) {
+            m_running.store(false);
+        }
+        return -1;
+    }
+    SubmitTransfer();
+
+    std::unique_lock<std::mutex> lock(m_readCompleteMutex);
+    m_readCompleteCV.wait(lock, [this] {
+        if (m_readComplete.load()) {
+            m_readComplete.store(false);
+            return true;
+        }
+        return false;
+    });
+
+    *transferred = m_actualBytesRead;
+
+    if (m_readStatus != LIBUSB_TRANSFER_COMPLETED) {
+        log(ASTRA_LOG_LEVEL_ERROR) << "Read failed: status: " << static_cast<int>(m_readStatus) << endLog;
+        return -1;
+    }
+
+    log(ASTRA_LOG_LEVEL_DEBUG) << "Read Complete: bytes read: " << m_actualBytesRead << endLog;
+
+    return 0;
+}
+
 int USBDevice::WriteInterruptData(const uint8_t *data, size_t size)
 {
     ASTRA_LOG;
@@ -358,17 +562,68 @@ int USBDevice::WriteInterruptData(const uint8_t *data, size_t size)
     std::memcpy(m_interruptOutBuffer, data, size);
 
     libusb_fill_interrupt_transfer(m_outputInterruptXfer, m_handle, m_interruptOutEndpoint,
-        m_interruptOutBuffer, size, nullptr, nullptr, 0);
+        m_interruptOutBuffer, size, HandleTransfer, this, 0);
 
     int ret = libusb_submit_transfer(m_outputInterruptXfer);
     if (ret < 0) {
         log(ASTRA_LOG_LEVEL_ERROR) << "Failed to submit output interrupt transfer: " << libusb_error_name(ret) << endLog;
         return 1;
     }
+    SubmitTransfer();
 
     return 0;
 }
 
+// Wake up the thread waiting in Write() or Read(), or call the WriteAsync() completion.
+// Bulk transfers are completed whatever their status so a failed transfer does not leave the caller waiting.
+void USBDevice::CompleteBulkTransfer(struct libusb_transfer *transfer)
+{
+    ASTRA_LOG;
+
+    if (transfer->type != LIBUSB_TRANSFER_TYPE_BULK) {
+        return;
+    }
+
+    if (transfer->endpoint == m_bulkOutEndpoint) {
+        std::function<void(int ret, int transferred)> completion;
+        {
+            std::lock_guard<std::mutex> lock(m_writeCompleteMutex);
+            m_actualBytesWritten = transfer->actual_length;
+            m_writeStatus = transfer->status;
+            if (m_writeCompletion) {
+                completion = std::move(m_writeCompletion);
+                m_writeCompletion = nullptr;
+            } else {
+                m_writeComplete.store(true);
+                m_writeCompleteCV.notify_one();
+            }
+        }
+
+        if (completion) {
+            if (transfer->status != LIBUSB_TRANSFER_COMPLETED) {
+                log(ASTRA_LOG_LEVEL_ERROR) << "Write failed: status: " << static_cast<int>(transfer->status) << " bytes written: " << transfer->actual_length << endLog;
+            }
+            completion(transfer->status == LIBUSB_TRANSFER_COMPLETED ? 0 : -1, transfer->actual_length);
+        }
+    } else if (transfer->endpoint == m_bulkInEndpoint) {
+        std::lock_guard<std::mutex> lock(m_readCompleteMutex);
+        m_actualBytesRead = transfer->actual_length;
+        m_readStatus = transfer->status;
+        m_readComplete.store(true);
+        m_readCompleteCV.notify_one();
+    }
+}
+
+bool USBDevice::IsAsyncWrite(struct libusb_transfer *transfer)
+{
+    if (transfer->type != LIBUSB_TRANSFER_TYPE_BULK || transfer->endpoint != m_bulkOutEndpoint) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_writeCompleteMutex);
+    return static_cast<bool>(m_writeCompletion);
+}
+
 void USBDevice::HandleTransfer(struct libusb_transfer *transfer)
 {
     ASTRA_LOG;
@@ -379,51 +634,63 @@ void USBDevice::HandleTransfer(struct libusb_transfer *transfer)
 
     if (transfer->status == LIBUSB_TRANSFER_COMPLETED) {
         if (transfer->type == LIBUSB_TRANSFER_TYPE_BULK) {
-            if (transfer->endpoint == device->m_bulkOutEndpoint) {
-                device->m_actualBytesWritten = transfer->actual_length;
-                device->m_writeComplete.store(true);
-                device->m_writeCompleteCV.notify_one();
-            }
+            device->CompleteBulkTransfer(transfer);
         } else if (transfer->type == LIBUSB_TRANSFER_TYPE_INTERRUPT) {
             if (transfer->endpoint == device->m_interruptInEndpoint) {
                 device->m_usbEventCallback(USB_DEVICE_EVENT_INTERRUPT, transfer->buffer, transfer->actual_length);
+                resubmit = true;
             }
-            resubmit = true;
         }
     } else if (transfer->status == LIBUSB_TRANSFER_NO_DEVICE) {
         device->m_running.store(false);
         log(ASTRA_LOG_LEVEL_INFO) << "Device is no longer there during transfer: " << libusb_error_name(transfer->status) << endLog;
+        device->CompleteBulkTransfer(transfer);
         device->m_usbEventCallback(USB_DEVICE_EVENT_NO_DEVICE, nullptr, 0);
     } else if (transfer->status == LIBUSB_TRANSFER_CANCELLED) {
         device->m_running.store(false);
         log(ASTRA_LOG_LEVEL_DEBUG) << "Input transfer cancelled" << endLog;
+        device->CompleteBulkTransfer(transfer);
         device->m_usbEventCallback(USB_DEVICE_EVENT_TRANSFER_CANCELED, nullptr, 0);
     } else if (transfer->status == LIBUSB_TRANSFER_STALL) {
         log(ASTRA_LOG_LEVEL_WARNING) << "Endpoint stalled, clearing halt" << endLog;
+        bool asyncWrite = device->IsAsyncWrite(transfer);
         int ret = libusb_clear_halt(device->m_handle, transfer->endpoint);
         if (ret < 0) {
             log(ASTRA_LOG_LEVEL_ERROR) << "Failed to clear halt on endpoint: " << libusb_error_name(ret) << endLog;
+            device->CompleteBulkTransfer(transfer);
             if (ret == LIBUSB_ERROR_NO_DEVICE) {
                 device->m_running.store(false);
                 device->m_usbEventCallback(USB_DEVICE_EVENT_NO_DEVICE, nullptr, 0);
-            } else {
-                log(ASTRA_LOG_LEVEL_ERROR) << "Failed to clear halt on endpoint: " << libusb_error_name(ret) << endLog;
             }
+        } else if (asyncWrite) {
+            // Resubmitting would resend the bytes acknowledged before the stall.
+            // The WriteAsync() caller resumes from the acknowledged offset instead.
+            log(ASTRA_LOG_LEVEL_INFO) << "Halt cleared, completing write after " << transfer->actual_length << " bytes" << endLog;
+            device->CompleteBulkTransfer(transfer);
         } else {
             log(ASTRA_LOG_LEVEL_INFO) << "Halt cleared, retrying transfer" << endLog;
             resubmit = true;
         }
     } else {
         log(ASTRA_LOG_LEVEL_ERROR) << "Transfer failed: " << libusb_error_name(transfer->status) << endLog;
-        device->m_usbEventCallback(USB_DEVICE_EVENT_TRANSFER_ERROR, nullptr, 0);
+        // WriteAsync() callers retry failed writes themselves
+        bool asyncWrite = device->IsAsyncWrite(transfer);
+        device->CompleteBulkTransfer(transfer);
+        if (!asyncWrite) {
+            device->m_usbEventCallback(USB_DEVICE_EVENT_TRANSFER_ERROR, nullptr, 0);
+        }
     }
 
     if (resubmit && device->m_running.load()) {
         log(ASTRA_LOG_LEVEL_DEBUG) << "Resubmitting transfer" << endLog;
         int ret = libusb_submit_transfer(transfer);
-        if (ret < 0) {
-            log(ASTRA_LOG_LEVEL_ERROR) << "Failed to submit transfer: " << libusb_error_name(ret) << endLog;
-            device->m_usbEventCallback(USB_DEVICE_EVENT_TRANSFER_ERROR, nullptr, 0);
+        if (ret == 0) {
+            // Still in flight
+            return;
         }
+        log(ASTRA_LOG_LEVEL_ERROR) << "Failed to submit transfer: " << libusb_error_name(ret) << endLog;
+        device->m_usbEventCallback(USB_DEVICE_EVENT_TRANSFER_ERROR, nullptr, 0);
     }
+
+    device->TransferDone();
 }
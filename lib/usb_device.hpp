@@ -2,6 +2,7 @@
 // Copyright 2025 Synaptics Incorporated
 
 #pragma once
+#include <chrono>
 #include <cstdint>
 #include <cstddef>
 #include <thread>
@@ -31,8 +32,23 @@ public:
     void Close() override;
 
     std::string &GetUSBPath() { return m_usbPath; }
+    // Empty until the device has been opened or if it has no serial number
+    const std::string &GetSerialNumber() const { return m_serialNumber; }
+    // Read the serial number without claiming the device, so it can be matched
+    // to a job before a session opens it. Must not be called from a hotplug callback.
+    const std::string &ReadSerialNumber();
+    // True if both refer to the same enumeration of a device
+    bool IsSameDevice(const USBDevice &other) const { return m_device == other.m_device; }
+    uint16_t GetVendorId() const { return m_vendorId; }
+    uint16_t GetProductId() const { return m_productId; }
 
     int Write(uint8_t *data, size_t size, int *transferred) override;
+    int Read(uint8_t *data, size_t size, int *transferred, unsigned int timeout) override;
+    // Submit a bulk write and return immediately. The completion is called from the
+    // libusb event thread with ret < 0 if the transfer failed, and transferred set to the
+    // bytes the device acknowledged. A stalled endpoint is cleared before the completion
+    // is called. Data must stay valid until then.
+    int WriteAsync(uint8_t *data, size_t size, std::function<void(int ret, int transferred)> completion);
 
     int WriteInterruptData(const uint8_t *data, size_t size);
 
@@ -44,12 +60,18 @@ private:
     struct libusb_transfer *m_inputInterruptXfer;
     struct libusb_transfer *m_outputInterruptXfer;
     struct libusb_transfer *m_bulkWriteXfer;
+    struct libusb_transfer *m_bulkReadXfer;
     int m_actualBytesWritten;
+    int m_actualBytesRead;
     std::atomic<bool> m_running{false};
     std::atomic<bool> m_shutdown{false};
     std::mutex m_closeMutex;
+    // Set once the transfers, the handle and the device reference are freed
+    bool m_released = false;
     std::string m_serialNumber;
     std::string m_usbPath;
+    uint16_t m_vendorId;
+    uint16_t m_productId;
     int m_interfaceNumber;
 
     uint8_t m_interruptInEndpoint;
@@ -67,10 +89,35 @@ private:
     std::mutex m_writeCompleteMutex;
     std::condition_variable m_writeCompleteCV;
     std::atomic<bool> m_writeComplete = false;
+    libusb_transfer_status m_writeStatus;
+    std::function<void(int ret, int transferred)> m_writeCompletion;
+
+    std::mutex m_readCompleteMutex;
+    std::condition_variable m_readCompleteCV;
+    std::atomic<bool> m_readComplete = false;
+    libusb_transfer_status m_readStatus;
+
+    // Submitted transfers whose callback has not run yet
+    std::atomic<int> m_transfersInFlight{0};
+    // Set by the last transfer callback, passed to libusb as the completed flag
+    int m_transfersIdle = 0;
+    // Longest Close() waits for cancelled transfers to be acknowledged. Transfers still
+    // in flight after that are kept until their callbacks have run.
+    static constexpr std::chrono::milliseconds m_cancelTimeout{500};
 
     int m_bulkTransferTimeout;
+    // Lowest expected throughput in bytes per ms, used to scale the timeout of large writes
+    static constexpr size_t m_minBulkBytesPerMs = 4000;
 
     std::function<void(USBEvent event, uint8_t *buf, size_t size)> m_usbEventCallback;
 
+    int SubmitBulkWrite(uint8_t *data, size_t size);
+    void SubmitTransfer();
+    void TransferDone();
+    int WaitForTransfers();
+    void ReleaseTransfers();
+    void CompleteBulkTransfer(struct libusb_transfer *transfer);
+    bool IsAsyncWrite(struct libusb_transfer *transfer);
+
     static void LIBUSB_CALL HandleTransfer(struct libusb_transfer *transfer);
 };
\ No newline at end of file
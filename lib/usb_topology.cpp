@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#include <algorithm>
+
+#include "usb_topology.hpp"
+#include "astra_log.hpp"
+
+void USBTopology::SetHubBandwidth(uint64_t bytesPerSecond)
+{
+    ASTRA_LOG;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_hubBandwidth = bytesPerSecond;
+    m_hubs.clear();
+    log(ASTRA_LOG_LEVEL_DEBUG) << "Hub bandwidth: " << m_hubBandwidth << " bytes/s" << endLog;
+}
+
+uint64_t USBTopology::GetHubBandwidth()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_hubBandwidth;
+}
+
+std::vector<std::string> USBTopology::GetHubPath(const std::string &usbPath)
+{
+    std::vector<std::string> hubs;
+
+    // bus-port[.port...], every dot separated prefix is a hub
+    size_t portsStart = usbPath.find('-');
+    if (portsStart == std::string::npos) {
+        return hubs;
+    }
+
+    size_t end = usbPath.rfind('.');
+    while (end != std::string::npos && end > portsStart) {
+        hubs.push_back(usbPath.substr(0, end));
+        end = usbPath.rfind('.', end - 1);
+    }
+
+    return hubs;
+}
+
+std::string USBTopology::GetParentHub(const std::string &usbPath)
+{
+    std::vector<std::string> hubs = GetHubPath(usbPath);
+    return hubs.empty() ? usbPath : hubs.front();
+}
+
+USBTopology::Clock::duration USBTopology::TransferTime(uint64_t size) const
+{
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(static_cast<double>(size) / m_hubBandwidth));
+}
+
+USBTopology::Clock::duration USBTopology::Reserve(const std::string &usbPath, size_t size)
+{
+    std::vector<std::string> hubs = GetHubPath(usbPath);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_hubBandwidth == 0 || hubs.empty()) {
+        return Clock::duration::zero();
+    }
+
+    Clock::time_point now = Clock::now();
+    Clock::duration burst = TransferTime(m_burstSize);
+
+    // Wait for the busiest hub on the path
+    Clock::time_point start = now;
+    for (const auto &hub : hubs) {
+        Bucket &bucket = m_hubs[hub];
+        start = std::max(start, bucket.m_nextFree - burst);
+    }
+
+    Clock::duration transferTime = TransferTime(size);
+    for (const auto &hub : hubs) {
+        Bucket &bucket = m_hubs[hub];
+        bucket.m_nextFree = std::max(bucket.m_nextFree, start) + transferTime;
+    }
+
+    return start - now;
+}
@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Model of the USB hub tree built from device port paths such as 1-2.4.1.
+// Devices behind the same external hub share its bandwidth while devices on
+// different root ports do not compete. Each external hub has a token bucket
+// and a bulk transfer reserves its bytes on every hub between the device and
+// its root port, so a hub's bandwidth is shared between its devices in the
+// order they ask for it.
+class USBTopology
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Practical bulk throughput through a USB 2.0 high speed hub
+    static constexpr uint64_t m_defaultHubBandwidth = 40 * 1024 * 1024;
+
+    USBTopology(uint64_t hubBandwidth = m_defaultHubBandwidth) : m_hubBandwidth{hubBandwidth}
+    {}
+
+    // Bytes per second through each external hub. 0 disables scheduling.
+    void SetHubBandwidth(uint64_t bytesPerSecond);
+    uint64_t GetHubBandwidth();
+
+    // External hubs between the device and its root port, nearest first.
+    // Empty for a device connected directly to a root port.
+    static std::vector<std::string> GetHubPath(const std::string &usbPath);
+    // The hub the device is connected to, or the port path itself for a root port
+    static std::string GetParentHub(const std::string &usbPath);
+
+    // Reserve size bytes on every hub above the device. Returns how long to
+    // wait before starting the transfer, zero if it can start now.
+    Clock::duration Reserve(const std::string &usbPath, size_t size);
+
+private:
+    struct Bucket {
+        // Time at which the hub has carried every byte reserved so far
+        Clock::time_point m_nextFree;
+    };
+
+    std::mutex m_mutex;
+    uint64_t m_hubBandwidth;
+    std::unordered_map<std::string, Bucket> m_hubs;
+
+    // A transfer may start while less than this is still queued ahead of it on the hub
+    static constexpr uint64_t m_burstSize = 1024 * 1024;
+
+    Clock::duration TransferTime(uint64_t size) const;
+};
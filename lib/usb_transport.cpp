@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: Apache-2.0
 // Copyright 2025 Synaptics Incorporated
 
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <libusb-1.0/libusb.h>
@@ -28,6 +29,17 @@ void USBTransport::DeviceMonitorThread()
 
     while (m_running.load()) {
         struct timeval tv = { 1, 0 };
+        if (m_polling) {
+            auto now = std::chrono::steady_clock::now();
+            if (now >= m_nextPoll) {
+                ScanDevices();
+                now = std::chrono::steady_clock::now();
+                m_nextPoll = now + m_pollInterval;
+            }
+            auto wait = std::chrono::duration_cast<std::chrono::microseconds>(m_nextPoll - now);
+            tv = { static_cast<long>(wait.count() / 1000000), static_cast<long>(wait.count() % 1000000) };
+        }
+
         ret = libusb_handle_events_timeout_completed(m_ctx, &tv, nullptr);
         if (ret < 0) {
             if (ret == LIBUSB_ERROR_INTERRUPTED) {
@@ -41,12 +53,11 @@ void USBTransport::DeviceMonitorThread()
 }
 
 // Windows overrides this function in win_usb_transport.cpp. Add code which needs to run on Windows to that function as well.
-int USBTransport::Init(uint16_t vendorId, uint16_t productId, std::function<void(std::unique_ptr<USBDevice>)> deviceAddedCallback)
+int USBTransport::Init(const std::vector<std::tuple<uint16_t, uint16_t>> &deviceIds, std::function<void(std::unique_ptr<USBDevice>)> deviceAddedCallback)
 {
     ASTRA_LOG;
 
-    m_vendorId = vendorId;
-    m_productId = productId;
+    m_deviceIds = deviceIds;
 
     int ret = libusb_init(&m_ctx);
     if (ret < 0) {
@@ -63,21 +74,29 @@ int USBTransport::Init(uint16_t vendorId, uint16_t productId, std::function<void
     if (libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG)) {
         log(ASTRA_LOG_LEVEL_DEBUG) << "Hotplug is supported" << endLog;
 
-        ret = libusb_hotplug_register_callback(m_ctx,
-                                                LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED | LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT,
-                                                LIBUSB_HOTPLUG_ENUMERATE,
-                                                vendorId,
-                                                productId,
-                                                LIBUSB_HOTPLUG_MATCH_ANY,
-                                                HotplugEventCallback,
-                                                this,
-                                                &m_callbackHandle);
-        if (ret != LIBUSB_SUCCESS) {
-            log(ASTRA_LOG_LEVEL_ERROR) << "Failed to register hotplug callback: " << libusb_error_name(ret) << endLog;
+        for (const auto &[vendorId, productId] : deviceIds) {
+            libusb_hotplug_callback_handle callbackHandle;
+            ret = libusb_hotplug_register_callback(m_ctx,
+                                                    LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED | LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT,
+                                                    LIBUSB_HOTPLUG_ENUMERATE,
+                                                    vendorId,
+                                                    productId,
+                                                    LIBUSB_HOTPLUG_MATCH_ANY,
+                                                    HotplugEventCallback,
+                                                    this,
+                                                    &callbackHandle);
+            if (ret != LIBUSB_SUCCESS) {
+                log(ASTRA_LOG_LEVEL_ERROR) << "Failed to register hotplug callback: " << libusb_error_name(ret) << endLog;
+                break;
+            }
+            m_callbackHandles.push_back(callbackHandle);
         }
 
     } else {
-        log(ASTRA_LOG_LEVEL_DEBUG) << "Hotplug is NOT supported" << endLog;
+        log(ASTRA_LOG_LEVEL_INFO) << "Hotplug is NOT supported, polling for devices" << endLog;
+        m_polling = true;
+        m_pollInterval = m_minPollInterval;
+        m_nextPoll = std::chrono::steady_clock::now();
     }
 
     StartDeviceMonitor();
@@ -91,22 +110,118 @@ void USBTransport::Shutdown()
 
     std::lock_guard<std::mutex> lock(m_shutdownMutex);
     if (m_running.exchange(false)) {
-        if (m_callbackHandle) {
-            libusb_hotplug_deregister_callback(m_ctx, m_callbackHandle);
-            m_callbackHandle = 0;
+        for (auto callbackHandle : m_callbackHandles) {
+            libusb_hotplug_deregister_callback(m_ctx, callbackHandle);
         }
+        m_callbackHandles.clear();
 
         libusb_interrupt_event_handler(m_ctx);
         if (m_deviceMonitorThread.joinable()) {
             m_deviceMonitorThread.join();
         }
 
+        for (auto &[key, device] : m_knownDevices) {
+            if (device) {
+                libusb_unref_device(device);
+            }
+        }
+        m_knownDevices.clear();
+
         if (m_ctx) {
             libusb_exit(m_ctx);
         }
     }
 }
 
+// Bus, address and up to six port numbers. An address is only reused on a bus
+// once its device has gone, and the ports tell apart a device which came back
+// at the same address on another port between two scans.
+uint64_t USBTransport::MakeDeviceKey(libusb_device *device)
+{
+    uint8_t portNumbers[8];
+    int numElementsInPath = libusb_get_port_numbers(device, portNumbers, 8);
+
+    uint64_t key = (static_cast<uint64_t>(libusb_get_bus_number(device)) << 56) |
+        (static_cast<uint64_t>(libusb_get_device_address(device)) << 48);
+    for (int i = 0; i < numElementsInPath && i < 6; ++i) {
+        key |= static_cast<uint64_t>(portNumbers[i]) << (40 - 8 * i);
+    }
+
+    return key;
+}
+
+// Report the difference between the devices on the bus now and at the last scan.
+// Devices which are already known are not looked at again.
+void USBTransport::ScanDevices()
+{
+    ASTRA_LOG;
+
+    libusb_device **deviceList;
+    ssize_t count = libusb_get_device_list(m_ctx, &deviceList);
+    if (count < 0) {
+        log(ASTRA_LOG_LEVEL_ERROR) << "Failed to get device list: " << libusb_error_name(count) << endLog;
+        return;
+    }
+
+    std::unordered_map<uint64_t, libusb_device *> present;
+    present.reserve(count);
+    std::vector<libusb_device *> arrived;
+    for (ssize_t i = 0; i < count; ++i) {
+        libusb_device *device = deviceList[i];
+        uint64_t key = MakeDeviceKey(device);
+
+        auto it = m_knownDevices.find(key);
+        if (it != m_knownDevices.end()) {
+            present.emplace(key, it->second);
+            m_knownDevices.erase(it);
+            continue;
+        }
+
+        libusb_device_descriptor desc;
+        bool match = libusb_get_device_descriptor(device, &desc) == 0 && std::find(m_deviceIds.begin(), m_deviceIds.end(),
+            std::make_tuple(desc.idVendor, desc.idProduct)) != m_deviceIds.end();
+        present.emplace(key, match ? libusb_ref_device(device) : nullptr);
+        if (match) {
+            arrived.push_back(device);
+        }
+    }
+
+    // Whatever was not seen again has left. Departures are reported first so a
+    // device which re-enumerated on the same port leaves its session before the
+    // new device arrives.
+    bool changed = !arrived.empty();
+    for (auto &[key, device] : m_knownDevices) {
+        changed = true;
+        if (device) {
+            std::unique_ptr<USBDevice> usbDevice = std::make_unique<USBDevice>(device, m_ctx);
+            log(ASTRA_LOG_LEVEL_INFO) << "Device left: " << usbDevice->GetUSBPath() << endLog;
+            if (m_deviceRemovedCallback) {
+                m_deviceRemovedCallback(std::move(usbDevice));
+            }
+            libusb_unref_device(device);
+        }
+    }
+    m_knownDevices.swap(present);
+
+    for (libusb_device *device : arrived) {
+        std::unique_ptr<USBDevice> usbDevice = std::make_unique<USBDevice>(device, m_ctx);
+        log(ASTRA_LOG_LEVEL_INFO) << "Device arrived: " << usbDevice->GetUSBPath() << endLog;
+        if (m_deviceAddedCallback) {
+            m_deviceAddedCallback(std::move(usbDevice));
+        }
+    }
+
+    libusb_free_device_list(deviceList, 1);
+
+    m_pollInterval = changed ? std::chrono::steady_clock::duration(m_minPollInterval) :
+        std::min<std::chrono::steady_clock::duration>(m_pollInterval * 2, m_maxPollInterval);
+}
+
+void USBTransport::SetDeviceRemovedCallback(std::function<void(std::unique_ptr<USBDevice>)> deviceRemovedCallback)
+{
+    m_deviceRemovedCallback = deviceRemovedCallback;
+}
+
 void USBTransport::StartDeviceMonitor()
 {
     ASTRA_LOG;
@@ -159,6 +274,13 @@ int LIBUSB_CALL USBTransport::HotplugEventCallback(libusb_context *ctx, libusb_d
         } else {
             log(ASTRA_LOG_LEVEL_ERROR) << "No device added callback" << endLog;
         }
+    } else if (event == LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT) {
+        // Only identifies the device, it can no longer be opened
+        std::unique_ptr<USBDevice> usbDevice = std::make_unique<USBDevice>(device, transport->m_ctx);
+        log(ASTRA_LOG_LEVEL_INFO) << "Device left: " << usbDevice->GetUSBPath() << endLog;
+        if (transport->m_deviceRemovedCallback) {
+            transport->m_deviceRemovedCallback(std::move(usbDevice));
+        }
     }
 
     return 0;
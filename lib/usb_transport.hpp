@@ -4,6 +4,7 @@
 #pragma once
 #include <vector>
 #include <tuple>
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <thread>
@@ -11,6 +12,7 @@
 #include <functional>
 #include <libusb-1.0/libusb.h>
 #include <mutex>
+#include <unordered_map>
 
 #include "usb_device.hpp"
 
@@ -20,23 +22,39 @@ public:
     {}
     virtual ~USBTransport();
 
-    virtual int Init(uint16_t vendorId, uint16_t productId, std::function<void(std::unique_ptr<USBDevice>)> deviceAddedCallback);
+    virtual int Init(const std::vector<std::tuple<uint16_t, uint16_t>> &deviceIds, std::function<void(std::unique_ptr<USBDevice>)> deviceAddedCallback);
     virtual void Shutdown();
+    // Called from the hotplug callback when a matching device is removed. Set before Init.
+    void SetDeviceRemovedCallback(std::function<void(std::unique_ptr<USBDevice>)> deviceRemovedCallback);
 
     void StartDeviceMonitor();
 
 protected:
     bool m_usbDebug;
     libusb_context *m_ctx;
-    libusb_hotplug_callback_handle m_callbackHandle;
+    std::vector<libusb_hotplug_callback_handle> m_callbackHandles;
     std::function<void(std::unique_ptr<USBDevice>)> m_deviceAddedCallback;
+    std::function<void(std::unique_ptr<USBDevice>)> m_deviceRemovedCallback;
     std::thread m_deviceMonitorThread;
     std::atomic<bool> m_running;
     std::mutex m_shutdownMutex;
-    uint16_t m_vendorId;
-    uint16_t m_productId;
+    std::vector<std::tuple<uint16_t, uint16_t>> m_deviceIds;
+
+    // Without hotplug support the monitor thread enumerates the bus itself. The
+    // interval is short after a change, when more devices tend to follow, and backs
+    // off while nothing changes.
+    bool m_polling = false;
+    std::chrono::steady_clock::duration m_pollInterval;
+    std::chrono::steady_clock::time_point m_nextPoll;
+    static constexpr std::chrono::milliseconds m_minPollInterval{250};
+    static constexpr std::chrono::milliseconds m_maxPollInterval{2000};
+    // Devices seen by the last scan by MakeDeviceKey(). Matching devices hold a
+    // reference so their departure can be reported, others are nullptr.
+    std::unordered_map<uint64_t, libusb_device *> m_knownDevices;
 
     void DeviceMonitorThread();
+    void ScanDevices();
+    static uint64_t MakeDeviceKey(libusb_device *device);
 
     static int LIBUSB_CALL HotplugEventCallback(libusb_context *ctx, libusb_device *device,
                                                 libusb_hotplug_event event, void *user_data);
@@ -43,6 +43,11 @@ uint32_t HostToLE(uint32_t val)
     return htole32(val);
 #endif
 }
+
+int SeekFile(FILE *fp, uint64_t offset)
+{
+    return fseeko(fp, static_cast<off_t>(offset), SEEK_SET);
+}
 #elif defined(PLATFORM_WINDOWS)
 std::string MakeTempDirectory()
 {
@@ -74,4 +79,9 @@ uint32_t HostToLE(uint32_t val)
     return _byteswap_ulong(val);
 #endif
 }
+
+int SeekFile(FILE *fp, uint64_t offset)
+{
+    return _fseeki64(fp, static_cast<__int64>(offset), SEEK_SET);
+}
 #endif
\ No newline at end of file
@@ -4,6 +4,9 @@
 #pragma once
 
 #include <string>
+#include <cstdio>
+#include <cstdint>
 
 std::string MakeTempDirectory();
-uint32_t HostToLE(uint32_t val);
\ No newline at end of file
+uint32_t HostToLE(uint32_t val);
+int SeekFile(FILE *fp, uint64_t offset);
\ No newline at end of file
@@ -1,6 +1,8 @@
 // SPDX-License-Identifier: Apache-2.0
 // Copyright 2025 Synaptics Incorporated
 
+#include <algorithm>
+
 #include "win_usb_transport.hpp"
 #include "astra_log.hpp"
 #include <initguid.h>
@@ -13,12 +15,11 @@ WinUSBTransport::~WinUSBTransport()
     Shutdown();
 }
 
-int WinUSBTransport::Init(uint16_t vendorId, uint16_t productId, std::function<void(std::unique_ptr<USBDevice>)> deviceAddedCallback)
+int WinUSBTransport::Init(const std::vector<std::tuple<uint16_t, uint16_t>> &deviceIds, std::function<void(std::unique_ptr<USBDevice>)> deviceAddedCallback)
 {
     ASTRA_LOG;
 
-    m_vendorId = vendorId;
-    m_productId = productId;
+    m_deviceIds = deviceIds;
 
     int ret = libusb_init(&m_ctx);
     if (ret < 0) {
@@ -145,7 +146,9 @@ void WinUSBTransport::OnDeviceArrived()
             continue;
         }
 
-        if (desc.idVendor == m_vendorId && desc.idProduct == m_productId) {
+        bool match = std::find(m_deviceIds.begin(), m_deviceIds.end(),
+            std::make_tuple(desc.idVendor, desc.idProduct)) != m_deviceIds.end();
+        if (match) {
             std::unique_ptr<USBDevice> usbDevice = std::make_unique<USBDevice>(device, m_ctx);
             if (m_deviceAddedCallback) {
                 try {
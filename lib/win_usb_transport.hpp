@@ -15,7 +15,7 @@ class WinUSBTransport : public USBTransport {
 public:
     WinUSBTransport(bool usbDebug) : USBTransport(usbDebug) {};
     ~WinUSBTransport() override;
-    int Init(uint16_t vendorId, uint16_t productId, std::function<void(std::unique_ptr<USBDevice>)> deviceAddedCallback) override;
+    int Init(const std::vector<std::tuple<uint16_t, uint16_t>> &deviceIds, std::function<void(std::unique_ptr<USBDevice>)> deviceAddedCallback) override;
     void Shutdown() override;
 
 private:
@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: Apache-2.0
 // Copyright 2025 Synaptics Incorporated
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <queue>
@@ -10,6 +11,8 @@
 #include <indicators/progress_bar.hpp>
 #include <indicators/dynamic_progress.hpp>
 #include <unordered_map>
+#include <chrono>
+#include <vector>
 #include <csignal>
 
 #include "astra_device_manager.hpp"
@@ -18,22 +21,13 @@
 
 const std::string astraUpdateVersion = "1.0.0";
 
-// Define a struct to hold the two strings
-struct DeviceImageKey {
-    std::string deviceName;
-    std::string imageName;
+// Device and image names are interned so the pair of ids identifies a progress bar
+using DeviceImageKey = uint64_t;
 
-    bool operator==(const DeviceImageKey& other) const {
-        return deviceName == other.deviceName && imageName == other.imageName;
-    }
-};
-
-// Implement a custom hash function for the struct
-struct DeviceImageKeyHash {
-    std::size_t operator()(const DeviceImageKey& key) const {
-        return std::hash<std::string>()(key.deviceName) ^ std::hash<std::string>()(key.imageName);
-    }
-};
+DeviceImageKey MakeDeviceImageKey(AstraNameId deviceId, AstraNameId imageId)
+{
+    return (static_cast<uint64_t>(deviceId) << 32) | imageId;
+}
 
 std::queue<AstraDeviceManagerResponse> managerResponses;
 std::condition_variable managerResponsesCV;
@@ -47,29 +41,33 @@ void AstraDeviceManagerResponseCallback(AstraDeviceManagerResponse response)
     managerResponsesCV.notify_one();
 }
 
+std::unique_ptr<indicators::ProgressBar> MakeProgressBar(DeviceImageKey key)
+{
+    return std::make_unique<indicators::ProgressBar>(
+        indicators::option::BarWidth{50},
+        indicators::option::Start{"["},
+        indicators::option::Fill{"="},
+        indicators::option::Lead{">"},
+        indicators::option::Remainder{" "},
+        indicators::option::End{"]"},
+        indicators::option::PostfixText{AstraNames::Lookup(static_cast<AstraNameId>(key))},
+        indicators::option::PrefixText{AstraNames::Lookup(static_cast<AstraNameId>(key >> 32)) + ": "},
+        indicators::option::ForegroundColor{indicators::Color::green},
+        indicators::option::ShowElapsedTime{true},
+        indicators::option::ShowRemainingTime{true},
+        indicators::option::MaxProgress{100}
+    );
+}
+
 void UpdateProgressBars(DeviceResponse &deviceResponse,
     indicators::DynamicProgress<indicators::ProgressBar> &dynamicProgress,
-    std::unordered_map<DeviceImageKey, size_t, DeviceImageKeyHash> &progressBars)
+    std::unordered_map<DeviceImageKey, size_t> &progressBars)
 {
-    DeviceImageKey key{deviceResponse.m_deviceName, deviceResponse.m_imageName};
+    DeviceImageKey key = MakeDeviceImageKey(deviceResponse.m_deviceId, deviceResponse.m_imageId);
 
     // Ensure a progress bar exists for this image
     if (progressBars.find(key) == progressBars.end()) {
-        auto progress_bar = std::make_unique<indicators::ProgressBar>(
-            indicators::option::BarWidth{50},
-            indicators::option::Start{"["},
-            indicators::option::Fill{"="},
-            indicators::option::Lead{">"},
-            indicators::option::Remainder{" "},
-            indicators::option::End{"]"},
-            indicators::option::PostfixText{deviceResponse.m_imageName},
-            indicators::option::PrefixText{deviceResponse.m_deviceName + ": "},
-            indicators::option::ForegroundColor{indicators::Color::green},
-            indicators::option::ShowElapsedTime{true},
-            indicators::option::ShowRemainingTime{true},
-            indicators::option::MaxProgress{100}
-        );
-        size_t bardId = dynamicProgress.push_back(std::move(progress_bar));
+        size_t bardId = dynamicProgress.push_back(MakeProgressBar(key));
         progressBars[key] = bardId;
     }
 
@@ -83,11 +81,99 @@ void UpdateProgressBars(DeviceResponse &deviceResponse,
 
 void UpdateSimpleProgress(DeviceResponse &deviceResponse)
 {
-    std::cout << "Device: " << deviceResponse.m_deviceName
-                << " Image: " << deviceResponse.m_imageName
+    std::cout << "Device: " << deviceResponse.GetDeviceName()
+                << " Image: " << deviceResponse.GetImageName()
                 << " Progress: " << deviceResponse.m_progress << std::endl;
 }
 
+// Progress is polled from the device manager rather than reported as events
+void PollProgress(const std::vector<AstraDeviceProgress> &progress, bool simpleProgress,
+    indicators::DynamicProgress<indicators::ProgressBar> &dynamicProgress,
+    std::unordered_map<DeviceImageKey, size_t> &progressBars,
+    std::unordered_map<DeviceImageKey, int> &lastProgress)
+{
+    for (const auto &deviceProgress : progress) {
+        if (deviceProgress.m_imageSize == 0 || deviceProgress.m_imageBytesSent >= deviceProgress.m_imageSize) {
+            // Completion is reported by ASTRA_DEVICE_STATUS_IMAGE_SEND_COMPLETE
+            continue;
+        }
+
+        DeviceImageKey key = MakeDeviceImageKey(deviceProgress.m_deviceId, deviceProgress.m_imageId);
+
+        if (simpleProgress) {
+            int percent = static_cast<int>(deviceProgress.m_progress);
+            auto it = lastProgress.find(key);
+            if (it == lastProgress.end() || it->second != percent) {
+                lastProgress[key] = percent;
+                std::cout << "Device: " << AstraNames::Lookup(deviceProgress.m_deviceId)
+                            << " Image: " << AstraNames::Lookup(deviceProgress.m_imageId)
+                            << " Progress: " << deviceProgress.m_progress << std::endl;
+            }
+        } else {
+            auto it = progressBars.find(key);
+            if (it != progressBars.end() && !dynamicProgress[it->second].is_completed()) {
+                dynamicProgress[it->second].set_progress(deviceProgress.m_progress);
+            }
+        }
+    }
+}
+
+// Drop the progress state of a device which finished. DynamicProgress cannot
+// remove a bar, so the remaining bars are moved to a new set and the bars of
+// finished devices are not kept and redrawn for the rest of a continuous run.
+void RetireDeviceProgress(AstraNameId deviceId,
+    std::unique_ptr<indicators::DynamicProgress<indicators::ProgressBar>> &dynamicProgress,
+    std::unordered_map<DeviceImageKey, size_t> &progressBars,
+    std::unordered_map<DeviceImageKey, int> &lastProgress)
+{
+    bool retired = false;
+    for (auto it = progressBars.begin(); it != progressBars.end();) {
+        if ((it->first >> 32) == deviceId) {
+            auto &progressBar = (*dynamicProgress)[it->second];
+            if (!progressBar.is_completed()) {
+                progressBar.mark_as_completed();
+            }
+            it = progressBars.erase(it);
+            retired = true;
+        } else {
+            ++it;
+        }
+    }
+
+    for (auto it = lastProgress.begin(); it != lastProgress.end();) {
+        if ((it->first >> 32) == deviceId) {
+            it = lastProgress.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (!retired) {
+        return;
+    }
+
+    // Keep the remaining bars in the order they were added
+    std::vector<std::pair<size_t, DeviceImageKey>> remaining;
+    for (const auto &entry : progressBars) {
+        remaining.emplace_back(entry.second, entry.first);
+    }
+    std::sort(remaining.begin(), remaining.end());
+
+    auto nextProgress = std::make_unique<indicators::DynamicProgress<indicators::ProgressBar>>();
+    nextProgress->set_option(indicators::option::HideBarWhenComplete{false});
+    for (const auto &entry : remaining) {
+        auto &previous = (*dynamicProgress)[entry.first];
+        size_t barId = nextProgress->push_back(MakeProgressBar(entry.second));
+        auto &progressBar = (*nextProgress)[barId];
+        progressBar.set_progress(previous.current());
+        if (previous.is_completed()) {
+            progressBar.mark_as_completed();
+        }
+        progressBars[entry.second] = barId;
+    }
+    dynamicProgress = std::move(nextProgress);
+}
+
 void SignalHandler(int signal)
 {
     if (signal == SIGINT) {
@@ -109,7 +195,7 @@ int main(int argc, char* argv[])
         ("C,continuous", "Enabled updating multiple devices", cxxopts::value<bool>()->default_value("false"))
         ("h,help", "Print usage")
         ("T,temp-dir", "Temporary directory", cxxopts::value<std::string>()->default_value(""))
-        ("f,flash", "Flash image path", cxxopts::value<std::string>()->default_value("eMMCimg"))
+        ("f,flash", "Flash image path, optionally prefixed with its type as in spi=path. Repeat to flash several images on one board or to serve boards with different chips", cxxopts::value<std::vector<std::string>>()->default_value("eMMCimg"))
         ("b,board", "Board name", cxxopts::value<std::string>())
         ("c,chip", "Chip name", cxxopts::value<std::string>())
         ("M,manifest", "Manifest file path", cxxopts::value<std::string>())
@@ -119,6 +205,15 @@ int main(int argc, char* argv[])
         ("m,memory-layout", "Memory layout", cxxopts::value<std::string>())
         ("u,usb-debug", "Enable USB debug logging", cxxopts::value<bool>()->default_value("false"))
         ("S,simple-progress", "Disable progress bars and report progress messages", cxxopts::value<bool>()->default_value("false"))
+        ("F,fastboot", "Flash eMMC partitions using fastboot", cxxopts::value<bool>()->default_value("false"))
+        ("spi-compare", "Only rewrite SPI sectors which differ from the image", cxxopts::value<bool>()->default_value("false"))
+        ("V,verify", "Verify the flash contents after updating", cxxopts::value<bool>()->default_value("false"))
+        ("max-active", "Maximum number of devices to run at once, 0 for no limit", cxxopts::value<unsigned int>()->default_value("0"))
+        ("adaptive", "Adjust the number of devices running at once to the measured throughput", cxxopts::value<bool>()->default_value("false"))
+        ("P,station-plan", "Station plan which assigns flash jobs to USB ports or serial numbers", cxxopts::value<std::string>())
+        ("history-size", "Number of finished devices to keep a summary of in memory", cxxopts::value<unsigned int>()->default_value("256"))
+        ("history-file", "Append the summaries which no longer fit in memory to this file", cxxopts::value<std::string>()->default_value(""))
+        ("hub-bandwidth", "Bandwidth shared by the devices behind each USB hub in MiB/s, 0 for no limit", cxxopts::value<unsigned int>()->default_value("40"))
         ("v,version", "Print version");
 
     cxxopts::ParseResult result;
@@ -141,7 +236,7 @@ int main(int argc, char* argv[])
         return 0;
     }
 
-    std::string flashImagePath = result["flash"].as<std::string>();
+    std::vector<std::string> flashImagePaths = result["flash"].as<std::vector<std::string>>();
     std::string bootImagesPath = result["boot-image-collection"].as<std::string>();
     std::string logFilePath = result["log"].as<std::string>();
     std::string tempDir = result["temp-dir"].as<std::string>();
@@ -150,6 +245,11 @@ int main(int argc, char* argv[])
     AstraLogLevel logLevel = debug ?  ASTRA_LOG_LEVEL_DEBUG : ASTRA_LOG_LEVEL_INFO;
     bool usbDebug = result["usb-debug"].as<bool>();
     bool simpleProgress = result["simple-progress"].as<bool>();
+    unsigned int maxActive = result["max-active"].as<unsigned int>();
+    unsigned int historySize = result["history-size"].as<unsigned int>();
+    std::string historyFile = result["history-file"].as<std::string>();
+    unsigned int hubBandwidth = result["hub-bandwidth"].as<unsigned int>();
+    bool adaptive = result["adaptive"].as<bool>();
 
     if (usbDebug) {
         // Use simple progress when USB debugging is enabled
@@ -181,39 +281,87 @@ int main(int argc, char* argv[])
     if (result.count("memory-layout")) {
         config["memory_layout"] = result["memory-layout"].as<std::string>();
     }
+    if (result["fastboot"].as<bool>()) {
+        config["transport"] = "fastboot";
+    }
+    if (result["spi-compare"].as<bool>()) {
+        config["spi_compare"] = "true";
+    }
+    if (result["verify"].as<bool>()) {
+        config["verify"] = "true";
+    }
 
     // DynamicProgress to manage multiple progress bars
-    indicators::DynamicProgress<indicators::ProgressBar> dynamicProgress;
-    std::unordered_map<DeviceImageKey, size_t, DeviceImageKeyHash> progressBars;
+    auto dynamicProgress = std::make_unique<indicators::DynamicProgress<indicators::ProgressBar>>();
+    std::unordered_map<DeviceImageKey, size_t> progressBars;
+    std::unordered_map<DeviceImageKey, int> lastProgress;
+    const auto progressInterval = std::chrono::milliseconds(100);
 
-    dynamicProgress.set_option(indicators::option::HideBarWhenComplete{false});
+    dynamicProgress->set_option(indicators::option::HideBarWhenComplete{false});
 
     std::cout << "Astra Update\n" << std::endl;
 
-    std::shared_ptr<FlashImage> flashImage;
-    try {
-        flashImage = FlashImage::FlashImageFactory(flashImagePath, config, manifest);
-    } catch (const std::exception& e) {
-        std::cerr << "Failed to load flash image: " << e.what() << std::endl;
-        return -1;
+    std::string stationPlanPath;
+    if (result.count("station-plan")) {
+        // The plan names each job's image, the other image parameters apply to every job
+        if (result.count("flash") || result.count("manifest")) {
+            std::cerr << "--flash and --manifest cannot be used with --station-plan" << std::endl;
+            return -1;
+        }
+        stationPlanPath = result["station-plan"].as<std::string>();
+        std::cout << "Station Plan: " << stationPlanPath << "\n" << std::endl;
+        flashImagePaths.clear();
     }
 
-    int ret = flashImage->Load();
-    if (ret < 0) {
-        std::cerr << "Failed to load flash image" << std::endl;
-        return -1;
-    }
+    std::vector<std::shared_ptr<FlashImage>> flashImages;
+    for (const auto &flashImageArg : flashImagePaths) {
+        // Each image gets its own copy so values from one image's manifest do not apply to the next
+        std::map<std::string, std::string> imageConfig = config;
+        std::string flashImagePath = flashImageArg;
+        size_t typeSeparator = flashImageArg.find('=');
+        if (typeSeparator != std::string::npos) {
+            imageConfig["image_type"] = flashImageArg.substr(0, typeSeparator);
+            flashImagePath = flashImageArg.substr(typeSeparator + 1);
+        }
+
+        std::shared_ptr<FlashImage> flashImage;
+        try {
+            flashImage = FlashImage::FlashImageFactory(flashImagePath, imageConfig, manifest);
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to load flash image: " << e.what() << std::endl;
+            return -1;
+        }
 
-    std::cout << "Update Image: " << flashImage->GetChipName() << " " << flashImage->GetBoardName() << std::endl;
-    std::cout << "    Image Type: " << AstraFlashImageTypeToString(flashImage->GetFlashImageType()) << std::endl;
-    std::cout << "    Secure Boot: " << AstraSecureBootVersionToString(flashImage->GetSecureBootVersion()) << std::endl;
-    std::cout << "    Memory Layout: " << AstraMemoryLayoutToString(flashImage->GetMemoryLayout()) << std::endl;
-    std::cout << "    Boot Image ID: " << flashImage->GetBootImageId() << "\n" << std::endl;
+        int ret = flashImage->Load();
+        if (ret < 0) {
+            std::cerr << "Failed to load flash image" << std::endl;
+            return -1;
+        }
+
+        std::cout << "Update Image: " << flashImage->GetChipName() << " " << flashImage->GetBoardName() << std::endl;
+        std::cout << "    Image Type: " << AstraFlashImageTypeToString(flashImage->GetFlashImageType()) << std::endl;
+        std::cout << "    Secure Boot: " << AstraSecureBootVersionToString(flashImage->GetSecureBootVersion()) << std::endl;
+        std::cout << "    Memory Layout: " << AstraMemoryLayoutToString(flashImage->GetMemoryLayout()) << std::endl;
+        std::cout << "    Boot Image ID: " << flashImage->GetBootImageId() << "\n" << std::endl;
+
+        flashImages.push_back(flashImage);
+    }
 
     AstraDeviceManager deviceManager(AstraDeviceManagerResponseCallback, continuous, logLevel, logFilePath, tempDir, usbDebug);
+    deviceManager.SetMaxActiveSessions(maxActive);
+    deviceManager.SetAdaptiveConcurrency(adaptive);
+    deviceManager.SetHubBandwidth(static_cast<uint64_t>(hubBandwidth) * 1024 * 1024);
+    if (deviceManager.SetSessionHistory(historySize, historyFile) < 0) {
+        std::cerr << "Failed to open history file: " << historyFile << std::endl;
+        return -1;
+    }
 
     try {
-        deviceManager.Update(flashImage, bootImagesPath);
+        if (stationPlanPath.empty()) {
+            deviceManager.Update(flashImages, bootImagesPath);
+        } else {
+            deviceManager.UpdateStation(stationPlanPath, bootImagesPath, config);
+        }
      } catch (const std::exception& e) {
         std::cerr << "Failed to initialize update: " << e.what() << std::endl;
         return -1;
@@ -222,54 +370,77 @@ int main(int argc, char* argv[])
     indicators::show_console_cursor(false);
 
     if (running.load()) {
+        auto nextProgressPoll = std::chrono::steady_clock::now();
         while (true) {
             std::unique_lock<std::mutex> lock(managerResponsesMutex);
-            managerResponsesCV.wait(lock, []{ return !managerResponses.empty() || !running.load(); });
+            managerResponsesCV.wait_until(lock, nextProgressPoll, []{ return !managerResponses.empty() || !running.load(); });
 
             if (!running.load()) {
                 break;
             }
 
+            if (std::chrono::steady_clock::now() >= nextProgressPoll) {
+                lock.unlock();
+                PollProgress(deviceManager.GetProgressSnapshot(), simpleProgress, *dynamicProgress, progressBars, lastProgress);
+                nextProgressPoll = std::chrono::steady_clock::now() + progressInterval;
+                lock.lock();
+            }
+
+            if (managerResponses.empty()) {
+                continue;
+            }
+
             auto status = managerResponses.front();
             managerResponses.pop();
 
             if (status.IsDeviceManagerResponse()) {
                 auto managerResponse = status.GetDeviceManagerResponse();
                 if (managerResponse.m_managerStatus == ASTRA_DEVICE_MANAGER_STATUS_INFO) {
-                    std::cout << managerResponse.m_managerMessage << "\n" << std::endl;
+                    std::cout << managerResponse.GetMessage() << "\n" << std::endl;
                 } else if (managerResponse.m_managerStatus == ASTRA_DEVICE_MANAGER_STATUS_SHUTDOWN) {
                     break;
                 } else if (managerResponse.m_managerStatus == ASTRA_DEVICE_MANAGER_STATUS_START) {
-                    std::cout << managerResponse.m_managerMessage << "\n" << std::endl;
+                    std::cout << managerResponse.GetMessage() << "\n" << std::endl;
                 } else {
                     std::cout << "Device Manager status: " << managerResponse.m_managerStatus
-                            << " Message: " << managerResponse.m_managerMessage << std::endl;
+                            << " Message: " << managerResponse.GetMessage() << std::endl;
                 }
             } else if (status.IsDeviceResponse()) {
                 auto deviceResponse = status.GetDeviceResponse();
 
                 if (deviceResponse.m_status == ASTRA_DEVICE_STATUS_ADDED) {
-                    std::cout << "Detected Device: " << deviceResponse.m_deviceName << std::endl;
+                    std::cout << "Detected Device: " << deviceResponse.GetDeviceName() << std::endl;
                 } else if (deviceResponse.m_status == ASTRA_DEVICE_STATUS_BOOT_START) {
-                    std::cout << "Booting Device: " << deviceResponse.m_deviceName << std::endl;
+                    std::cout << "Booting Device: " << deviceResponse.GetDeviceName() << std::endl;
                 } else if (deviceResponse.m_status == ASTRA_DEVICE_STATUS_BOOT_COMPLETE) {
-                    std::cout << "Booting " << deviceResponse.m_deviceName << " is complete" << std::endl;
+                    std::cout << "Booting " << deviceResponse.GetDeviceName() << " is complete" << std::endl;
                 } else if (deviceResponse.m_status == ASTRA_DEVICE_STATUS_UPDATE_START) {
-                    std::cout << "Updating Device: " << deviceResponse.m_deviceName << std::endl;
+                    std::cout << "Updating Device: " << deviceResponse.GetDeviceName() << std::endl;
                 } else if (deviceResponse.m_status == ASTRA_DEVICE_STATUS_UPDATE_COMPLETE) {
-                    std::cout << "Device: " << deviceResponse.m_deviceName << " Update Complete" << std::endl;
+                    std::cout << "Device: " << deviceResponse.GetDeviceName() << " Update Complete" << std::endl;
+                    RetireDeviceProgress(deviceResponse.m_deviceId, dynamicProgress, progressBars, lastProgress);
                 } else if (deviceResponse.m_status == ASTRA_DEVICE_STATUS_BOOT_FAIL) {
-                    std::cout << "Device: " << deviceResponse.m_deviceName << " Boot Failed: " << deviceResponse.m_message << std::endl;
+                    std::cout << "Device: " << deviceResponse.GetDeviceName() << " Boot Failed: " << deviceResponse.GetMessage()
+                        << (deviceResponse.m_imageId != ASTRA_NAME_NONE ? " " + deviceResponse.GetImageName() : "") << std::endl;
+                    RetireDeviceProgress(deviceResponse.m_deviceId, dynamicProgress, progressBars, lastProgress);
                 } else if (deviceResponse.m_status == ASTRA_DEVICE_STATUS_UPDATE_FAIL) {
-                    std::cout << "Device: " << deviceResponse.m_deviceName << " Update Failed: " << deviceResponse.m_message << std::endl;
+                    std::cout << "Device: " << deviceResponse.GetDeviceName() << " Update Failed: " << deviceResponse.GetMessage()
+                        << (deviceResponse.m_imageId != ASTRA_NAME_NONE ? " " + deviceResponse.GetImageName() : "") << std::endl;
+                    RetireDeviceProgress(deviceResponse.m_deviceId, dynamicProgress, progressBars, lastProgress);
+                } else if (deviceResponse.m_status == ASTRA_DEVICE_STATUS_VERIFY_START) {
+                    std::cout << "Verifying Device: " << deviceResponse.GetDeviceName() << std::endl;
+                } else if (deviceResponse.m_status == ASTRA_DEVICE_STATUS_VERIFY_COMPLETE) {
+                    std::cout << "Device: " << deviceResponse.GetDeviceName() << " Verify Complete" << std::endl;
+                } else if (deviceResponse.m_status == ASTRA_DEVICE_STATUS_VERIFY_FAIL) {
+                    std::cout << "Device: " << deviceResponse.GetDeviceName() << " Verify Failed: " << deviceResponse.GetImageName()
+                        << ": " << deviceResponse.GetMessage() << std::endl;
                 } else if (deviceResponse.m_status == ASTRA_DEVICE_STATUS_IMAGE_SEND_START ||
-                    deviceResponse.m_status == ASTRA_DEVICE_STATUS_IMAGE_SEND_PROGRESS ||
                     deviceResponse.m_status == ASTRA_DEVICE_STATUS_IMAGE_SEND_COMPLETE)
                 {
                     if (simpleProgress) {
                         UpdateSimpleProgress(deviceResponse);
                     } else {
-                        UpdateProgressBars(deviceResponse, dynamicProgress, progressBars);
+                        UpdateProgressBars(deviceResponse, *dynamicProgress, progressBars);
                     }
                 }
             }
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include "astra_flash_watchdog.hpp"
+#include "astra_reactor.hpp"
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+            ++failures; \
+        } \
+    } while (0)
+
+static constexpr std::chrono::milliseconds flashCommandTimeout{100};
+
+// A boot which takes longer than the flash command timeout does not fail the
+// update, as long as the flash command completes in time once the boot is done
+static void TestLongBoot(AstraReactor &reactor)
+{
+    auto strand = std::make_shared<AstraStrand>(reactor);
+    AstraFlashWatchdog watchdog(strand);
+    std::atomic<bool> expired{false};
+
+    // Armed when the update is requested, while the device is booting
+    watchdog.Arm(flashCommandTimeout, [&expired] { expired.store(true); });
+    std::this_thread::sleep_for(3 * flashCommandTimeout);
+    CHECK(!expired.load());
+
+    // Boot complete, then the flash command finishes within its timeout
+    watchdog.StartFlashPhase();
+    std::this_thread::sleep_for(flashCommandTimeout / 2);
+    watchdog.Cancel();
+    std::this_thread::sleep_for(2 * flashCommandTimeout);
+    CHECK(!expired.load());
+}
+
+// The timeout counts from the end of the boot
+static void TestFlashCommandTimeout(AstraReactor &reactor)
+{
+    auto strand = std::make_shared<AstraStrand>(reactor);
+    AstraFlashWatchdog watchdog(strand);
+    std::atomic<bool> expired{false};
+
+    watchdog.Arm(flashCommandTimeout, [&expired] { expired.store(true); });
+    std::this_thread::sleep_for(2 * flashCommandTimeout);
+    watchdog.StartFlashPhase();
+    std::this_thread::sleep_for(3 * flashCommandTimeout);
+    CHECK(expired.load());
+}
+
+// Later targets are armed after the boot and start at once, replacing the previous watchdog
+static void TestArmInFlashPhase(AstraReactor &reactor)
+{
+    auto strand = std::make_shared<AstraStrand>(reactor);
+    AstraFlashWatchdog watchdog(strand);
+    std::atomic<int> expired{0};
+
+    watchdog.StartFlashPhase();
+    watchdog.Arm(flashCommandTimeout, [&expired] { expired.fetch_add(1); });
+    watchdog.Arm(flashCommandTimeout, [&expired] { expired.fetch_add(2); });
+    std::this_thread::sleep_for(3 * flashCommandTimeout);
+    CHECK(expired.load() == 2);
+
+    // A zero timeout disables the watchdog
+    watchdog.Arm(std::chrono::milliseconds(0), [&expired] { expired.fetch_add(4); });
+    std::this_thread::sleep_for(2 * flashCommandTimeout);
+    CHECK(expired.load() == 2);
+}
+
+int main()
+{
+    AstraReactor reactor(2, 1);
+
+    TestLongBoot(reactor);
+    TestFlashCommandTimeout(reactor);
+    TestArmInFlashPhase(reactor);
+
+    reactor.Shutdown();
+
+    if (failures) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "astra_flash_watchdog_test passed" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,201 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fastboot_client.hpp"
+#include "sparse_image.hpp"
+#include "loopback_fastboot_device.hpp"
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+            ++failures; \
+        } \
+    } while (0)
+
+static constexpr uint32_t blockSize = 4096;
+
+// Raw data, a zero filled run, a run filled with one 32 bit value, more raw
+// data and a tail which is not block aligned
+static std::vector<uint8_t> MakeImage()
+{
+    std::vector<uint8_t> image;
+    uint32_t seed = 1;
+    auto random = [&seed]() {
+        seed = seed * 1103515245 + 12345;
+        return static_cast<uint8_t>(seed >> 16);
+    };
+
+    for (uint32_t i = 0; i < 3 * blockSize; ++i) {
+        image.push_back(random());
+    }
+    image.insert(image.end(), 8 * blockSize, 0);
+    for (uint32_t i = 0; i < 2 * blockSize; ++i) {
+        static const uint8_t pattern[] = {0xA5, 0x5A, 0x0F, 0xF0};
+        image.push_back(pattern[i % 4]);
+    }
+    for (uint32_t i = 0; i < 5 * blockSize + 100; ++i) {
+        image.push_back(random());
+    }
+
+    return image;
+}
+
+static std::string WriteImage(const std::vector<uint8_t> &image)
+{
+    std::string path = (std::filesystem::temp_directory_path() / "astra_fastboot_test.img").string();
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(image.data()), image.size());
+
+    return path;
+}
+
+// The partition must hold the image followed by the zero padding of its last block
+static bool PartitionMatches(const std::vector<uint8_t> &partition, const std::vector<uint8_t> &image)
+{
+    size_t paddedSize = (image.size() + blockSize - 1) / blockSize * blockSize;
+    if (partition.size() != paddedSize || !std::equal(image.begin(), image.end(), partition.begin())) {
+        return false;
+    }
+
+    return std::all_of(partition.begin() + image.size(), partition.end(), [](uint8_t value) { return value == 0; });
+}
+
+static int FlashPartition(FastbootClient &fastboot, const std::string &path, uint64_t maxDownloadSize,
+    size_t &imageCount)
+{
+    std::vector<std::unique_ptr<SparseImage>> sparseImages;
+    int ret = SparseImage::Create(path, blockSize, maxDownloadSize, sparseImages);
+    if (ret < 0) {
+        return ret;
+    }
+    imageCount = sparseImages.size();
+
+    for (const auto &sparseImage : sparseImages) {
+        uint64_t lastProgress = 0;
+        ret = fastboot.Download(*sparseImage, [&lastProgress](uint64_t transferred) {
+            lastProgress = transferred;
+        });
+        if (ret < 0) {
+            return ret;
+        }
+        CHECK(lastProgress == sparseImage->GetSize());
+
+        ret = fastboot.Flash("userdata");
+        if (ret < 0) {
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+// Everything fits in one download. The image is sent as RAW and FILL chunks and
+// nothing is left as DONT_CARE.
+static void TestSingleDownload(const std::string &path, const std::vector<uint8_t> &image)
+{
+    LoopbackFastbootDevice device(64 * 1024 * 1024);
+    FastbootClient fastboot(&device);
+
+    size_t imageCount = 0;
+    CHECK(FlashPartition(fastboot, path, 64 * 1024 * 1024, imageCount) == 0);
+    CHECK(imageCount == 1);
+    CHECK(device.GetDownloadsFlashed() == 1);
+    CHECK(PartitionMatches(device.GetPartition("userdata"), image));
+
+    const auto &chunks = device.GetChunks();
+    CHECK(chunks.size() == 4);
+    if (chunks.size() == 4) {
+        CHECK(chunks[0].m_type == SPARSE_CHUNK_TYPE_RAW && chunks[0].m_blocks == 3);
+        CHECK(chunks[1].m_type == SPARSE_CHUNK_TYPE_FILL && chunks[1].m_blocks == 8);
+        CHECK(chunks[2].m_type == SPARSE_CHUNK_TYPE_FILL && chunks[2].m_blocks == 2);
+        CHECK(chunks[3].m_type == SPARSE_CHUNK_TYPE_RAW && chunks[3].m_blocks == 6);
+    }
+
+    const auto &commands = device.GetCommands();
+    CHECK(commands.size() == 2);
+    if (commands.size() == 2) {
+        CHECK(commands[0].rfind("download:", 0) == 0);
+        CHECK(commands[1] == "flash:userdata");
+    }
+}
+
+// The size reported by getvar:max-download-size splits the partition into several
+// sparse images. Each one stays within the limit and marks the blocks sent by the
+// others as DONT_CARE.
+static void TestMaxDownloadSize(const std::string &path, const std::vector<uint8_t> &image)
+{
+    const uint32_t maxDownloadSize = 3 * blockSize;
+    LoopbackFastbootDevice device(maxDownloadSize);
+    FastbootClient fastboot(&device);
+
+    std::string value;
+    CHECK(fastboot.GetVar("max-download-size", value) == 0);
+    uint64_t reported = std::strtoull(value.c_str(), nullptr, 0);
+    CHECK(reported == maxDownloadSize);
+
+    size_t imageCount = 0;
+    CHECK(FlashPartition(fastboot, path, reported, imageCount) == 0);
+    CHECK(imageCount > 1);
+    CHECK(device.GetDownloadsFlashed() == imageCount);
+    CHECK(PartitionMatches(device.GetPartition("userdata"), image));
+
+    for (uint64_t size : device.GetDownloadSizes()) {
+        CHECK(size <= maxDownloadSize);
+    }
+
+    bool dontCare = false;
+    for (const auto &chunk : device.GetChunks()) {
+        dontCare |= chunk.m_type == SPARSE_CHUNK_TYPE_DONT_CARE;
+    }
+    CHECK(dontCare);
+}
+
+// A download larger than the device accepts is refused before any data is sent
+static void TestDownloadTooLarge(const std::string &path)
+{
+    LoopbackFastbootDevice device(2 * blockSize);
+    FastbootClient fastboot(&device);
+
+    std::vector<std::unique_ptr<SparseImage>> sparseImages;
+    CHECK(SparseImage::Create(path, blockSize, 64 * 1024 * 1024, sparseImages) == 0);
+    CHECK(sparseImages.size() == 1);
+    if (sparseImages.size() == 1) {
+        CHECK(fastboot.Download(*sparseImages[0], nullptr) < 0);
+        CHECK(device.GetDownloadSizes().empty());
+    }
+
+    std::string value;
+    CHECK(fastboot.GetVar("unknown", value) < 0);
+}
+
+int main()
+{
+    std::vector<uint8_t> image = MakeImage();
+    std::string path = WriteImage(image);
+
+    TestSingleDownload(path, image);
+    TestMaxDownloadSize(path, image);
+    TestDownloadTooLarge(path);
+
+    std::filesystem::remove(path);
+
+    if (failures) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "fastboot_test passed" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,192 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "device.hpp"
+
+// Software stand-in for a fastboot gadget. Commands written to it are answered
+// with the responses a U-Boot fastboot device sends, downloads are kept in
+// memory and flashing expands the downloaded sparse image onto an in memory
+// partition, so a test can compare the partition with the source image.
+class LoopbackFastbootDevice : public Device
+{
+public:
+    struct SparseChunkRecord {
+        uint16_t m_type;
+        uint32_t m_blocks;
+    };
+
+    LoopbackFastbootDevice(uint32_t maxDownloadSize) : m_maxDownloadSize{maxDownloadSize}
+    {}
+    virtual ~LoopbackFastbootDevice()
+    {}
+
+    void Close() override
+    {}
+
+    int Write(uint8_t *data, size_t size, int *transferred) override
+    {
+        *transferred = static_cast<int>(size);
+
+        if (m_downloadRemaining > 0) {
+            if (size > m_downloadRemaining) {
+                m_responses.push_back("FAILtoo much data");
+                m_downloadRemaining = 0;
+                return 0;
+            }
+            m_download.insert(m_download.end(), data, data + size);
+            m_downloadRemaining -= size;
+            if (m_downloadRemaining == 0) {
+                m_responses.push_back("OKAY");
+            }
+            return 0;
+        }
+
+        std::string command(reinterpret_cast<char *>(data), size);
+        m_commands.push_back(command);
+
+        if (command == "getvar:max-download-size") {
+            char value[16];
+            std::snprintf(value, sizeof(value), "0x%08x", m_maxDownloadSize);
+            m_responses.push_back("OKAY" + std::string(value));
+        } else if (command.rfind("getvar:", 0) == 0) {
+            m_responses.push_back("FAILunknown variable");
+        } else if (command.rfind("download:", 0) == 0) {
+            uint64_t downloadSize = std::strtoull(command.c_str() + 9, nullptr, 16);
+            if (downloadSize == 0 || downloadSize > m_maxDownloadSize) {
+                m_responses.push_back("FAILdata too large");
+                return 0;
+            }
+            m_download.clear();
+            m_downloadRemaining = downloadSize;
+            m_responses.push_back("DATA" + command.substr(9));
+        } else if (command.rfind("flash:", 0) == 0) {
+            m_responses.push_back("INFOwriting " + command.substr(6));
+            m_responses.push_back(FlashSparse(m_partitions[command.substr(6)]) ? "OKAY" : "FAILinvalid sparse image");
+            ++m_downloadsFlashed;
+        } else if (command == "reboot") {
+            m_responses.push_back("OKAY");
+        } else {
+            m_responses.push_back("FAILunknown command");
+        }
+
+        return 0;
+    }
+
+    int Read(uint8_t *data, size_t size, int *transferred, unsigned int timeout) override
+    {
+        if (m_responses.empty()) {
+            return -1;
+        }
+
+        std::string response = m_responses.front();
+        m_responses.pop_front();
+        *transferred = static_cast<int>(std::min(size, response.size()));
+        std::memcpy(data, response.data(), *transferred);
+
+        return 0;
+    }
+
+    const std::vector<uint8_t> &GetPartition(const std::string &name) { return m_partitions[name]; }
+    const std::vector<std::string> &GetCommands() const { return m_commands; }
+    const std::vector<SparseChunkRecord> &GetChunks() const { return m_chunks; }
+    const std::vector<uint64_t> &GetDownloadSizes() const { return m_downloadSizes; }
+    uint32_t GetDownloadsFlashed() const { return m_downloadsFlashed; }
+
+    // Partitions start out filled with this so DONT_CARE regions can be told apart
+    static constexpr uint8_t m_erasedValue = 0xEE;
+
+private:
+    uint32_t m_maxDownloadSize;
+    std::deque<std::string> m_responses;
+    std::vector<std::string> m_commands;
+    std::vector<uint8_t> m_download;
+    uint64_t m_downloadRemaining = 0;
+    std::map<std::string, std::vector<uint8_t>> m_partitions;
+    std::vector<SparseChunkRecord> m_chunks;
+    std::vector<uint64_t> m_downloadSizes;
+    uint32_t m_downloadsFlashed = 0;
+
+    static uint16_t GetLE16(const uint8_t *buf)
+    {
+        return buf[0] | (buf[1] << 8);
+    }
+
+    static uint32_t GetLE32(const uint8_t *buf)
+    {
+        return buf[0] | (buf[1] << 8) | (buf[2] << 16) | (static_cast<uint32_t>(buf[3]) << 24);
+    }
+
+    bool FlashSparse(std::vector<uint8_t> &partition)
+    {
+        m_downloadSizes.push_back(m_download.size());
+
+        const uint8_t *image = m_download.data();
+        size_t size = m_download.size();
+        if (size < 28 || GetLE32(image) != 0xED26FF3A) {
+            return false;
+        }
+
+        uint16_t fileHeaderSize = GetLE16(image + 8);
+        uint16_t chunkHeaderSize = GetLE16(image + 10);
+        uint32_t blockSize = GetLE32(image + 12);
+        uint32_t totalBlocks = GetLE32(image + 16);
+        uint32_t chunkCount = GetLE32(image + 20);
+
+        uint64_t partitionSize = static_cast<uint64_t>(blockSize) * totalBlocks;
+        if (partition.empty()) {
+            partition.assign(partitionSize, m_erasedValue);
+        } else if (partition.size() != partitionSize) {
+            return false;
+        }
+
+        size_t offset = fileHeaderSize;
+        uint64_t block = 0;
+        for (uint32_t i = 0; i < chunkCount; ++i) {
+            if (offset + chunkHeaderSize > size) {
+                return false;
+            }
+            uint16_t type = GetLE16(image + offset);
+            uint32_t blocks = GetLE32(image + offset + 4);
+            uint32_t totalSize = GetLE32(image + offset + 8);
+            const uint8_t *payload = image + offset + chunkHeaderSize;
+            uint64_t length = static_cast<uint64_t>(blocks) * blockSize;
+            if (offset + totalSize > size || (block + blocks) > totalBlocks) {
+                return false;
+            }
+
+            m_chunks.push_back({type, blocks});
+            if (type == 0xCAC1) {
+                if (totalSize != chunkHeaderSize + length) {
+                    return false;
+                }
+                std::memcpy(partition.data() + block * blockSize, payload, length);
+            } else if (type == 0xCAC2) {
+                if (totalSize != chunkHeaderSize + 4u) {
+                    return false;
+                }
+                for (uint64_t j = 0; j < length; j += 4) {
+                    std::memcpy(partition.data() + block * blockSize + j, payload, 4);
+                }
+            } else if (type != 0xCAC3 || totalSize != chunkHeaderSize) {
+                return false;
+            }
+
+            block += blocks;
+            offset += totalSize;
+        }
+
+        return offset == size && block == totalBlocks;
+    }
+};
@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "nand_flash_image.hpp"
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+            ++failures; \
+        } \
+    } while (0)
+
+static constexpr uint64_t eraseBlockSize = 0x1000;
+static constexpr uint64_t pageSize = 0x200;
+static constexpr uint64_t maxRunSize = 4 * eraseBlockSize;
+static constexpr size_t maxRuns = 16;
+
+struct Write {
+    uint64_t m_offset;
+    uint64_t m_size;
+};
+
+// Single blocks of data separated by erased blocks, more runs than the command allows
+static std::vector<uint8_t> MakeImage(size_t dataBlocks)
+{
+    std::vector<uint8_t> image(2 * dataBlocks * eraseBlockSize, 0xFF);
+    for (size_t i = 0; i < dataBlocks; ++i) {
+        std::fill(image.begin() + 2 * i * eraseBlockSize, image.begin() + (2 * i + 1) * eraseBlockSize,
+            static_cast<uint8_t>(i));
+    }
+
+    return image;
+}
+
+static std::string WriteImage(const std::vector<uint8_t> &image)
+{
+    std::string path = (std::filesystem::temp_directory_path() / "astra_nand_flash_image_test.img").string();
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(image.data()), image.size());
+
+    return path;
+}
+
+// Collect the nand write commands sent after each usbload
+static std::vector<Write> ParseWrites(const std::string &command)
+{
+    std::vector<Write> writes;
+    std::istringstream stream(command);
+    std::string part;
+    while (std::getline(stream, part, ';')) {
+        std::istringstream words(part);
+        std::string nand, write, address, offset, size;
+        words >> nand >> write >> address >> offset >> size;
+        if (nand == "nand" && write == "write") {
+            writes.push_back({std::stoull(offset, nullptr, 0), std::stoull(size, nullptr, 0)});
+        }
+    }
+
+    return writes;
+}
+
+// Runs which are split to fit the load buffer still count towards the command limit
+static void TestSplitRunsWithinLimit(const std::string &path, const std::vector<uint8_t> &image)
+{
+    std::map<std::string, std::string> config = {
+        {"erase_block_size", std::to_string(eraseBlockSize)},
+        {"page_size", std::to_string(pageSize)},
+        {"max_run_size", std::to_string(maxRunSize)},
+    };
+    NandFlashImage flashImage(path, "", "", "", ASTRA_SECURE_BOOT_V2, ASTRA_MEMORY_LAYOUT_1GB, config);
+    CHECK(flashImage.Load() == 0);
+
+    std::vector<Write> writes = ParseWrites(flashImage.GetFlashCommand(false));
+    CHECK(!flashImage.GetImages().empty());
+    CHECK(flashImage.GetImages().size() <= maxRuns);
+    CHECK(writes.size() == flashImage.GetImages().size());
+
+    for (const auto &write : writes) {
+        CHECK(write.m_size <= maxRunSize);
+    }
+
+    // Every block holding data must still be written
+    for (uint64_t block = 0; block < image.size(); block += eraseBlockSize) {
+        if (image[block] == 0xFF) {
+            continue;
+        }
+
+        bool written = false;
+        for (const auto &write : writes) {
+            written |= block >= write.m_offset && block + eraseBlockSize <= write.m_offset + write.m_size;
+        }
+        CHECK(written);
+    }
+}
+
+int main()
+{
+    std::vector<uint8_t> image = MakeImage(30);
+    std::string path = WriteImage(image);
+
+    TestSplitRunsWithinLimit(path, image);
+
+    std::filesystem::remove(path);
+
+    if (failures) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "nand_flash_image_test passed" << std::endl;
+    return EXIT_SUCCESS;
+}
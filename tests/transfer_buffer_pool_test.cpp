@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2025 Synaptics Incorporated
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "transfer_buffer_pool.hpp"
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+            ++failures; \
+        } \
+    } while (0)
+
+// Without an admission limit every session gets a buffer at once
+static void TestUncapped(TransferBufferPool &pool)
+{
+    static constexpr size_t sessions = 40;
+
+    CHECK(pool.GetLimit() == 0);
+
+    std::vector<TransferBufferPool::Buffer> buffers(sessions);
+    int waiting = 0;
+    for (size_t i = 0; i < sessions; ++i) {
+        int ret = pool.Acquire(buffers[i], &buffers[i], [&waiting](TransferBufferPool::Buffer) { ++waiting; });
+        CHECK(ret == 0);
+        CHECK(buffers[i] != nullptr);
+    }
+    CHECK(pool.GetStats().m_leased == sessions);
+    CHECK(pool.GetStats().m_waiters == 0);
+
+    buffers.clear();
+    CHECK(pool.GetStats().m_leased == 0);
+    CHECK(waiting == 0);
+}
+
+// With a cap, requests queue and are handed the next returned buffer
+static void TestCapped(TransferBufferPool &pool)
+{
+    pool.SetLimit(2);
+
+    TransferBufferPool::Buffer first, second, third, handedOff;
+    CHECK(pool.Acquire(first, &first, nullptr) == 0);
+    CHECK(pool.Acquire(second, &second, nullptr) == 0);
+    CHECK(pool.Acquire(third, &third, [&handedOff](TransferBufferPool::Buffer buffer) {
+        handedOff = buffer;
+    }) == 1);
+    CHECK(pool.GetStats().m_waiters == 1);
+
+    first.reset();
+    CHECK(handedOff != nullptr);
+    CHECK(pool.GetStats().m_leased == 2);
+
+    second.reset();
+    handedOff.reset();
+    CHECK(pool.GetStats().m_leased == 0);
+
+    pool.SetLimit(0);
+}
+
+// A waiter whose session has closed drops the buffer, which goes back to the pool
+static void TestDroppedByWaiter(TransferBufferPool &pool)
+{
+    pool.SetLimit(1);
+
+    TransferBufferPool::Buffer first, second;
+    bool called = false;
+    CHECK(pool.Acquire(first, &first, nullptr) == 0);
+    CHECK(pool.Acquire(second, &second, [&called](TransferBufferPool::Buffer) { called = true; }) == 1);
+
+    first.reset();
+    CHECK(called);
+    CHECK(pool.GetStats().m_leased == 0);
+    CHECK(pool.GetStats().m_waiters == 0);
+
+    pool.SetLimit(0);
+}
+
+int main()
+{
+    TransferBufferPool &pool = TransferBufferPool::GetInstance();
+
+    TestUncapped(pool);
+    TestCapped(pool);
+    TestDroppedByWaiter(pool);
+    TestUncapped(pool);
+
+    if (failures) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "transfer_buffer_pool_test passed" << std::endl;
+    return EXIT_SUCCESS;
+}